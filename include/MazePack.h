@@ -0,0 +1,60 @@
+// Generated by tools/mazepack, do not edit.
+// 32 mazes of 16x16 picked from 100000 candidates, ordered from easiest to hardest.
+#include <Arduino.h>
+#ifndef MAZE_PACK_H
+#define MAZE_PACK_H
+
+const int MAZE_PACK_ROWS = 16;
+const int MAZE_PACK_COLUMNS = 16;
+const int MAZE_PACK_COUNT = 32;
+const int MAZE_PACK_MAZE_BYTES = 16;
+
+// Seed and solution length of each maze
+const uint32_t MAZE_PACK_SEEDS[MAZE_PACK_COUNT] PROGMEM = {
+  58467, 62176, 85120, 92037, 57944, 64310, 20888, 76310,
+  70608, 36326, 31351, 67461, 15341, 11326, 41729, 50477,
+  7755, 98794, 95667, 29171, 79388, 74945, 61622, 47855,
+  55988, 43027, 20804, 5749, 4061, 41727, 19274, 78748
+};
+const uint16_t MAZE_PACK_SOLUTION_LENGTHS[MAZE_PACK_COUNT] PROGMEM = {
+  28, 30, 32, 32, 34, 36, 36, 36, 38, 38, 40, 40, 42, 42, 44, 44,
+  46, 46, 48, 50, 50, 52, 54, 56, 58, 60, 62, 66, 70, 74, 80, 124
+};
+
+// Packed mazes, see Maze::getPackedSize for the format
+const uint8_t MAZE_PACK[MAZE_PACK_COUNT][MAZE_PACK_MAZE_BYTES] PROGMEM = {
+  {0xFE, 0x53, 0x04, 0xFB, 0x02, 0xAB, 0x7C, 0x13, 0xEC, 0x57, 0x10, 0xCF, 0x38, 0x85, 0x7E, 0x01},
+  {0xFE, 0x01, 0x6F, 0x31, 0xE6, 0x13, 0x7C, 0x47, 0x04, 0xBB, 0x6A, 0x95, 0x2D, 0xD7, 0x30, 0x09},
+  {0xFE, 0x01, 0xBF, 0x49, 0x12, 0xDB, 0x64, 0x57, 0x11, 0xFF, 0x00, 0x9F, 0x70, 0x4F, 0x9C, 0x41},
+  {0xFE, 0x33, 0x08, 0xEF, 0x30, 0x9F, 0x60, 0x3D, 0xE2, 0x1F, 0x60, 0x95, 0x5D, 0x67, 0x28, 0x09},
+  {0xFE, 0x23, 0x68, 0x0D, 0x7A, 0xB7, 0x04, 0xD7, 0x19, 0x65, 0x6E, 0x91, 0x37, 0x89, 0x7E, 0x01},
+  {0xFE, 0x11, 0x62, 0xBD, 0x29, 0xD5, 0x96, 0x37, 0x60, 0xAD, 0x19, 0x47, 0xFC, 0x53, 0x06, 0x21},
+  {0xFE, 0x05, 0x6A, 0x99, 0x36, 0x9B, 0x60, 0xD5, 0x1F, 0xE9, 0x02, 0xD3, 0x2E, 0x71, 0x96, 0x49},
+  {0xFE, 0x2B, 0x82, 0x5D, 0x39, 0xCD, 0x52, 0x35, 0x6C, 0x23, 0xC6, 0xB5, 0x39, 0x45, 0x6E, 0x11},
+  {0xFE, 0x21, 0x53, 0x4D, 0xBC, 0x43, 0x5E, 0x91, 0x36, 0xED, 0x09, 0xB5, 0x26, 0x59, 0x53, 0x49},
+  {0xFE, 0x83, 0x2C, 0x65, 0x5A, 0x8B, 0x54, 0xA7, 0x3D, 0xC5, 0x1A, 0x63, 0x8C, 0x6D, 0x5A, 0x45},
+  {0xFE, 0x01, 0x7B, 0x4D, 0x10, 0xFF, 0x05, 0xB3, 0x6E, 0x13, 0xE4, 0x97, 0x38, 0xC5, 0x2E, 0x11},
+  {0xFE, 0xA1, 0x16, 0xD5, 0x21, 0xBD, 0x4A, 0x67, 0x7C, 0x03, 0x7C, 0xA5, 0x47, 0x51, 0xBE, 0x01},
+  {0xFE, 0x41, 0x1F, 0xA1, 0x4E, 0x73, 0x24, 0xBF, 0x40, 0x7F, 0x42, 0xAB, 0x94, 0x5F, 0x70, 0x05},
+  {0xFE, 0x85, 0x30, 0x4F, 0x59, 0x6D, 0x42, 0xBD, 0xA9, 0x65, 0x4E, 0x63, 0xDC, 0x05, 0x5E, 0x41},
+  {0xFE, 0x29, 0x52, 0x9B, 0x24, 0xBB, 0x53, 0x69, 0x8E, 0x73, 0xC4, 0x2B, 0x3A, 0xCD, 0x50, 0x13},
+  {0xFE, 0x95, 0x22, 0xFD, 0x00, 0x6F, 0xD8, 0x1B, 0x66, 0x83, 0x76, 0x29, 0x5B, 0x6D, 0x82, 0x51},
+  {0xFE, 0x83, 0x34, 0xD5, 0x1A, 0xAB, 0x24, 0x53, 0xDE, 0x27, 0x68, 0xBD, 0x02, 0x5B, 0x74, 0x07},
+  {0xFE, 0x23, 0x68, 0xBD, 0x02, 0x4D, 0x7A, 0x6B, 0x85, 0xB5, 0x4A, 0xB1, 0x2E, 0x67, 0x58, 0x25},
+  {0xFE, 0x81, 0x3E, 0xCD, 0x08, 0xF7, 0x15, 0x55, 0x6A, 0x09, 0xF7, 0x19, 0x45, 0xB5, 0x3A, 0x01},
+  {0xFE, 0x29, 0x61, 0x15, 0x7E, 0x11, 0xF6, 0x55, 0x09, 0xAD, 0x72, 0xA5, 0x1D, 0xED, 0x02, 0x59},
+  {0xFE, 0x11, 0x36, 0x85, 0xD8, 0x6F, 0x24, 0x97, 0x79, 0x25, 0x5A, 0xE9, 0x17, 0xD1, 0x1E, 0x41},
+  {0xFE, 0x95, 0x20, 0xAB, 0x5E, 0x05, 0x7C, 0xA7, 0x29, 0x5D, 0xD0, 0x2F, 0x60, 0x7F, 0x82, 0x51},
+  {0xFE, 0x21, 0x57, 0x89, 0x7A, 0x17, 0xE4, 0x3B, 0x42, 0xBF, 0x40, 0x55, 0x2D, 0xD3, 0x36, 0x01},
+  {0xFE, 0x61, 0x0D, 0xA5, 0x7A, 0x45, 0x1D, 0xA5, 0x76, 0x89, 0x5A, 0x4B, 0xB5, 0x8D, 0x72, 0x09},
+  {0xFE, 0x33, 0x40, 0xAD, 0x3A, 0xA5, 0x4D, 0x55, 0x36, 0xB1, 0xC7, 0x29, 0x6E, 0xA3, 0x1C, 0x45},
+  {0xFE, 0x29, 0x41, 0xD5, 0x3E, 0x93, 0x24, 0x55, 0xDA, 0x6B, 0x45, 0x35, 0x6B, 0x35, 0xD2, 0x09},
+  {0xFE, 0x23, 0x98, 0x57, 0x64, 0x2F, 0xD8, 0x25, 0x6A, 0x2D, 0x55, 0x5B, 0xA2, 0x55, 0x54, 0x53},
+  {0xFE, 0x01, 0x6F, 0xA1, 0x3E, 0x51, 0xC6, 0x6D, 0x19, 0xD1, 0x2E, 0xD5, 0x11, 0xAF, 0x6C, 0x11},
+  {0xFE, 0x11, 0xE3, 0x29, 0x5E, 0x81, 0x7E, 0xA9, 0x03, 0x59, 0xF7, 0x19, 0x62, 0x2B, 0x5E, 0x41},
+  {0xFE, 0x15, 0xE0, 0x2B, 0x56, 0x55, 0x24, 0xFB, 0x0B, 0xC9, 0xB6, 0x75, 0x49, 0x75, 0x06, 0x21},
+  {0xFE, 0x11, 0x36, 0xAD, 0x49, 0xF7, 0x0A, 0x65, 0x9A, 0xCB, 0x2C, 0x65, 0x5A, 0x4B, 0xA4, 0x15},
+  {0xFE, 0x15, 0x61, 0xAD, 0x1A, 0x55, 0xE5, 0x59, 0x16, 0xD9, 0x23, 0x99, 0x76, 0x1B, 0xE0, 0x15}
+};
+
+#endif
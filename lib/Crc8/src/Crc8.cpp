@@ -0,0 +1,12 @@
+#include <Arduino.h>
+#include "Crc8.hpp"
+
+uint8_t crc8(uint8_t crc, const uint8_t* data, int length) {
+  for (int i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+  }
+  return crc;
+}
@@ -0,0 +1,17 @@
+#include <Arduino.h>
+#ifndef CRC8_HPP
+#define CRC8_HPP
+
+/**
+ * @brief Computes the CRC-8 (polynomial 0x07) that EEPROM records and streamed frames are
+ *        checked with.
+ * @note CRCs chain: the CRC of two blocks is crc8(crc8(0, first, ...), second, ...).
+ *
+ * @param crc The CRC of the bytes before, 0 to start.
+ * @param data The bytes to add.
+ * @param length The number of bytes.
+ * @return The CRC including the bytes.
+ */
+uint8_t crc8(uint8_t crc, const uint8_t* data, int length);
+
+#endif
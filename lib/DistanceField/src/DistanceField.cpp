@@ -0,0 +1,356 @@
+#include <Arduino.h>
+#include "DistanceField.hpp"
+
+// Steps are stored as the index of their direction, MAZE_UP is 0 and MAZE_LEFT is 3
+static uint8_t toMask(uint8_t direction) {
+  return 1 << direction;
+}
+
+static uint8_t opposite(uint8_t direction) {
+  return (direction + 2) & 3;
+}
+
+DistanceField::DistanceField(int rows, int columns) : cellRows(rows / 2), cellColumns(columns / 2) {
+  directionBytes = (cellRows * cellColumns + 3) / 4;
+  directions = new uint8_t[directionBytes];
+  for (int i = 0; i < directionBytes; i++) {
+    directions[i] = 0;
+  }
+  resetStats();
+}
+
+bool DistanceField::update(Maze& maze, MazePosition target) {
+  if (maze.isGenerating() || maze.isCollision(target.row, target.column)) {
+    return false;
+  }
+  bool isNewMaze = !isBuilt || revision != maze.getRevision();
+  if (!isNewMaze && target.row == this->target.row && target.column == this->target.column) {
+    return false;
+  }
+  this->target = target;
+  int root = findRootCell(maze, target);
+  if (root == NO_CELL) {
+    return false;
+  }
+  if (!isNewMaze && root == rootCell && (!hasLoops || getOtherRootCell(maze, target, root) == otherRootCell)) {
+    return false; // Moves between the root and its passages change no step
+  }
+
+  uint32_t startMicros = micros();
+  uint8_t direction = isNewMaze || hasLoops ? NO_DIRECTION : getEdgeDirection(maze, rootCell, root);
+  uint32_t elapsedMicros;
+  if (direction != NO_DIRECTION) {
+    // Every cell reached the old root through the new one or still reaches it, only the old root needs a step
+    setStep(rootCell, direction);
+    rootCell = root;
+    elapsedMicros = micros() - startMicros;
+    stats.updates++;
+    stats.updateMicros += elapsedMicros;
+  } else {
+    revision = maze.getRevision();
+    build(maze, root);
+    elapsedMicros = micros() - startMicros;
+    stats.rebuilds++;
+    stats.rebuildMicros += elapsedMicros;
+  }
+  if (elapsedMicros > stats.maxMicros) {
+    stats.maxMicros = elapsedMicros;
+  }
+  return true;
+}
+
+MazePosition DistanceField::getFarthestPosition(Maze& maze, MazePosition origin) {
+  if (maze.isGenerating() || maze.isCollision(origin.row, origin.column)) {
+    return origin;
+  }
+  target = origin;
+  int root = findRootCell(maze, origin);
+  if (root == NO_CELL) {
+    return origin;
+  }
+  uint32_t startMicros = micros();
+  revision = maze.getRevision();
+  build(maze, root);
+  uint32_t elapsedMicros = micros() - startMicros;
+  stats.rebuilds++;
+  stats.rebuildMicros += elapsedMicros;
+  if (elapsedMicros > stats.maxMicros) {
+    stats.maxMicros = elapsedMicros;
+  }
+  return getCellPosition(farthestCell);
+}
+
+bool DistanceField::isReady() {
+  return isBuilt;
+}
+
+uint8_t DistanceField::getDirection(Maze& maze, MazePosition position) {
+  if (!isBuilt || (position.row == target.row && position.column == target.column)) {
+    return 0;
+  }
+  uint8_t openDirections = maze.getOpenDirections(position.row, position.column);
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    MazePosition next = Maze::step(position, toMask(direction));
+    if ((openDirections & toMask(direction)) && next.row == target.row && next.column == target.column) {
+      return toMask(direction);
+    }
+  }
+
+  int cell = getCellIndex(position);
+  if (cell != NO_CELL) {
+    return cell == rootCell ? 0 : toMask(getStep(cell));
+  }
+
+  // Between two cells, head for the one whose own step does not lead back through this passage.
+  // With loops both may lead on, then the one with fewer steps left wins.
+  uint8_t bestDirection = 0;
+  int bestSteps = 0;
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    if (!(openDirections & toMask(direction))) {
+      continue;
+    }
+    int neighbour = getCellIndex(Maze::step(position, toMask(direction)));
+    if (neighbour == NO_CELL || (neighbour != rootCell && getStep(neighbour) == opposite(direction))) {
+      continue;
+    }
+    if (!hasLoops) {
+      return toMask(direction);
+    }
+    int steps = countSteps(neighbour);
+    if (bestDirection == 0 || steps < bestSteps) {
+      bestDirection = toMask(direction);
+      bestSteps = steps;
+    }
+  }
+  return bestDirection;
+}
+
+DistanceFieldStats DistanceField::getStats() {
+  return stats;
+}
+
+void DistanceField::resetStats() {
+  stats.updates = 0;
+  stats.rebuilds = 0;
+  stats.updateMicros = 0;
+  stats.rebuildMicros = 0;
+  stats.maxMicros = 0;
+}
+
+int DistanceField::getRAMBytes() {
+  return directionBytes;
+}
+
+void DistanceField::build(Maze& maze, int root) {
+  int cellCount = cellRows * cellColumns;
+  rootCell = root;
+  otherRootCell = NO_CELL;
+  farthestCell = root;
+  isBuilt = true;
+
+  // A connected maze is a tree if it has one edge less than it has cells
+  isExitEdge = true;
+  int edges = 0;
+  for (int cell = 0; cell < cellCount; cell++) {
+    edges += isEdge(maze, cell, 1) + isEdge(maze, cell, 2); // Right and down
+  }
+  hasLoops = edges >= cellCount;
+
+  // If the exit closes the only loop, the maze is a tree without it, unless that leaves a cell out
+  MazePosition end = maze.getEndPosition();
+  int exitCell = getCellIndex(Maze::step(end, MAZE_LEFT));
+  if (edges == cellCount && exitCell != NO_CELL && isEdge(maze, exitCell, 1)) {
+    isExitEdge = false;
+    hasLoops = search(maze, root) < cellCount;
+    if (!hasLoops) {
+      freeSearch();
+      return;
+    }
+    isExitEdge = true;
+  }
+  if (hasLoops) {
+    // A target between two cells is one step from both, so the search starts from both
+    otherRootCell = getOtherRootCell(maze, target, root);
+    search(maze, root);
+    return;
+  }
+  freeSearch();
+
+  // Depth-first search that backtracks along the steps it stores, so it needs no stack
+  int cell = root;
+  uint8_t direction = 0;
+  int depth = 0;
+  int farthestDepth = 0;
+  while (true) {
+    if (direction < 4) {
+      if ((cell == root || direction != getStep(cell)) && isEdge(maze, cell, direction)) {
+        int child = getNeighbourCell(cell, direction);
+        setStep(child, opposite(direction));
+        cell = child;
+        direction = 0;
+        if (++depth > farthestDepth) {
+          farthestDepth = depth;
+          farthestCell = cell;
+        }
+      } else {
+        direction++;
+      }
+      continue;
+    }
+    if (cell == root) {
+      break;
+    }
+    // Every direction of this cell is done, resume its parent after the direction leading here
+    uint8_t parentDirection = getStep(cell);
+    cell = getNeighbourCell(cell, parentDirection);
+    direction = opposite(parentDirection) + 1;
+    depth--;
+  }
+}
+
+int DistanceField::search(Maze& maze, int root) {
+  // Breadth-first search, so each step follows a shortest path despite the loops
+  int cellCount = cellRows * cellColumns;
+  if (searchQueue == nullptr) {
+    searchQueue = new uint16_t[cellCount];
+    searchReached = new uint8_t[(cellCount + 7) / 8];
+  }
+  uint16_t* queue = searchQueue;
+  uint8_t* isReached = searchReached;
+  for (int i = 0; i < (cellCount + 7) / 8; i++) {
+    isReached[i] = 0;
+  }
+  int head = 0;
+  int tail = 0;
+  queue[tail++] = root;
+  isReached[root / 8] |= 1 << (root % 8);
+  if (otherRootCell != NO_CELL) {
+    queue[tail++] = otherRootCell;
+    isReached[otherRootCell / 8] |= 1 << (otherRootCell % 8);
+  }
+  while (head < tail) {
+    int cell = queue[head++];
+    for (uint8_t direction = 0; direction < 4; direction++) {
+      if (!isEdge(maze, cell, direction)) {
+        continue;
+      }
+      int neighbour = getNeighbourCell(cell, direction);
+      if (isReached[neighbour / 8] & (1 << (neighbour % 8))) {
+        continue;
+      }
+      isReached[neighbour / 8] |= 1 << (neighbour % 8);
+      setStep(neighbour, opposite(direction));
+      queue[tail++] = neighbour;
+    }
+  }
+  // Breadth-first order, so the last cell reached is the farthest
+  farthestCell = queue[tail - 1];
+  return tail;
+}
+
+void DistanceField::freeSearch() {
+  delete[] searchQueue;
+  delete[] searchReached;
+  searchQueue = nullptr;
+  searchReached = nullptr;
+}
+
+int DistanceField::findRootCell(Maze& maze, MazePosition position) {
+  int cell = getCellIndex(position);
+  if (cell != NO_CELL) {
+    return cell;
+  }
+
+  // Between two cells, keep the root if it is one of them, else prefer the one next to the root
+  uint8_t openDirections = maze.getOpenDirections(position.row, position.column);
+  int candidate = NO_CELL;
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    if (!(openDirections & toMask(direction))) {
+      continue;
+    }
+    int neighbour = getCellIndex(Maze::step(position, toMask(direction)));
+    if (neighbour == NO_CELL) {
+      continue;
+    }
+    if (neighbour == rootCell) {
+      return neighbour;
+    }
+    if (candidate == NO_CELL || (rootCell != NO_CELL && getEdgeDirection(maze, rootCell, neighbour) != NO_DIRECTION)) {
+      candidate = neighbour;
+    }
+  }
+  return candidate;
+}
+
+int DistanceField::getOtherRootCell(Maze& maze, MazePosition position, int root) {
+  if (getCellIndex(position) != NO_CELL) {
+    return NO_CELL;
+  }
+  uint8_t openDirections = maze.getOpenDirections(position.row, position.column);
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    int neighbour = (openDirections & toMask(direction)) ? getCellIndex(Maze::step(position, toMask(direction))) : NO_CELL;
+    if (neighbour != NO_CELL && neighbour != root) {
+      return neighbour;
+    }
+  }
+  return NO_CELL;
+}
+
+int DistanceField::countSteps(int cell) {
+  // Every step leads one cell closer to a root, so this ends after at most one step per cell
+  int steps = 0;
+  while (cell != rootCell && cell != otherRootCell && steps < cellRows * cellColumns) {
+    cell = getNeighbourCell(cell, getStep(cell));
+    steps++;
+  }
+  return steps;
+}
+
+int DistanceField::getCellIndex(MazePosition position) {
+  if (position.row < 0 || position.column < 0 || !(position.row & 1) || !(position.column & 1) ||
+      (position.row >> 1) >= cellRows || (position.column >> 1) >= cellColumns) {
+    return NO_CELL;
+  }
+  return (position.row >> 1) * cellColumns + (position.column >> 1);
+}
+
+MazePosition DistanceField::getCellPosition(int cell) {
+  MazePosition position = {cell / cellColumns * 2 + 1, cell % cellColumns * 2 + 1};
+  return position;
+}
+
+bool DistanceField::isEdge(Maze& maze, int cell, uint8_t direction) {
+  MazePosition position = getCellPosition(cell);
+  if (!(maze.getOpenDirections(position.row, position.column) & toMask(direction))) {
+    return false;
+  }
+  MazePosition passage = Maze::step(position, toMask(direction));
+  MazePosition end = maze.getEndPosition();
+  if (!isExitEdge && passage.row == end.row && passage.column == end.column) {
+    return false; // The exit of an even sized maze
+  }
+  return getNeighbourCell(cell, direction) != NO_CELL;
+}
+
+uint8_t DistanceField::getEdgeDirection(Maze& maze, int fromCell, int toCell) {
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    if (getNeighbourCell(fromCell, direction) == toCell && isEdge(maze, fromCell, direction)) {
+      return direction;
+    }
+  }
+  return NO_DIRECTION;
+}
+
+int DistanceField::getNeighbourCell(int cell, uint8_t direction) {
+  MazePosition position = getCellPosition(cell);
+  return getCellIndex(Maze::step(Maze::step(position, toMask(direction)), toMask(direction)));
+}
+
+uint8_t DistanceField::getStep(int cell) {
+  return (directions[cell / 4] >> ((cell % 4) * 2)) & 3;
+}
+
+void DistanceField::setStep(int cell, uint8_t direction) {
+  uint8_t shift = (cell % 4) * 2;
+  directions[cell / 4] = (directions[cell / 4] & ~(3 << shift)) | (direction << shift);
+}
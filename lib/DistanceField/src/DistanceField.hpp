@@ -0,0 +1,138 @@
+#include <Arduino.h>
+#ifndef DISTANCE_FIELD_HPP
+#define DISTANCE_FIELD_HPP
+
+#include <Maze.hpp>
+
+/**
+ * @brief Update statistics of a distance field.
+ */
+struct DistanceFieldStats {
+  uint16_t updates;       // Target moves handled by changing a single cell
+  uint16_t rebuilds;      // Target moves, or new mazes, that rebuilt the whole field
+  uint32_t updateMicros;  // Total time spent in updates
+  uint32_t rebuildMicros; // Total time spent in rebuilds
+  uint32_t maxMicros;     // Slowest single update or rebuild
+};
+
+/**
+ * @class DistanceField
+ * @brief The shortest way from every maze cell to a moving target, e.g. the player.
+ *
+ * Instead of a distance per cell, each cell stores the direction of its next step
+ * towards the target, 2 bits per cell, which is all a chaser needs to take each step
+ * in constant time. The field is rooted at the cell of the target. In a perfect maze
+ * the cells form a tree, so when the target moves to a neighbouring cell the only
+ * step that changes is the one of the previous root, which now leads to the new root;
+ * every other cell still reaches the target through it. Mazes with loops are rebuilt
+ * with a breadth-first search whenever the target changes cell, and a chaser between two
+ * cells follows both steps to find the shorter way.
+ *
+ * The exit of an even sized maze usually closes a loop between two cells. When it is the
+ * only loop and not the only way into a cell, the field treats it as a wall so such mazes
+ * stay trees.
+ *
+ * Rebuilding visits every cell, so mazes with loops cost a search of the whole maze per
+ * move of the target. The sketch does not chase in braided mazes for that reason.
+ *
+ * Memory: 16 bytes for a 16x16 maze, 64 bytes for 32x32. Mazes with loops, and the check
+ * whether the exit closes the only loop, need 2 bytes per cell more for the search. They
+ * are allocated once and kept while the maze has loops, so moves never allocate.
+ */
+class DistanceField {
+public:
+  /**
+   * @brief Constructs an empty distance field.
+   * @param rows Number of rows in the maze.
+   * @param columns Number of columns in the maze.
+   */
+  DistanceField(int rows, int columns);
+
+  /**
+   * @brief Follows the target to its current position.
+   * @note Call this every frame, it returns immediately unless the target changed cell or
+   *       the maze changed.
+   *
+   * @param maze The maze the target is in.
+   * @param target The position of the target.
+   * @return True if the field changed, false otherwise.
+   */
+  bool update(Maze& maze, MazePosition target);
+
+  /**
+   * @brief Rebuilds the field towards a position and finds the cell farthest from it.
+   * @note This costs a full rebuild, call it when a maze or a run starts rather than every frame.
+   *
+   * @param maze The maze the position is in.
+   * @param origin An open position of the maze, which becomes the target.
+   * @return The cell with the most steps to the origin, or the origin if it is not open.
+   */
+  MazePosition getFarthestPosition(Maze& maze, MazePosition origin);
+
+  /**
+   * @brief Checks if the field has been built for a maze.
+   * @return True if the field can be followed, false otherwise.
+   */
+  bool isReady();
+
+  /**
+   * @brief Gets the first step of a shortest path from a position to the target.
+   * @param maze The maze the field was built from.
+   * @param position An open position of the maze.
+   * @return MAZE_UP, MAZE_RIGHT, MAZE_DOWN or MAZE_LEFT, 0 at the target.
+   */
+  uint8_t getDirection(Maze& maze, MazePosition position);
+
+  /**
+   * @brief Gets the update statistics.
+   * @return The update statistics.
+   */
+  DistanceFieldStats getStats();
+
+  /**
+   * @brief Resets the update statistics.
+   */
+  void resetStats();
+
+  /**
+   * @brief Gets the number of bytes of RAM used by the field.
+   * @return The RAM used in bytes.
+   */
+  int getRAMBytes();
+
+private:
+  static const int NO_CELL = -1;
+  static const uint8_t NO_DIRECTION = 0xFF;
+
+  int cellRows;
+  int cellColumns;
+  int directionBytes;
+  uint8_t* directions; // 2 bits per cell, the index of the direction to step in
+  uint16_t* searchQueue = nullptr; // Breadth-first search buffers, only while they are needed
+  uint8_t* searchReached = nullptr;
+  int rootCell = NO_CELL;
+  int otherRootCell = NO_CELL; // With loops, the second cell next to a target between two cells
+  int farthestCell = NO_CELL;  // The cell with the most steps to the root in the last build
+  MazePosition target = {-1, -1};
+  uint16_t revision = 0;
+  bool isBuilt = false;
+  bool hasLoops = false;
+  bool isExitEdge = true; // False while the exit of an even sized maze is treated as a wall
+  DistanceFieldStats stats;
+
+  void build(Maze& maze, int root);
+  int search(Maze& maze, int root);
+  void freeSearch();
+  int findRootCell(Maze& maze, MazePosition position);
+  int getOtherRootCell(Maze& maze, MazePosition position, int root);
+  int countSteps(int cell);
+  int getCellIndex(MazePosition position);
+  MazePosition getCellPosition(int cell);
+  bool isEdge(Maze& maze, int cell, uint8_t direction);
+  uint8_t getEdgeDirection(Maze& maze, int fromCell, int toCell);
+  int getNeighbourCell(int cell, uint8_t direction);
+  uint8_t getStep(int cell);
+  void setStep(int cell, uint8_t direction);
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "FogOfWar.hpp"
+
+FogOfWar::FogOfWar(int rows, int columns, int eepromAddress) : mazeRows(rows), mazeColumns(columns), eepromAddress(eepromAddress) {
+  bitmapBytes = ((long)mazeRows * mazeColumns + 7) / 8;
+  bitmap = new uint8_t[bitmapBytes];
+  dirtyBytes = new uint8_t[(bitmapBytes + 7) / 8];
+  for (int i = 0; i < bitmapBytes; i++) {
+    bitmap[i] = 0;
+  }
+  for (int i = 0; i < (bitmapBytes + 7) / 8; i++) {
+    dirtyBytes[i] = 0;
+  }
+}
+
+void FogOfWar::reset(Maze& maze) {
+  for (int i = 0; i < bitmapBytes; i++) {
+    bitmap[i] = 0;
+  }
+  for (int i = 0; i < (bitmapBytes + 7) / 8; i++) {
+    dirtyBytes[i] = 0xFF;
+  }
+  mazeKey = maze.calculateKey();
+  isHeaderDirty = true;
+  isHeaderCleared = false;
+  isKeyWritten = false;
+  // A commit in progress would write the header before the bytes behind it, start over
+  isCommitting = false;
+}
+
+bool FogOfWar::loadFromEEPROM(Maze& maze) {
+  mazeKey = maze.calculateKey();
+  if (EEPROM.read(eepromAddress) != FOG_MAGIC || EEPROM.read(eepromAddress + 1) != mazeKey) {
+    return false;
+  }
+  for (int i = 0; i < bitmapBytes; i++) {
+    bitmap[i] = EEPROM.read(eepromAddress + HEADER_BYTES + i);
+  }
+  return true;
+}
+
+void FogOfWar::reveal(Maze& maze, MazePosition position, int viewDistance) {
+  for (int i = -1; i <= 1; i++) {
+    for (int j = -1; j <= 1; j++) {
+      markSeen(position.row + i, position.column + j);
+    }
+  }
+
+  // Look down each corridor until a wall blocks the view
+  const int directionRows[4] = {-1, 0, 1, 0};
+  const int directionColumns[4] = {0, 1, 0, -1};
+  for (int d = 0; d < 4; d++) {
+    int row = position.row;
+    int column = position.column;
+    for (int step = 1; step <= viewDistance; step++) {
+      row += directionRows[d];
+      column += directionColumns[d];
+      markSeen(row, column);
+      if (maze.isCollision(row, column)) {
+        break;
+      }
+      // The walls on either side of the corridor are visible too
+      markSeen(row + directionColumns[d], column + directionRows[d]);
+      markSeen(row - directionColumns[d], column - directionRows[d]);
+    }
+  }
+}
+
+bool FogOfWar::isSeen(int row, int column) {
+  if (row < 0 || row >= mazeRows || column < 0 || column >= mazeColumns) {
+    return false;
+  }
+  long index = (long)row * mazeColumns + column;
+  return (bitmap[index / 8] >> (index % 8)) & 1;
+}
+
+void FogOfWar::persist(uint32_t currentTime, uint32_t commitInterval, int maxBytes) {
+  if (!isCommitting) {
+    if (currentTime - lastCommitTime < commitInterval) {
+      return;
+    }
+    bool isAnyByteDirty = false;
+    for (int i = 0; i < (bitmapBytes + 7) / 8 && !isAnyByteDirty; i++) {
+      isAnyByteDirty = dirtyBytes[i] != 0;
+    }
+    if (!isAnyByteDirty && !isHeaderDirty) {
+      return;
+    }
+    isCommitting = true;
+    nextDirtyByte = 0;
+    lastCommitTime = currentTime;
+  }
+
+  int written = 0;
+  if (isHeaderDirty && !isHeaderCleared && written < maxBytes) {
+    writeByte(0, 0);
+    isHeaderCleared = true;
+    written++;
+  }
+
+  while (nextDirtyByte < bitmapBytes && written < maxBytes) {
+    uint8_t& dirty = dirtyBytes[nextDirtyByte / 8];
+    uint8_t mask = 1 << (nextDirtyByte % 8);
+    if (dirty & mask) {
+      writeByte(HEADER_BYTES + nextDirtyByte, bitmap[nextDirtyByte]);
+      dirty &= ~mask;
+      written++;
+    }
+    nextDirtyByte++;
+  }
+  // The header counts against the budget like the bitmap, the magic byte goes last
+  if (nextDirtyByte >= bitmapBytes && isHeaderDirty && !isKeyWritten && written < maxBytes) {
+    writeByte(1, mazeKey);
+    isKeyWritten = true;
+    written++;
+  }
+  if (nextDirtyByte >= bitmapBytes && isHeaderDirty && isKeyWritten && written < maxBytes) {
+    writeByte(0, FOG_MAGIC);
+    isHeaderDirty = false;
+  }
+  if (nextDirtyByte >= bitmapBytes && !isHeaderDirty) {
+    isCommitting = false;
+  }
+}
+
+int FogOfWar::getRAMBytes() {
+  return bitmapBytes + (bitmapBytes + 7) / 8;
+}
+
+int FogOfWar::getEEPROMBytes() {
+  return HEADER_BYTES + bitmapBytes;
+}
+
+uint32_t FogOfWar::getEEPROMWrites() {
+  return eepromWrites;
+}
+
+void FogOfWar::markSeen(int row, int column) {
+  if (row < 0 || row >= mazeRows || column < 0 || column >= mazeColumns) {
+    return;
+  }
+  long index = (long)row * mazeColumns + column;
+  uint8_t mask = 1 << (index % 8);
+  if (!(bitmap[index / 8] & mask)) {
+    bitmap[index / 8] |= mask;
+    dirtyBytes[index / 64] |= 1 << ((index / 8) % 8);
+  }
+}
+
+void FogOfWar::writeByte(int offset, uint8_t value) {
+  // Like EEPROM.update, skip the write and the wear if the byte is unchanged, but count the writes made
+  if (EEPROM.read(eepromAddress + offset) != value) {
+    EEPROM.write(eepromAddress + offset, value);
+    eepromWrites++;
+  }
+}
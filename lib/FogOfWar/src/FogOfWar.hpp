@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#ifndef FOG_OF_WAR_HPP
+#define FOG_OF_WAR_HPP
+
+#include <Maze.hpp>
+
+/**
+ * @class FogOfWar
+ * @brief Tracks which maze cells the player has seen and persists them.
+ *
+ * Seen cells are kept in a bitmap with one bit per cell. The bitmap is saved to
+ * EEPROM in small batches: only bytes that changed since the last commit are
+ * written, at most a few per frame, so a power cycle resumes the run without
+ * ever stalling the game on EEPROM writes.
+ *
+ * Budgets per maze size (RAM = bitmap + dirty flags, EEPROM = header + bitmap):
+ *   16x16:  32 + 4 bytes RAM,  34 bytes EEPROM
+ *   32x32: 128 + 16 bytes RAM, 130 bytes EEPROM
+ *   64x64: 512 + 64 bytes RAM, 514 bytes EEPROM
+ * Each commit writes only the bitmap bytes changed since the previous commit,
+ * every EEPROM byte is rewritten at most once per commit.
+ *
+ * The header holds a CRC of the walls of the maze the fog belongs to, so a saved fog
+ * is only loaded into the same maze. After a reset the first commit clears the header
+ * and writes it back last, so a cleared bitmap cut short by a power cycle is not loaded.
+ */
+class FogOfWar {
+public:
+  /**
+   * @brief Constructs a fog of war with no cells seen.
+   * @param rows Number of rows in the maze.
+   * @param columns Number of columns in the maze.
+   * @param eepromAddress The EEPROM address the fog of war is saved at.
+   */
+  FogOfWar(int rows, int columns, int eepromAddress);
+
+  /**
+   * @brief Hides all cells, e.g. after a new maze has been generated.
+   * @note The cleared bitmap is saved by the following calls to persist.
+   *
+   * @param maze The maze the fog of war now belongs to.
+   */
+  void reset(Maze& maze);
+
+  /**
+   * @brief Loads the seen cells from EEPROM.
+   * @param maze The maze the fog of war must belong to.
+   * @return True if a fog of war was saved for this maze, false otherwise.
+   */
+  bool loadFromEEPROM(Maze& maze);
+
+  /**
+   * @brief Marks the cells visible from a position as seen.
+   * @note Visible cells are the neighbours of the position and every cell in a straight
+   *       line along open corridors, including the walls that bound them.
+   *
+   * @param maze The maze the player is in.
+   * @param position The position of the player.
+   * @param viewDistance The maximum distance to see along a corridor.
+   */
+  void reveal(Maze& maze, MazePosition position, int viewDistance);
+
+  /**
+   * @brief Checks if a cell has been seen. Out of bounds cells have never been seen.
+   * @param row The row of the cell.
+   * @param column The column of the cell.
+   * @return True if the cell has been seen, false otherwise.
+   */
+  bool isSeen(int row, int column);
+
+  /**
+   * @brief Writes pending changes to EEPROM.
+   * @note Call this every frame, it returns immediately unless a commit is due.
+   *
+   * @param currentTime The current time in milliseconds.
+   * @param commitInterval The minimum time between two commits in milliseconds.
+   * @param maxBytes The maximum number of bytes to write in this call.
+   */
+  void persist(uint32_t currentTime, uint32_t commitInterval, int maxBytes);
+
+  /**
+   * @brief Gets the number of bytes of RAM used by the fog of war.
+   * @return The RAM used in bytes.
+   */
+  int getRAMBytes();
+
+  /**
+   * @brief Gets the number of bytes of EEPROM used by the fog of war.
+   * @return The EEPROM used in bytes.
+   */
+  int getEEPROMBytes();
+
+  /**
+   * @brief Gets the number of EEPROM bytes written since startup.
+   * @return The number of EEPROM bytes written.
+   */
+  uint32_t getEEPROMWrites();
+
+private:
+  int mazeRows;
+  int mazeColumns;
+  int eepromAddress;
+  int bitmapBytes;
+  uint8_t* bitmap;
+  uint8_t* dirtyBytes; // One bit per bitmap byte changed since the last commit
+  uint8_t mazeKey = 0;
+  bool isHeaderDirty = false;   // The header must be written at the end of the commit
+  bool isHeaderCleared = false; // The old header was cleared by the commit after a reset
+  bool isKeyWritten = false;    // The maze key of the new header was written, the magic byte is next
+  bool isCommitting = false;
+  int nextDirtyByte = 0;
+  uint32_t lastCommitTime = 0;
+  uint32_t eepromWrites = 0;
+
+  static const uint8_t FOG_MAGIC = 0xF0;
+  static const int HEADER_BYTES = 2; // Magic byte, maze key
+
+  void markSeen(int row, int column);
+  void writeByte(int offset, uint8_t value);
+};
+
+#endif
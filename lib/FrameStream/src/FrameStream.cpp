@@ -0,0 +1,117 @@
+#include <Arduino.h>
+#include <Crc8.hpp>
+#include "FrameStream.hpp"
+
+void FrameStream::service(Maze& maze, MazePosition playerPosition) {
+  if (isGoalPending) {
+    uint8_t payload[4] = {(uint8_t)(goalMoves & 0xFF), (uint8_t)(goalMoves >> 8), (uint8_t)(goalSeconds & 0xFF),
+                          (uint8_t)(goalSeconds >> 8)};
+    if (!sendFrame(FRAME_GOAL, payload, sizeof(payload))) {
+      return;
+    }
+    isGoalPending = false;
+  }
+
+  // A maze is only sent complete, a new one restarts the maze being sent
+  if (maze.isGenerating()) {
+    return;
+  }
+  if (!isMazeSent || maze.getRevision() != sentRevision) {
+    if (nextRow == IDLE || maze.getRevision() != sentRevision) {
+      nextRow = MAZE_START;
+      sentRevision = maze.getRevision();
+      isMazeSent = false;
+    }
+    while (nextRow != IDLE) {
+      if (!sendMazeFrame(maze)) {
+        return;
+      }
+    }
+    isMazeSent = true;
+    sentPlayer.row = -1; // The viewer puts the player at the start of a new maze, send it anyway
+  }
+
+  if (playerPosition.row != sentPlayer.row || playerPosition.column != sentPlayer.column) {
+    uint8_t payload[2] = {(uint8_t)playerPosition.row, (uint8_t)playerPosition.column};
+    if (sendFrame(FRAME_PLAYER, payload, sizeof(payload))) {
+      sentPlayer = playerPosition;
+    }
+  }
+}
+
+void FrameStream::sendGoalReached(uint16_t moves, uint16_t seconds) {
+  goalMoves = moves;
+  goalSeconds = seconds;
+  isGoalPending = true;
+}
+
+uint32_t FrameStream::getBytesSent() {
+  return bytesSent;
+}
+
+bool FrameStream::sendMazeFrame(Maze& maze) {
+  uint8_t payload[MAX_PAYLOAD_BYTES];
+  if (nextRow == MAZE_START) {
+    MazePosition start = maze.getStartPosition();
+    MazePosition end = maze.getEndPosition();
+    uint32_t seed = maze.getSeed();
+    payload[0] = maze.getRows();
+    payload[1] = maze.getColumns();
+    for (uint8_t i = 0; i < 4; i++) {
+      payload[2 + i] = seed >> (8 * i);
+    }
+    payload[6] = start.row;
+    payload[7] = start.column;
+    payload[8] = end.row;
+    payload[9] = end.column;
+    if (!sendFrame(FRAME_MAZE_START, payload, 10)) {
+      return false;
+    }
+    mazeCrc = 0;
+    nextRow = 0;
+    return true;
+  }
+
+  if (nextRow >= maze.getRows()) {
+    if (!sendFrame(FRAME_MAZE_END, &mazeCrc, 1)) {
+      return false;
+    }
+    nextRow = IDLE;
+    return true;
+  }
+
+  // One bit per column, least significant bit first
+  uint8_t length = 1 + (maze.getColumns() + 7) / 8;
+  payload[0] = nextRow;
+  for (uint8_t i = 1; i < length; i++) {
+    payload[i] = 0;
+  }
+  for (int j = 0; j < maze.getColumns(); j++) {
+    if (maze.isCollision(nextRow, j)) {
+      payload[1 + j / 8] |= 1 << (j % 8);
+    }
+  }
+  if (!sendFrame(FRAME_MAZE_ROW, payload, length)) {
+    return false;
+  }
+  mazeCrc = crc8(mazeCrc, payload, length);
+  nextRow++;
+  return true;
+}
+
+bool FrameStream::sendFrame(uint8_t type, const uint8_t* payload, uint8_t length) {
+  // Frames are written whole or not at all, so they never wait for the serial port
+  uint8_t frameLength = HEADER_BYTES + length + 1;
+  if (Serial.availableForWrite() < frameLength) {
+    return false;
+  }
+  uint8_t frame[HEADER_BYTES + MAX_PAYLOAD_BYTES + 1];
+  frame[0] = FRAME_SYNC;
+  frame[1] = type;
+  frame[2] = length;
+  memcpy(&frame[HEADER_BYTES], payload, length);
+  frame[HEADER_BYTES + length] = crc8(0, &frame[1], length + 2);
+  Serial.write(frame, frameLength);
+  bytesSent += frameLength;
+  return true;
+}
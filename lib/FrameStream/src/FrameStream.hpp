@@ -0,0 +1,80 @@
+#include <Arduino.h>
+#ifndef FRAME_STREAM_HPP
+#define FRAME_STREAM_HPP
+
+#include <Maze.hpp>
+
+/**
+ * @brief The types of the frames sent by a FrameStream.
+ */
+enum FrameType : uint8_t {
+  FRAME_MAZE_START = 1, // rows, columns, seed (4 bytes), start row and column, end row and column
+  FRAME_MAZE_ROW = 2,   // row, then one bit per column, 1 for a wall, least significant bit first
+  FRAME_MAZE_END = 3,   // CRC-8 of the payloads of every row frame, in order
+  FRAME_PLAYER = 4,     // row, column
+  FRAME_GOAL = 5        // moves (2 bytes), seconds (2 bytes)
+};
+
+/**
+ * @class FrameStream
+ * @brief Streams the maze and the moves of the player to a host viewer as binary frames.
+ *
+ * Every frame is FRAME_SYNC, its type, the length of its payload, the payload, and a
+ * CRC-8 over the type, length and payload, so a viewer finds frames again after text
+ * or lost bytes. Multi-byte values are little endian. A new maze is sent once, a row per
+ * frame followed by a checksum of all rows, then each move costs a single 6 byte frame
+ * instead of a reprint of the whole maze.
+ *
+ * Frames are only written whole and only when the serial TX buffer has room for them,
+ * so the stream never blocks. A player that moves again before its last position was
+ * sent is sent once, at its latest position.
+ *
+ * Positions and sizes are single bytes, so mazes up to 255x255 can be streamed.
+ */
+class FrameStream {
+public:
+  static const uint8_t FRAME_SYNC = 0xA5;
+  static const uint8_t HEADER_BYTES = 3; // Sync, type and payload length
+  static const uint8_t MAX_PAYLOAD_BYTES = 33; // A row frame of a 255 column maze
+
+  /**
+   * @brief Sends what changed since the last call, as far as the serial port has room.
+   * @note Call this every frame. A maze being generated is sent once it is complete.
+   *
+   * @param maze The maze being played.
+   * @param playerPosition The position of the player.
+   */
+  void service(Maze& maze, MazePosition playerPosition);
+
+  /**
+   * @brief Queues a goal reached frame, sent before the next maze.
+   * @param moves The moves made in the maze.
+   * @param seconds The time spent in the maze in seconds.
+   */
+  void sendGoalReached(uint16_t moves, uint16_t seconds);
+
+  /**
+   * @brief Gets the number of bytes sent since startup.
+   * @return The number of bytes sent.
+   */
+  uint32_t getBytesSent();
+
+private:
+  static const int IDLE = -2;       // No maze is being sent
+  static const int MAZE_START = -1; // The start frame of a maze is next
+
+  uint16_t sentRevision = 0;
+  bool isMazeSent = false;
+  int nextRow = IDLE;
+  uint8_t mazeCrc = 0;
+  MazePosition sentPlayer = {-1, -1};
+  bool isGoalPending = false;
+  uint16_t goalMoves = 0;
+  uint16_t goalSeconds = 0;
+  uint32_t bytesSent = 0;
+
+  bool sendMazeFrame(Maze& maze);
+  bool sendFrame(uint8_t type, const uint8_t* payload, uint8_t length);
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Crc8.hpp>
+#include "GameJournal.hpp"
+
+GameJournal::GameJournal(int eepromAddress, int halfSize) : eepromAddress(eepromAddress), halfSize(halfSize) {
+  deltaCapacity = (halfSize - SNAPSHOT_BYTES) / DELTA_BYTES;
+}
+
+bool GameJournal::recover(GameState& state, uint8_t mazeKey) {
+  GameState states[2];
+  uint8_t epochs[2];
+  bool isValid[2];
+  for (uint8_t half = 0; half < 2; half++) {
+    isValid[half] = readSnapshot(half, states[half], epochs[half]);
+  }
+  if (!isValid[0] && !isValid[1]) {
+    return false;
+  }
+
+  // The newest snapshot wins, epochs wrap around so compare their difference
+  if (isValid[0] && isValid[1]) {
+    activeHalf = (int8_t)(epochs[1] - epochs[0]) > 0 ? 1 : 0;
+  } else {
+    activeHalf = isValid[0] ? 0 : 1;
+  }
+  epoch = epochs[activeHalf];
+  state = states[activeHalf];
+  bool isSameMaze = state.mazeKey == mazeKey;
+
+  // Replay deltas until the first torn or stale record
+  deltaCount = 0;
+  while (deltaCount < deltaCapacity) {
+    uint8_t delta[DELTA_BYTES];
+    int address = halfAddress(activeHalf) + SNAPSHOT_BYTES + deltaCount * DELTA_BYTES;
+    for (int i = 0; i < DELTA_BYTES; i++) {
+      delta[i] = EEPROM.read(address + i);
+    }
+    uint8_t header[2] = {epoch, (uint8_t)deltaCount};
+    uint8_t crc = crc8(crc8(0, header, 2), delta, DELTA_BYTES - 1);
+    if (crc != delta[DELTA_BYTES - 1]) {
+      break;
+    }
+    state.playerPosition.row = delta[0];
+    state.playerPosition.column = delta[1];
+    state.moves += delta[2];
+    state.elapsedSeconds += delta[3];
+    deltaCount++;
+  }
+  journaledState = state;
+  return isSameMaze;
+}
+
+void GameJournal::reset(const GameState& state) {
+  // A snapshot still being written has not made its half valid yet, so overwrite it
+  // instead of moving on to the other half, which holds the last complete snapshot
+  if (!(isPendingSnapshot && pendingWritten < pendingLength)) {
+    activeHalf = 1 - activeHalf;
+    epoch++;
+  }
+
+  pending[0] = SNAPSHOT_MAGIC;
+  pending[1] = epoch;
+  pending[2] = state.playerPosition.row;
+  pending[3] = state.playerPosition.column;
+  pending[4] = state.moves & 0xFF;
+  pending[5] = state.moves >> 8;
+  pending[6] = state.elapsedSeconds & 0xFF;
+  pending[7] = state.elapsedSeconds >> 8;
+  pending[8] = state.mazeKey;
+  pending[9] = crc8(0, pending, SNAPSHOT_BYTES - 1);
+  pendingAddress = halfAddress(activeHalf);
+  pendingLength = SNAPSHOT_BYTES;
+  pendingWritten = 0;
+  isPendingSnapshot = true;
+  invalidateDelta(0);
+
+  deltaCount = 0;
+  journaledState = state;
+}
+
+void GameJournal::record(const GameState& state, uint32_t currentTime, uint32_t recordInterval) {
+  if (pendingWritten < pendingLength || currentTime - lastRecordTime < recordInterval) {
+    return;
+  }
+  if (state.playerPosition.row == journaledState.playerPosition.row &&
+      state.playerPosition.column == journaledState.playerPosition.column &&
+      state.moves == journaledState.moves) {
+    // Time alone passing is not worth the EEPROM wear, it is recorded with the next move
+    return;
+  }
+  lastRecordTime = currentTime;
+
+  if (deltaCount >= deltaCapacity) {
+    reset(state);
+    return;
+  }
+
+  // Deltas larger than a byte are carried over to the next record
+  uint16_t moves = min(state.moves - journaledState.moves, 255);
+  uint16_t elapsedSeconds = min(state.elapsedSeconds - journaledState.elapsedSeconds, 255);
+  pending[0] = state.playerPosition.row;
+  pending[1] = state.playerPosition.column;
+  pending[2] = moves;
+  pending[3] = elapsedSeconds;
+  uint8_t header[2] = {epoch, (uint8_t)deltaCount};
+  pending[4] = crc8(crc8(0, header, 2), pending, DELTA_BYTES - 1);
+  pendingAddress = halfAddress(activeHalf) + SNAPSHOT_BYTES + deltaCount * DELTA_BYTES;
+  pendingLength = DELTA_BYTES;
+  pendingWritten = 0;
+  isPendingSnapshot = false;
+  invalidateDelta(deltaCount + 1);
+
+  deltaCount++;
+  journaledState.playerPosition = state.playerPosition;
+  journaledState.moves += moves;
+  journaledState.elapsedSeconds += elapsedSeconds;
+}
+
+void GameJournal::service(int maxBytes) {
+  int n = 0;
+  if (terminatorAddress >= 0 && maxBytes > 0) {
+    if (EEPROM.read(terminatorAddress) != terminator) {
+      EEPROM.write(terminatorAddress, terminator);
+      eepromWrites++;
+    }
+    terminatorAddress = -1;
+    n++;
+  }
+  // The CRC is the last byte written, so a record torn by a power cut never validates
+  for (; n < maxBytes && pendingWritten < pendingLength; n++, pendingWritten++) {
+    int address = pendingAddress + pendingWritten;
+    if (EEPROM.read(address) != pending[pendingWritten]) {
+      EEPROM.write(address, pending[pendingWritten]);
+      eepromWrites++;
+    }
+  }
+}
+
+uint32_t GameJournal::getEEPROMWrites() {
+  return eepromWrites;
+}
+
+int GameJournal::halfAddress(uint8_t half) {
+  return eepromAddress + half * halfSize;
+}
+
+void GameJournal::invalidateDelta(int index) {
+  if (index >= deltaCapacity) {
+    terminatorAddress = -1;
+    return;
+  }
+  // Whatever the slot holds from an earlier use of the half, its CRC is made not to match it
+  terminatorAddress = halfAddress(activeHalf) + SNAPSHOT_BYTES + index * DELTA_BYTES;
+  uint8_t delta[DELTA_BYTES - 1];
+  for (int i = 0; i < DELTA_BYTES - 1; i++) {
+    delta[i] = EEPROM.read(terminatorAddress + i);
+  }
+  uint8_t header[2] = {epoch, (uint8_t)index};
+  terminator = crc8(crc8(0, header, 2), delta, DELTA_BYTES - 1) ^ 0xFF;
+  terminatorAddress += DELTA_BYTES - 1;
+}
+
+bool GameJournal::readSnapshot(uint8_t half, GameState& state, uint8_t& snapshotEpoch) {
+  uint8_t snapshot[SNAPSHOT_BYTES];
+  for (int i = 0; i < SNAPSHOT_BYTES; i++) {
+    snapshot[i] = EEPROM.read(halfAddress(half) + i);
+  }
+  if (snapshot[0] != SNAPSHOT_MAGIC || crc8(0, snapshot, SNAPSHOT_BYTES - 1) != snapshot[SNAPSHOT_BYTES - 1]) {
+    return false;
+  }
+  snapshotEpoch = snapshot[1];
+  state.playerPosition.row = snapshot[2];
+  state.playerPosition.column = snapshot[3];
+  state.moves = snapshot[4] | (snapshot[5] << 8);
+  state.elapsedSeconds = snapshot[6] | (snapshot[7] << 8);
+  state.mazeKey = snapshot[8];
+  return true;
+}
@@ -0,0 +1,123 @@
+#include <Arduino.h>
+#ifndef GAME_JOURNAL_HPP
+#define GAME_JOURNAL_HPP
+
+#include <Maze.hpp>
+
+/**
+ * @brief The game state that survives a power cycle.
+ */
+struct GameState {
+  MazePosition playerPosition;
+  uint16_t moves;
+  uint16_t elapsedSeconds;
+  uint8_t mazeKey; // Maze::calculateKey of the maze played, kept in snapshots only
+};
+
+/**
+ * @class GameJournal
+ * @brief An append-only journal of the game state in EEPROM.
+ *
+ * The journal region is split into two halves used in turn. Each half starts
+ * with a snapshot of the full state followed by small delta records. When the
+ * active half is full, or a new maze is started, the journal is compacted into
+ * a snapshot at the start of the other half, whose epoch is one higher. Every
+ * record ends with a CRC over its contents, its epoch and its index, so torn
+ * writes and stale records from an earlier use of a half are ignored, and the
+ * previous half stays valid until the new snapshot is complete. Before a
+ * record is written, the CRC of the delta slot after it is overwritten with a
+ * value that cannot match, so a stale delta left there never extends the journal.
+ *
+ * Recovery reads both snapshots and the deltas of the newest half, at most
+ * 2 * SNAPSHOT_BYTES + halfSize bytes, and writes nothing.
+ *
+ * Snapshots hold the key of the maze, so a state journaled in another maze, e.g. before
+ * a new maze was generated or loaded from a pack, is not recovered into this one.
+ *
+ * Wear: every byte of a half is written at most once per cycle through both
+ * halves, the CRC bytes of the deltas twice. With 64 byte halves (10 deltas each)
+ * and one record every 5 seconds of continuous play, a cycle takes about 2 minutes,
+ * so the 100000 write cycles EEPROM cells are rated for last over 2 months of
+ * non-stop play.
+ */
+class GameJournal {
+public:
+  static const int SNAPSHOT_BYTES = 10;
+  static const int DELTA_BYTES = 5;
+
+  /**
+   * @brief Constructs a journal.
+   * @param eepromAddress The EEPROM address of the journal region.
+   * @param halfSize The size in bytes of each of the two halves of the region.
+   */
+  GameJournal(int eepromAddress, int halfSize);
+
+  /**
+   * @brief Recovers the last recorded game state from EEPROM.
+   * @note Call this once at startup, before anything is recorded.
+   *
+   * @param state Receives the recovered state.
+   * @param mazeKey The key of the maze the state must belong to.
+   * @return True if a state was recovered, false if the journal is empty, corrupt or
+   *         belongs to another maze.
+   */
+  bool recover(GameState& state, uint8_t mazeKey);
+
+  /**
+   * @brief Starts the journal over from a new state, e.g. when a new maze starts.
+   * @param state The state to snapshot.
+   */
+  void reset(const GameState& state);
+
+  /**
+   * @brief Records the current game state.
+   * @note Call this every frame. A delta is appended at most once per interval,
+   *       and only if the state changed since the last record.
+   *
+   * @param state The current game state.
+   * @param currentTime The current time in milliseconds.
+   * @param recordInterval The minimum time between two records in milliseconds.
+   */
+  void record(const GameState& state, uint32_t currentTime, uint32_t recordInterval);
+
+  /**
+   * @brief Writes the pending record to EEPROM a few bytes at a time.
+   * @note Call this every frame so no frame blocks on more than maxBytes EEPROM writes.
+   * @param maxBytes The maximum number of bytes to write in this call.
+   */
+  void service(int maxBytes);
+
+  /**
+   * @brief Gets the number of EEPROM bytes written since startup.
+   * @return The number of EEPROM bytes written.
+   */
+  uint32_t getEEPROMWrites();
+
+private:
+  int eepromAddress;
+  int halfSize;
+  int deltaCapacity;
+  uint8_t activeHalf = 0;
+  uint8_t epoch = 0;
+  int deltaCount = 0;
+  GameState journaledState = {{0, 0}, 0, 0, 0};
+  uint32_t lastRecordTime = 0;
+  uint32_t eepromWrites = 0;
+
+  // The record being written, a few bytes per frame
+  uint8_t pending[SNAPSHOT_BYTES];
+  int pendingAddress = 0;
+  int pendingLength = 0;
+  int pendingWritten = 0;
+  bool isPendingSnapshot = false;
+  int terminatorAddress = -1; // The CRC of the delta slot after the pending record, -1 if none
+  uint8_t terminator = 0;
+
+  static const uint8_t SNAPSHOT_MAGIC = 0x4A;
+
+  int halfAddress(uint8_t half);
+  void invalidateDelta(int index);
+  bool readSnapshot(uint8_t half, GameState& state, uint8_t& snapshotEpoch);
+};
+
+#endif
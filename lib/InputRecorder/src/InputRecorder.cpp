@@ -0,0 +1,473 @@
+#include <Arduino.h>
+#include "InputRecorder.hpp"
+
+// Record headers. A sample is 0XYCZjjj: X and Y set if the axis changed, followed by its delta,
+// C and Z the buttons, jjj the time past the expected poll interval, 7 if it follows as a varint.
+// A step is 1000rrcc with rr and cc the row and column change plus one, followed by the time.
+// The other records are followed by the time since the previous record, except lost polls,
+// which are timed from the previous poll like samples.
+static const uint8_t SAMPLE_X_CHANGED = 0x40;
+static const uint8_t SAMPLE_Y_CHANGED = 0x20;
+static const uint8_t SAMPLE_BUTTON_C = 0x10;
+static const uint8_t SAMPLE_BUTTON_Z = 0x08;
+static const uint8_t SAMPLE_JITTER_MASK = 0x07;
+static const uint8_t STEP_HEADER = 0x80;
+static const uint8_t POSITION_HEADER = 0x90; // Followed by the time, row and column
+static const uint8_t TICK_HEADER = 0x91;
+static const uint8_t SETTLED_HEADER = 0x92;
+static const uint8_t LOST_HEADER = 0x93;
+static const uint8_t START_HEADER = 0xA0; // See InputRecorder::start for the fields
+static const uint8_t START_TRUNCATED_HEADER = 0xA1;
+
+/**
+ * @brief Gets the number of bytes a value takes as a varint, 7 bits per byte.
+ * @param value The value.
+ * @return The number of bytes.
+ */
+static uint8_t getVarintLength(uint32_t value) {
+  uint8_t length = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    length++;
+  }
+  return length;
+}
+
+InputRecorder::InputRecorder(int capacity, uint16_t pollInterval) : capacity(capacity), pollInterval(pollInterval) {
+  ring = new uint8_t[capacity];
+}
+
+void InputRecorder::start(const RecordingStart& start) {
+  // Every older recording may make room for the new one
+  currentStart = -1;
+  isRecording = false;
+  isTruncated = false;
+  if (!makeRoom(START_BYTES)) {
+    return;
+  }
+  currentStart = (oldest + used) % capacity;
+  push(START_HEADER);
+  pushWord(start.time, 4);
+  pushWord(start.seed, 4);
+  push(start.settings.brightness);
+  push(start.settings.responseCurve);
+  push(start.settings.joystickDeadzone);
+  push(start.settings.braidPercent);
+  pushWord(pollInterval, 2);
+  pushWord(start.sinceMove, 2);
+  pushWord(start.sincePoll, 2);
+  push(start.sample.joyX);
+  push(start.sample.joyY);
+  push((start.sample.buttonC ? 1 : 0) | (start.sample.buttonZ ? 2 : 0) | (start.isTransition ? 4 : 0) |
+       (start.isNunchukLost ? 8 : 0) | (start.isChordHeld ? 16 : 0));
+  push(start.position.row);
+  push(start.position.column);
+
+  isRecording = true;
+  lastTime = start.time;
+  lastPollTime = start.time - start.sincePoll;
+  lastSample = start.sample;
+  lastPosition = start.position;
+  isFrameRecorded = false;
+}
+
+void InputRecorder::recordSample(uint32_t time, const NunchukSample& sample) {
+  uint32_t interval = time - lastPollTime;
+  bool isOnTime = interval >= pollInterval && interval - pollInterval < SAMPLE_JITTER_MASK;
+  uint8_t header = isOnTime ? interval - pollInterval : SAMPLE_JITTER_MASK;
+  uint8_t length = isOnTime ? 1 : 1 + getVarintLength(interval);
+  if (sample.joyX != lastSample.joyX) {
+    header |= SAMPLE_X_CHANGED;
+    length++;
+  }
+  if (sample.joyY != lastSample.joyY) {
+    header |= SAMPLE_Y_CHANGED;
+    length++;
+  }
+  if (sample.buttonC) {
+    header |= SAMPLE_BUTTON_C;
+  }
+  if (sample.buttonZ) {
+    header |= SAMPLE_BUTTON_Z;
+  }
+  if (!reserve(length)) {
+    return;
+  }
+
+  push(header);
+  if (!isOnTime) {
+    pushVarint(interval);
+  }
+  // Axis deltas wrap around, so any change fits in a byte
+  if (header & SAMPLE_X_CHANGED) {
+    push(sample.joyX - lastSample.joyX);
+  }
+  if (header & SAMPLE_Y_CHANGED) {
+    push(sample.joyY - lastSample.joyY);
+  }
+  lastSample = sample;
+  lastPollTime = time;
+  lastTime = time;
+  isFrameRecorded = true;
+}
+
+void InputRecorder::recordLost(uint32_t time) {
+  uint32_t interval = time - lastPollTime;
+  if (!reserve(1 + getVarintLength(interval))) {
+    return;
+  }
+  push(LOST_HEADER);
+  pushVarint(interval);
+  lastPollTime = time;
+  lastTime = time;
+  isFrameRecorded = true;
+}
+
+void InputRecorder::recordPosition(uint32_t time, MazePosition position) {
+  if (position.row == lastPosition.row && position.column == lastPosition.column) {
+    return;
+  }
+  int rowChange = position.row - lastPosition.row;
+  int columnChange = position.column - lastPosition.column;
+  bool isStep = rowChange >= -1 && rowChange <= 1 && columnChange >= -1 && columnChange <= 1;
+  uint32_t elapsed = time - lastTime;
+  if (!reserve(1 + getVarintLength(elapsed) + (isStep ? 0 : 2))) {
+    return;
+  }
+
+  if (isStep) {
+    push(STEP_HEADER | ((rowChange + 1) << 2) | (columnChange + 1));
+    pushVarint(elapsed);
+  } else {
+    // Jumps, such as being sent back to the start, store the whole position
+    push(POSITION_HEADER);
+    pushVarint(elapsed);
+    push(position.row);
+    push(position.column);
+  }
+  lastPosition = position;
+  lastTime = time;
+  isFrameRecorded = true;
+}
+
+void InputRecorder::recordTick(uint32_t time) {
+  if (isFrameRecorded && time == lastTime) {
+    return;
+  }
+  recordEvent(TICK_HEADER, time);
+}
+
+void InputRecorder::recordSettled(uint32_t time) {
+  recordEvent(SETTLED_HEADER, time);
+}
+
+void InputRecorder::dump() {
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+  const int BYTES_PER_LINE = 32;
+  Serial.print("Input recording, ");
+  Serial.print(used);
+  Serial.print(" bytes, ");
+  Serial.print(droppedRecords);
+  Serial.println(" records dropped:");
+  for (int i = 0; i < used; i++) {
+    uint8_t value = peek(oldest + i);
+    Serial.print(HEX_DIGITS[value >> 4]);
+    Serial.print(HEX_DIGITS[value & 0x0F]);
+    if (i % BYTES_PER_LINE == BYTES_PER_LINE - 1 || i == used - 1) {
+      Serial.println();
+    }
+  }
+  Serial.println("End of input recording");
+}
+
+int InputRecorder::drain(uint8_t* data) {
+  int length = used;
+  for (int i = 0; i < length; i++) {
+    data[i] = peek(oldest + i);
+  }
+  oldest = 0;
+  used = 0;
+  currentStart = -1;
+  return length;
+}
+
+int InputRecorder::getUsedBytes() {
+  return used;
+}
+
+uint32_t InputRecorder::getDroppedRecords() {
+  return droppedRecords;
+}
+
+int InputRecorder::getRAMBytes() {
+  return capacity;
+}
+
+void InputRecorder::recordEvent(uint8_t header, uint32_t time) {
+  uint32_t elapsed = time - lastTime;
+  if (!reserve(1 + getVarintLength(elapsed))) {
+    return;
+  }
+  push(header);
+  pushVarint(elapsed);
+  lastTime = time;
+  isFrameRecorded = true;
+}
+
+bool InputRecorder::reserve(uint8_t length) {
+  if (!isRecording) {
+    if (isTruncated) {
+      droppedRecords++;
+    }
+    return false;
+  }
+  return makeRoom(length);
+}
+
+bool InputRecorder::makeRoom(uint8_t length) {
+  while (capacity - used < length) {
+    if (used == 0) {
+      return false;
+    }
+    if (oldest == currentStart) {
+      // The recording in progress fills the ring, keep its beginning and drop the rest
+      ring[currentStart] = START_TRUNCATED_HEADER;
+      isRecording = false;
+      isTruncated = true;
+      droppedRecords++;
+      return false;
+    }
+    evictOldest();
+  }
+  return true;
+}
+
+void InputRecorder::evictOldest() {
+  // Records only make sense from the start of their recording, so whole recordings are dropped
+  do {
+    uint8_t length = getRecordLength(oldest);
+    oldest = (oldest + length) % capacity;
+    used -= length;
+  } while (used > 0 && (peek(oldest) & 0xFE) != START_HEADER);
+}
+
+uint8_t InputRecorder::getRecordLength(int index) {
+  uint8_t header = peek(index);
+  if ((header & 0xFE) == START_HEADER) {
+    return START_BYTES;
+  }
+  uint8_t length = 1;
+  bool hasTime = true;
+  if ((header & STEP_HEADER) == 0) {
+    hasTime = (header & SAMPLE_JITTER_MASK) == SAMPLE_JITTER_MASK;
+    length += (header & SAMPLE_X_CHANGED ? 1 : 0) + (header & SAMPLE_Y_CHANGED ? 1 : 0);
+  } else if (header == POSITION_HEADER) {
+    length += 2;
+  }
+  if (hasTime) {
+    uint8_t timeLength = 1;
+    while (peek(index + timeLength) & 0x80) {
+      timeLength++;
+    }
+    length += timeLength;
+  }
+  return length;
+}
+
+uint8_t InputRecorder::peek(int index) {
+  return ring[index % capacity];
+}
+
+void InputRecorder::push(uint8_t value) {
+  ring[(oldest + used) % capacity] = value;
+  used++;
+}
+
+void InputRecorder::pushVarint(uint32_t value) {
+  while (value >= 0x80) {
+    push((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  push(value);
+}
+
+void InputRecorder::pushWord(uint32_t value, uint8_t bytes) {
+  // Little endian
+  for (uint8_t i = 0; i < bytes; i++) {
+    push(value >> (8 * i));
+  }
+}
+
+InputRecordReader::InputRecordReader(const uint8_t* data, int length) : data(data), length(length) {}
+
+bool InputRecordReader::next(InputRecord& record) {
+  uint8_t header;
+  if (index >= length || isCorruptFound || !readByte(header)) {
+    return false;
+  }
+
+  if ((header & 0xFE) == START_HEADER) {
+    RecordingStart& start = record.start;
+    uint32_t seed;
+    uint32_t words[3];
+    uint8_t bytes[9];
+    bool isRead = readWord(start.time, 4) && readWord(seed, 4);
+    for (uint8_t i = 0; i < 4 && isRead; i++) {
+      isRead = readByte(bytes[i]);
+    }
+    for (uint8_t i = 0; i < 3 && isRead; i++) {
+      isRead = readWord(words[i], 2);
+    }
+    for (uint8_t i = 4; i < 9 && isRead; i++) {
+      isRead = readByte(bytes[i]);
+    }
+    if (!isRead) {
+      isCorruptFound = true;
+      return false;
+    }
+    start.seed = seed;
+    start.settings = {bytes[0], bytes[1], bytes[2], bytes[3]};
+    start.pollInterval = words[0];
+    start.sinceMove = words[1];
+    start.sincePoll = words[2];
+    start.sample = {bytes[4], bytes[5], (bytes[6] & 1) != 0, (bytes[6] & 2) != 0};
+    start.position = {bytes[7], bytes[8]};
+    start.isTransition = (bytes[6] & 4) != 0;
+    start.isNunchukLost = (bytes[6] & 8) != 0;
+    start.isChordHeld = (bytes[6] & 16) != 0;
+    start.isTruncated = header == START_TRUNCATED_HEADER;
+
+    isStarted = true;
+    pollInterval = start.pollInterval;
+    lastTime = start.time;
+    lastPollTime = start.time - start.sincePoll;
+    lastSample = start.sample;
+    lastPosition = start.position;
+    record.type = INPUT_RECORD_START;
+    record.time = start.time;
+    return true;
+  }
+  if (!isStarted) {
+    isCorruptFound = true;
+    return false;
+  }
+
+  uint32_t elapsed = 0;
+  if ((header & STEP_HEADER) == 0) {
+    uint8_t jitter = header & SAMPLE_JITTER_MASK;
+    uint32_t interval = pollInterval + jitter;
+    uint8_t change;
+    NunchukSample sample = lastSample;
+    bool isRead = jitter != SAMPLE_JITTER_MASK || readVarint(interval);
+    if (isRead && (header & SAMPLE_X_CHANGED)) {
+      isRead = readByte(change);
+      sample.joyX += change;
+    }
+    if (isRead && (header & SAMPLE_Y_CHANGED)) {
+      isRead = readByte(change);
+      sample.joyY += change;
+    }
+    if (!isRead) {
+      isCorruptFound = true;
+      return false;
+    }
+    sample.buttonC = (header & SAMPLE_BUTTON_C) != 0;
+    sample.buttonZ = (header & SAMPLE_BUTTON_Z) != 0;
+    lastSample = sample;
+    lastPollTime += interval;
+    lastTime = lastPollTime;
+    record.type = INPUT_RECORD_SAMPLE;
+    record.time = lastTime;
+    record.sample = sample;
+    return true;
+  }
+
+  if (header == LOST_HEADER) {
+    if (!readVarint(elapsed)) {
+      isCorruptFound = true;
+      return false;
+    }
+    lastPollTime += elapsed;
+    lastTime = lastPollTime;
+    record.type = INPUT_RECORD_LOST;
+    record.time = lastTime;
+    return true;
+  }
+
+  if (!readVarint(elapsed)) {
+    isCorruptFound = true;
+    return false;
+  }
+  lastTime += elapsed;
+  record.time = lastTime;
+  uint8_t rowChange = (header >> 2) & 3;
+  uint8_t columnChange = header & 3;
+  if ((header & 0xF0) == STEP_HEADER && rowChange != 3 && columnChange != 3 && header != (STEP_HEADER | 5)) {
+    lastPosition.row += rowChange - 1;
+    lastPosition.column += columnChange - 1;
+    record.type = INPUT_RECORD_POSITION;
+    record.position = lastPosition;
+    return true;
+  }
+  uint8_t row;
+  uint8_t column;
+  switch (header) {
+    case POSITION_HEADER:
+      if (!readByte(row) || !readByte(column)) {
+        isCorruptFound = true;
+        return false;
+      }
+      lastPosition = {row, column};
+      record.type = INPUT_RECORD_POSITION;
+      record.position = lastPosition;
+      return true;
+    case TICK_HEADER:
+      record.type = INPUT_RECORD_TICK;
+      return true;
+    case SETTLED_HEADER:
+      record.type = INPUT_RECORD_SETTLED;
+      return true;
+    default:
+      isCorruptFound = true;
+      return false;
+  }
+}
+
+bool InputRecordReader::isCorrupt() {
+  return isCorruptFound;
+}
+
+bool InputRecordReader::readByte(uint8_t& value) {
+  if (index >= length) {
+    return false;
+  }
+  value = data[index++];
+  return true;
+}
+
+bool InputRecordReader::readVarint(uint32_t& value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    uint8_t part;
+    if (!readByte(part)) {
+      return false;
+    }
+    value |= (uint32_t)(part & 0x7F) << shift;
+    if ((part & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool InputRecordReader::readWord(uint32_t& value, uint8_t bytes) {
+  value = 0;
+  for (uint8_t i = 0; i < bytes; i++) {
+    uint8_t part;
+    if (!readByte(part)) {
+      return false;
+    }
+    value |= (uint32_t)part << (8 * i);
+  }
+  return true;
+}
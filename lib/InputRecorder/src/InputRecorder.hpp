@@ -0,0 +1,230 @@
+#include <Arduino.h>
+#ifndef INPUT_RECORDER_HPP
+#define INPUT_RECORDER_HPP
+
+#include <Maze.hpp>
+#include <SettingsStore.hpp>
+
+/**
+ * @brief A reading of the nunchuk.
+ */
+struct NunchukSample {
+  uint8_t joyX;
+  uint8_t joyY;
+  bool buttonC;
+  bool buttonZ;
+};
+
+/**
+ * @brief Everything a replay needs to continue from the start of a maze.
+ */
+struct RecordingStart {
+  uint32_t time;          // Time the maze started in milliseconds
+  uint32_t seed;          // Seed the maze is generated from
+  Settings settings;      // Settings in use, the joystick ones change how the samples are shaped
+  uint16_t pollInterval;  // Expected time between nunchuk polls in milliseconds
+  uint16_t sinceMove;     // Time since the player last moved, at most 65535 ms
+  uint16_t sincePoll;     // Time since the nunchuk was last polled
+  NunchukSample sample;   // The last reading of the nunchuk
+  bool isNunchukLost;     // True if the nunchuk was not connected, its joystick then reads at rest
+  bool isChordHeld;       // True if C and Z were pressed together and are not both released yet
+  MazePosition position;  // Position of the player
+  bool isTransition;      // True if the maze starts while it is generated or saved, false for a restart of a saved maze
+  bool isTruncated;       // True if the recording outgrew the ring and its end was dropped
+};
+
+/**
+ * @brief The kinds of records in a recording.
+ */
+enum InputRecordType : uint8_t {
+  INPUT_RECORD_START,    // A new maze, see RecordingStart
+  INPUT_RECORD_SAMPLE,   // A successful nunchuk poll
+  INPUT_RECORD_LOST,     // A failed nunchuk poll
+  INPUT_RECORD_POSITION, // The player moved, or was moved
+  INPUT_RECORD_TICK,     // A frame that changed the game without moving the player, such as an enemy move
+  INPUT_RECORD_SETTLED   // The frame in which the switch to a new maze was complete
+};
+
+/**
+ * @brief A decoded record, see InputRecordReader.
+ */
+struct InputRecord {
+  InputRecordType type;
+  uint32_t time;         // Time of the frame in milliseconds
+  NunchukSample sample;  // INPUT_RECORD_SAMPLE only
+  MazePosition position; // INPUT_RECORD_POSITION only
+  RecordingStart start;  // INPUT_RECORD_START only
+};
+
+/**
+ * @class InputRecorder
+ * @brief Records the nunchuk samples of each maze in a RAM ring, so a session can be replayed
+ *        exactly, see tools/mazereplay.
+ *
+ * A recording starts with the seed, the settings and the timing state of a new maze. Then every
+ * nunchuk poll is recorded, with its time and the joystick axes as deltas from the previous
+ * poll, and every frame that moves the player or otherwise changes the game gets a record, so a
+ * replay runs exactly the frames that matter at their original times. Player moves are
+ * recorded as steps, which double as checkpoints for detecting a diverging replay.
+ *
+ * Most records take 1 to 3 bytes: a poll that changed nothing costs a single byte when it came
+ * less than 7 ms after the expected interval. When the ring is full the oldest recordings are dropped,
+ * a maze that outgrows the whole ring is kept up to that point and marked as truncated.
+ *
+ * Frames are told apart by their time, so frames must last at least a millisecond.
+ */
+class InputRecorder {
+public:
+  static const uint8_t START_BYTES = 24; // Largest record, the ring must hold at least one
+
+  /**
+   * @brief Constructs an empty recorder.
+   * @param capacity The size of the ring in bytes.
+   * @param pollInterval The time between nunchuk polls in milliseconds, polls close to it take
+   *                     the least space.
+   */
+  InputRecorder(int capacity, uint16_t pollInterval);
+
+  /**
+   * @brief Starts the recording of a new maze.
+   * @param start The state the maze starts from, pollInterval and isTruncated are set here.
+   */
+  void start(const RecordingStart& start);
+
+  /**
+   * @brief Records a successful nunchuk poll.
+   * @param time The time of the frame in milliseconds.
+   * @param sample The reading.
+   */
+  void recordSample(uint32_t time, const NunchukSample& sample);
+
+  /**
+   * @brief Records a failed nunchuk poll.
+   * @param time The time of the frame in milliseconds.
+   */
+  void recordLost(uint32_t time);
+
+  /**
+   * @brief Records the position of the player if it changed since the last record.
+   * @param time The time of the frame in milliseconds.
+   * @param position The position of the player.
+   */
+  void recordPosition(uint32_t time, MazePosition position);
+
+  /**
+   * @brief Records a frame that changed the game without moving the player.
+   * @note Nothing is added if the frame already has a record.
+   * @param time The time of the frame in milliseconds.
+   */
+  void recordTick(uint32_t time);
+
+  /**
+   * @brief Records the frame in which the switch to a new maze was complete, a replay runs
+   *        as many frames as it needs to get there at this time.
+   * @param time The time of the frame in milliseconds.
+   */
+  void recordSettled(uint32_t time);
+
+  /**
+   * @brief Prints the ring to the serial port as hex, from the oldest recording to the newest.
+   * @note Blocks until the whole ring is written, call it while the game pauses.
+   */
+  void dump();
+
+  /**
+   * @brief Moves the bytes recorded so far out of the ring. Recording goes on, so the bytes of
+   *        successive drains form a single stream.
+   * @param data Where the bytes are copied, room for the capacity of the ring.
+   * @return The number of bytes copied.
+   */
+  int drain(uint8_t* data);
+
+  /**
+   * @brief Gets the number of bytes in the ring.
+   * @return The number of bytes used.
+   */
+  int getUsedBytes();
+
+  /**
+   * @brief Gets the number of records dropped because a maze outgrew the ring.
+   * @return The number of records dropped since startup.
+   */
+  uint32_t getDroppedRecords();
+
+  /**
+   * @brief Gets the RAM used by the ring.
+   * @return The size of the ring in bytes.
+   */
+  int getRAMBytes();
+
+private:
+  uint8_t* ring;
+  int capacity;
+  int oldest = 0; // Index of the first byte of the oldest record
+  int used = 0;
+  int currentStart = -1; // Index of the start of the recording in progress, -1 once drained
+  bool isRecording = false;
+  bool isTruncated = false;
+  uint16_t pollInterval;
+  uint32_t lastTime = 0;
+  uint32_t lastPollTime = 0;
+  NunchukSample lastSample = {128, 128, false, false};
+  MazePosition lastPosition = {0, 0};
+  bool isFrameRecorded = false; // True if the frame at lastTime has a record
+  uint32_t droppedRecords = 0;
+
+  void recordEvent(uint8_t header, uint32_t time);
+  bool reserve(uint8_t length);
+  bool makeRoom(uint8_t length);
+  void evictOldest();
+  uint8_t getRecordLength(int index);
+  uint8_t peek(int index);
+  void push(uint8_t value);
+  void pushVarint(uint32_t value);
+  void pushWord(uint32_t value, uint8_t bytes);
+};
+
+/**
+ * @class InputRecordReader
+ * @brief Decodes the records of a stream written by InputRecorder.
+ */
+class InputRecordReader {
+public:
+  /**
+   * @brief Constructs a reader.
+   * @param data The stream, from the start of a recording.
+   * @param length The length of the stream in bytes.
+   */
+  InputRecordReader(const uint8_t* data, int length);
+
+  /**
+   * @brief Decodes the next record.
+   * @param record Set to the record.
+   * @return True if a record was decoded, false at the end of the stream or if it is corrupt.
+   */
+  bool next(InputRecord& record);
+
+  /**
+   * @brief Tells whether decoding stopped at a record that is cut off or invalid.
+   * @return True if the stream is corrupt.
+   */
+  bool isCorrupt();
+
+private:
+  const uint8_t* data;
+  int length;
+  int index = 0;
+  bool isCorruptFound = false;
+  bool isStarted = false;
+  uint16_t pollInterval = 0;
+  uint32_t lastTime = 0;
+  uint32_t lastPollTime = 0;
+  NunchukSample lastSample = {128, 128, false, false};
+  MazePosition lastPosition = {0, 0};
+
+  bool readByte(uint8_t& value);
+  bool readVarint(uint32_t& value);
+  bool readWord(uint32_t& value, uint8_t bytes);
+};
+
+#endif
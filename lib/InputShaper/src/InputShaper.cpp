@@ -0,0 +1,97 @@
+#include <Arduino.h>
+#include "InputShaper.hpp"
+
+// Speed at each step past the deadzone, 0 is the slowest and 255 the fastest
+static const uint8_t LINEAR_CURVE[InputShaper::CURVE_STEPS] PROGMEM = {
+  0, 17, 34, 51, 68, 85, 102, 119, 136, 153, 170, 187, 204, 221, 238, 255
+};
+
+// (2^(4x) - 1) / 15
+static const uint8_t EXPONENTIAL_CURVE[InputShaper::CURVE_STEPS] PROGMEM = {
+  0, 3, 8, 13, 19, 26, 35, 45, 58, 73, 91, 113, 139, 171, 209, 255
+};
+
+// tan(22.5 degrees) * 128, the edge between a straight and a diagonal sector
+static const uint8_t SECTOR_EDGE = 53;
+
+InputShaper::InputShaper(uint8_t deadzone, uint16_t minMoveDelay, uint16_t maxMoveDelay, ResponseCurve curve)
+    : deadzone(min(deadzone, (uint8_t)126)), minMoveDelay(minMoveDelay), maxMoveDelay(maxMoveDelay),
+      curveTable(LINEAR_CURVE) {
+  setCurve(curve);
+}
+
+bool InputShaper::setCurve(ResponseCurve curve) {
+  if (curve == CURVE_CUSTOM) {
+    if (customCurveTable == nullptr) {
+      return false;
+    }
+    curveTable = customCurveTable;
+  } else {
+    curveTable = curve == CURVE_EXPONENTIAL ? EXPONENTIAL_CURVE : LINEAR_CURVE;
+  }
+  return true;
+}
+
+void InputShaper::setCustomCurve(const uint8_t* curve) {
+  customCurveTable = curve;
+  curveTable = curve;
+}
+
+void InputShaper::setDeadzone(uint8_t deadzone) {
+  this->deadzone = min(deadzone, (uint8_t)126);
+}
+
+void InputShaper::setDiagonals(bool enabled) {
+  isDiagonalEnabled = enabled;
+}
+
+ShapedInput InputShaper::shape(uint8_t joyX, uint8_t joyY) {
+  ShapedInput input = {0, 0, maxMoveDelay};
+  int16_t x = joyX - 128;
+  int16_t y = joyY - 128;
+  uint8_t absoluteX = abs(x);
+  uint8_t absoluteY = abs(y);
+  uint16_t magnitudeSquared = (uint16_t)(absoluteX * absoluteX) + (uint16_t)(absoluteY * absoluteY);
+  if (magnitudeSquared < (uint16_t)((deadzone + 1) * (deadzone + 1))) {
+    return input;
+  }
+
+  // 255 is stretched to 256 so full tilt reaches the minimum delay exactly
+  uint16_t speed = pgm_read_byte(&curveTable[getCurveStep(magnitudeSquared)]);
+  speed += speed >> 7;
+  input.moveDelay = maxMoveDelay - (uint16_t)(((uint32_t)(maxMoveDelay - minMoveDelay) * speed) >> 8);
+
+  bool isHorizontal;
+  bool isVertical;
+  if (isDiagonalEnabled) {
+    isHorizontal = absoluteY * SECTOR_EDGE < absoluteX * 128;
+    isVertical = absoluteX * SECTOR_EDGE < absoluteY * 128;
+  } else {
+    isHorizontal = absoluteX >= absoluteY;
+    isVertical = !isHorizontal;
+  }
+  if (isHorizontal) {
+    input.columnStep = x > 0 ? 1 : -1;
+  }
+  if (isVertical) {
+    input.rowStep = y > 0 ? -1 : 1; // Joystick up is a smaller row
+  }
+  return input;
+}
+
+uint8_t InputShaper::getCurveStep(uint16_t magnitudeSquared) {
+  // Binary search for the last step whose squared threshold the magnitude reaches
+  uint8_t range = 127 - deadzone;
+  uint8_t low = 0;
+  uint8_t high = CURVE_STEPS - 1;
+  while (low < high) {
+    uint8_t middle = (low + high + 1) / 2;
+    uint8_t threshold = deadzone + (uint16_t)(range * middle) / CURVE_STEPS;
+    if (magnitudeSquared >= (uint16_t)(threshold * threshold)) {
+      low = middle;
+    } else {
+      high = middle - 1;
+    }
+  }
+  return low;
+}
@@ -0,0 +1,95 @@
+#include <Arduino.h>
+#ifndef INPUT_SHAPER_HPP
+#define INPUT_SHAPER_HPP
+
+/**
+ * @brief How the tilt of the joystick past the deadzone maps to movement speed.
+ */
+enum ResponseCurve : uint8_t {
+  CURVE_LINEAR,      // Speed grows evenly with tilt
+  CURVE_EXPONENTIAL, // Fine control at small tilts, speed ramps up near full tilt
+  CURVE_CUSTOM       // A table set with setCustomCurve
+};
+
+/**
+ * @brief A joystick reading turned into a move.
+ */
+struct ShapedInput {
+  int8_t rowStep;     // -1 up, 1 down, 0 none
+  int8_t columnStep;  // -1 left, 1 right, 0 none
+  uint16_t moveDelay; // Minimum time between two moves in milliseconds
+};
+
+/**
+ * @class InputShaper
+ * @brief Turns raw joystick readings into moves using integer arithmetic only.
+ *
+ * The deadzone is radial and tested against the squared magnitude of the joystick
+ * vector, so no square root is needed. The magnitude past the deadzone is split into
+ * CURVE_STEPS steps, found by comparing squared step thresholds, and each step reads
+ * its speed from a response curve table in flash (PROGMEM).
+ */
+class InputShaper {
+public:
+  static const uint8_t CURVE_STEPS = 16;
+
+  /**
+   * @brief Constructs an input shaper.
+   * @param deadzone Largest tilt from the center, in joystick units, that is ignored.
+   * @param minMoveDelay Delay between moves at full tilt in milliseconds.
+   * @param maxMoveDelay Delay between moves just past the deadzone in milliseconds.
+   * @param curve The response curve, CURVE_CUSTOM starts out linear until setCustomCurve is called.
+   */
+  InputShaper(uint8_t deadzone, uint16_t minMoveDelay, uint16_t maxMoveDelay, ResponseCurve curve = CURVE_LINEAR);
+
+  /**
+   * @brief Selects a response curve.
+   * @param curve CURVE_LINEAR, CURVE_EXPONENTIAL, or CURVE_CUSTOM to go back to the table
+   *              last set with setCustomCurve.
+   * @return True if the curve was selected, false for CURVE_CUSTOM when no table was
+   *         set, in which case the current curve is kept.
+   */
+  bool setCurve(ResponseCurve curve);
+
+  /**
+   * @brief Selects a custom response curve.
+   * @param curve CURVE_STEPS bytes in flash (PROGMEM), from the first step past the deadzone
+   *              to full tilt. 0 is the slowest speed and 255 the fastest.
+   */
+  void setCustomCurve(const uint8_t* curve);
+
+  /**
+   * @brief Changes the deadzone.
+   * @param deadzone Largest tilt from the center, in joystick units, that is ignored.
+   */
+  void setDeadzone(uint8_t deadzone);
+
+  /**
+   * @brief Enables or disables diagonal moves.
+   * @note With diagonals the joystick is split into 8 sectors of 45 degrees, without them
+   *       into 4 sectors of 90 degrees and only the dominant axis moves.
+   *
+   * @param enabled True to allow diagonal moves.
+   */
+  void setDiagonals(bool enabled);
+
+  /**
+   * @brief Turns a joystick reading into a move.
+   * @param joyX The horizontal joystick reading, 128 at rest.
+   * @param joyY The vertical joystick reading, 128 at rest, larger values up.
+   * @return The move, with no step inside the deadzone.
+   */
+  ShapedInput shape(uint8_t joyX, uint8_t joyY);
+
+private:
+  uint8_t deadzone;
+  uint16_t minMoveDelay;
+  uint16_t maxMoveDelay;
+  const uint8_t* curveTable;
+  const uint8_t* customCurveTable = nullptr;
+  bool isDiagonalEnabled = true;
+
+  uint8_t getCurveStep(uint16_t magnitudeSquared);
+};
+
+#endif
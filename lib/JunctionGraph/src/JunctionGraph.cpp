@@ -0,0 +1,292 @@
+#include <Arduino.h>
+#include "JunctionGraph.hpp"
+
+bool JunctionGraph::update(Maze& maze) {
+  // Rebuild once per maze, never on a maze still being generated
+  if (maze.isGenerating() || (isCurrent && revision == maze.getRevision())) {
+    return false;
+  }
+  return build(maze);
+}
+
+bool JunctionGraph::build(Maze& maze) {
+  uint32_t startMicros = micros();
+  revision = maze.getRevision();
+  isCurrent = true;
+  isBuilt = false;
+
+  // Every open direction of a node is one end of an edge
+  int newNodeCount = 0;
+  int edgeEnds = 0;
+  openCellCount = 0;
+  for (int i = 0; i < maze.getRows(); i++) {
+    for (int j = 0; j < maze.getColumns(); j++) {
+      if (maze.isCollision(i, j)) {
+        continue;
+      }
+      openCellCount++;
+      if (isNodePosition(maze, i, j)) {
+        newNodeCount++;
+        uint8_t directions = maze.getOpenDirections(i, j);
+        for (uint8_t direction = MAZE_UP; direction <= MAZE_LEFT; direction <<= 1) {
+          edgeEnds += (directions & direction) != 0;
+        }
+      }
+    }
+  }
+  if (newNodeCount > MAX_NODES) {
+    nodeCount = 0;
+    edgeCount = 0;
+    return false;
+  }
+
+  // Keep the buffers between mazes unless they are too small
+  if (newNodeCount > nodeCapacity) {
+    delete[] nodes;
+    nodes = new Node[newNodeCount];
+    nodeCapacity = newNodeCount;
+  }
+  if (edgeEnds / 2 > edgeCapacity) {
+    delete[] edges;
+    edges = new JunctionEdge[edgeEnds / 2];
+    edgeCapacity = edgeEnds / 2;
+  }
+
+  // Nodes are found in row-major order, so findNode can binary search them
+  nodeCount = 0;
+  for (int i = 0; i < maze.getRows(); i++) {
+    for (int j = 0; j < maze.getColumns(); j++) {
+      if (!maze.isCollision(i, j) && isNodePosition(maze, i, j)) {
+        nodes[nodeCount].row = i;
+        nodes[nodeCount].column = j;
+        nodeCount++;
+      }
+    }
+  }
+
+  // Walk every corridor from both ends and keep it once
+  edgeCount = 0;
+  MazePosition noTarget = {-1, -1};
+  long unusedSteps;
+  for (int node = 0; node < nodeCount; node++) {
+    MazePosition position = getNode(node);
+    uint8_t directions = maze.getOpenDirections(position.row, position.column);
+    for (uint8_t direction = MAZE_UP; direction <= MAZE_LEFT; direction <<= 1) {
+      if (!(directions & direction)) {
+        continue;
+      }
+      uint16_t length;
+      uint8_t arrivalDirection;
+      uint8_t other = followCorridor(maze, position, direction, length, arrivalDirection, noTarget, unusedSteps);
+      bool isFirstEnd = node < other || (node == other && direction < arrivalDirection);
+      if (other == NO_NODE || !isFirstEnd || edgeCount >= edgeCapacity) {
+        continue;
+      }
+      JunctionEdge& edge = edges[edgeCount++];
+      edge.nodes[0] = node;
+      edge.nodes[1] = other;
+      edge.directions[0] = direction;
+      edge.directions[1] = arrivalDirection;
+      edge.length = length;
+    }
+  }
+
+  isBuilt = true;
+  buildMicros = micros() - startMicros;
+  return true;
+}
+
+bool JunctionGraph::isReady() {
+  return isBuilt;
+}
+
+int JunctionGraph::getNodeCount() {
+  return nodeCount;
+}
+
+int JunctionGraph::getEdgeCount() {
+  return edgeCount;
+}
+
+int JunctionGraph::getOpenCellCount() {
+  return openCellCount;
+}
+
+uint32_t JunctionGraph::getBuildMicros() {
+  return buildMicros;
+}
+
+int JunctionGraph::getRAMBytes() {
+  return nodeCapacity * sizeof(Node) + edgeCapacity * sizeof(JunctionEdge);
+}
+
+MazePosition JunctionGraph::getNode(uint8_t node) {
+  MazePosition position = {nodes[node].row, nodes[node].column};
+  return position;
+}
+
+uint8_t JunctionGraph::findNode(MazePosition position) {
+  uint16_t key = (position.row << 8) | position.column;
+  int low = 0;
+  int high = nodeCount - 1;
+  while (low <= high) {
+    int middle = (low + high) / 2;
+    uint16_t middleKey = (nodes[middle].row << 8) | nodes[middle].column;
+    if (middleKey == key) {
+      return middle;
+    }
+    if (middleKey < key) {
+      low = middle + 1;
+    } else {
+      high = middle - 1;
+    }
+  }
+  return NO_NODE;
+}
+
+uint8_t JunctionGraph::getNeighbour(uint8_t node, uint8_t direction, uint16_t& length) {
+  for (int i = 0; i < edgeCount; i++) {
+    for (uint8_t end = 0; end < 2; end++) {
+      if (edges[i].nodes[end] == node && edges[i].directions[end] == direction) {
+        length = edges[i].length;
+        return edges[i].nodes[1 - end];
+      }
+    }
+  }
+  return NO_NODE;
+}
+
+long JunctionGraph::getPathLength(Maze& maze, MazePosition from, MazePosition to) {
+  if (!isBuilt || maze.isCollision(from.row, from.column) || maze.isCollision(to.row, to.column)) {
+    return -1;
+  }
+  if (from.row == to.row && from.column == to.column) {
+    return 0;
+  }
+
+  // Join each position to the nodes at both ends of its corridor, or to itself if it is a node
+  uint8_t sourceNodes[2] = {NO_NODE, NO_NODE};
+  uint8_t targetNodes[2] = {NO_NODE, NO_NODE};
+  long sourceSteps[2] = {0, 0};
+  long targetSteps[2] = {0, 0};
+  long bestSteps = -1;
+  MazePosition noTarget = {-1, -1};
+  for (uint8_t side = 0; side < 2; side++) {
+    MazePosition position = side == 0 ? from : to;
+    uint8_t* endNodes = side == 0 ? sourceNodes : targetNodes;
+    long* endSteps = side == 0 ? sourceSteps : targetSteps;
+    uint8_t node = findNode(position);
+    if (node != NO_NODE) {
+      endNodes[0] = node;
+      continue;
+    }
+    uint8_t directions = maze.getOpenDirections(position.row, position.column);
+    uint8_t end = 0;
+    for (uint8_t direction = MAZE_UP; direction <= MAZE_LEFT && end < 2; direction <<= 1) {
+      if (!(directions & direction)) {
+        continue;
+      }
+      uint16_t length;
+      uint8_t arrivalDirection;
+      long stepsToTarget = -1;
+      endNodes[end] = followCorridor(maze, position, direction, length, arrivalDirection, side == 0 ? to : noTarget,
+                                     stepsToTarget);
+      endSteps[end] = length;
+      if (stepsToTarget >= 0 && (bestSteps < 0 || stepsToTarget < bestSteps)) {
+        bestSteps = stepsToTarget; // Both positions are in the same corridor
+      }
+      end++;
+    }
+  }
+
+  // Dijkstra's algorithm over the nodes, a linear scan is fastest for graphs this small
+  const uint16_t UNREACHED = 0xFFFF;
+  uint16_t* distances = new uint16_t[nodeCount];
+  bool* isDone = new bool[nodeCount];
+  for (int i = 0; i < nodeCount; i++) {
+    distances[i] = UNREACHED;
+    isDone[i] = false;
+  }
+  for (uint8_t end = 0; end < 2; end++) {
+    if (sourceNodes[end] != NO_NODE && sourceSteps[end] < distances[sourceNodes[end]]) {
+      distances[sourceNodes[end]] = sourceSteps[end];
+    }
+  }
+  while (true) {
+    int closest = -1;
+    for (int i = 0; i < nodeCount; i++) {
+      if (!isDone[i] && distances[i] != UNREACHED && (closest < 0 || distances[i] < distances[closest])) {
+        closest = i;
+      }
+    }
+    if (closest < 0) {
+      break;
+    }
+    isDone[closest] = true;
+    for (int i = 0; i < edgeCount; i++) {
+      for (uint8_t end = 0; end < 2; end++) {
+        if (edges[i].nodes[end] != closest) {
+          continue;
+        }
+        uint8_t other = edges[i].nodes[1 - end];
+        long distance = (long)distances[closest] + edges[i].length;
+        if (distance < distances[other]) {
+          distances[other] = distance;
+        }
+      }
+    }
+  }
+
+  for (uint8_t end = 0; end < 2; end++) {
+    if (targetNodes[end] == NO_NODE || distances[targetNodes[end]] == UNREACHED) {
+      continue;
+    }
+    long steps = (long)distances[targetNodes[end]] + targetSteps[end];
+    if (bestSteps < 0 || steps < bestSteps) {
+      bestSteps = steps;
+    }
+  }
+  delete[] distances;
+  delete[] isDone;
+  return bestSteps;
+}
+
+uint8_t JunctionGraph::getRunDirection(Maze& maze, MazePosition position, uint8_t lastDirection) {
+  if (maze.isCollision(position.row, position.column) || isNodePosition(maze, position.row, position.column)) {
+    return 0;
+  }
+  // Inside a corridor exactly one way leads on
+  return maze.getOpenDirections(position.row, position.column) & ~Maze::getOppositeDirection(lastDirection);
+}
+
+bool JunctionGraph::isNodePosition(Maze& maze, int row, int column) {
+  MazePosition start = maze.getStartPosition();
+  MazePosition end = maze.getEndPosition();
+  if ((row == start.row && column == start.column) || (row == end.row && column == end.column)) {
+    return true;
+  }
+  // A corridor position has exactly two open directions: one bit left after clearing the lowest one
+  uint8_t directions = maze.getOpenDirections(row, column);
+  uint8_t otherDirections = directions & (directions - 1);
+  return otherDirections == 0 || (otherDirections & (otherDirections - 1)) != 0;
+}
+
+uint8_t JunctionGraph::followCorridor(Maze& maze, MazePosition position, uint8_t direction, uint16_t& length,
+                                      uint8_t& arrivalDirection, MazePosition target, long& targetSteps) {
+  length = 0;
+  while (true) {
+    position = Maze::step(position, direction);
+    length++;
+    if (position.row == target.row && position.column == target.column) {
+      targetSteps = length;
+    }
+    if (isNodePosition(maze, position.row, position.column)) {
+      arrivalDirection = Maze::getOppositeDirection(direction);
+      return findNode(position);
+    }
+    direction = maze.getOpenDirections(position.row, position.column) & ~Maze::getOppositeDirection(direction);
+    if (direction == 0) {
+      return NO_NODE;
+    }
+  }
+}
@@ -0,0 +1,152 @@
+#include <Arduino.h>
+#ifndef JUNCTION_GRAPH_HPP
+#define JUNCTION_GRAPH_HPP
+
+#include <Maze.hpp>
+
+/**
+ * @brief A corridor joining two nodes of a junction graph.
+ */
+struct JunctionEdge {
+  uint8_t nodes[2];      // The nodes at both ends of the corridor
+  uint8_t directions[2]; // The direction the corridor leaves each node in
+  uint16_t length;       // Steps from one end to the other
+};
+
+/**
+ * @class JunctionGraph
+ * @brief A maze compressed into its junctions, dead ends and the corridors between them.
+ *
+ * Every open position with other than two open neighbours, plus the start and the end,
+ * is a node. Every corridor of positions with exactly two open neighbours becomes a
+ * single edge weighted by its length. Mazes from recursive backtracking are mostly long
+ * corridors, so shortest paths run over a small fraction of the cells.
+ *
+ * Memory: 2 bytes per node and 6 bytes per edge, e.g. about 20 nodes and edges for a
+ * 16x16 maze. At most MAX_NODES nodes are supported.
+ */
+class JunctionGraph {
+public:
+  static const uint8_t NO_NODE = 0xFF;
+  static const uint8_t MAX_NODES = 254;
+
+  /**
+   * @brief Rebuilds the graph if the maze changed since the last build.
+   * @note Call this every frame, it returns immediately unless a new maze is complete.
+   *
+   * @param maze The maze to compress.
+   * @return True if the graph was rebuilt, false otherwise.
+   */
+  bool update(Maze& maze);
+
+  /**
+   * @brief Builds the graph of a maze.
+   * @param maze The maze to compress.
+   * @return True if the graph was built, false if the maze has too many nodes.
+   */
+  bool build(Maze& maze);
+
+  /**
+   * @brief Checks if the graph matches a complete maze.
+   * @return True if the graph can be queried, false otherwise.
+   */
+  bool isReady();
+
+  /**
+   * @brief Gets the number of nodes, the junctions, dead ends, start and end.
+   * @return The number of nodes.
+   */
+  int getNodeCount();
+
+  /**
+   * @brief Gets the number of edges, one per corridor.
+   * @return The number of edges.
+   */
+  int getEdgeCount();
+
+  /**
+   * @brief Gets the number of open positions the graph was built from.
+   * @return The number of open positions.
+   */
+  int getOpenCellCount();
+
+  /**
+   * @brief Gets the time the last build took.
+   * @return The build time in microseconds.
+   */
+  uint32_t getBuildMicros();
+
+  /**
+   * @brief Gets the RAM used by the nodes and edges.
+   * @return The RAM used in bytes.
+   */
+  int getRAMBytes();
+
+  /**
+   * @brief Gets the position of a node.
+   * @param node The index of the node.
+   * @return The position of the node.
+   */
+  MazePosition getNode(uint8_t node);
+
+  /**
+   * @brief Finds the node at a position.
+   * @param position The position to look up.
+   * @return The index of the node, NO_NODE if the position is not a node.
+   */
+  uint8_t findNode(MazePosition position);
+
+  /**
+   * @brief Follows the corridor leaving a node in a direction.
+   * @param node The index of the node.
+   * @param direction MAZE_UP, MAZE_RIGHT, MAZE_DOWN or MAZE_LEFT.
+   * @param length Receives the length of the corridor.
+   * @return The node at the other end of the corridor, NO_NODE if the direction is closed.
+   */
+  uint8_t getNeighbour(uint8_t node, uint8_t direction, uint16_t& length);
+
+  /**
+   * @brief Gets the length of the shortest path between two open positions.
+   * @note Positions inside corridors are joined to the nodes at both ends of their
+   *       corridor, then Dijkstra's algorithm runs over the nodes only.
+   *
+   * @param maze The maze the graph was built from.
+   * @param from The position to start from.
+   * @param to The position to reach.
+   * @return The number of steps, -1 if a position is a wall or cannot be reached.
+   */
+  long getPathLength(Maze& maze, MazePosition from, MazePosition to);
+
+  /**
+   * @brief Gets the direction that continues a run along a corridor.
+   * @param maze The maze the graph was built from.
+   * @param position The position reached by the run.
+   * @param lastDirection The direction of the step that reached the position.
+   * @return The only open direction other than going back, 0 if the position is a node.
+   */
+  uint8_t getRunDirection(Maze& maze, MazePosition position, uint8_t lastDirection);
+
+private:
+  struct Node {
+    uint8_t row;
+    uint8_t column;
+  };
+
+  Node* nodes = nullptr;
+  JunctionEdge* edges = nullptr;
+  int nodeCount = 0;
+  int edgeCount = 0;
+  int nodeCapacity = 0;
+  int edgeCapacity = 0;
+  int openCellCount = 0;
+  uint32_t buildMicros = 0;
+  uint16_t revision = 0;
+  bool isBuilt = false;
+  bool isCurrent = false; // A build was attempted for the current revision
+
+  bool isNodePosition(Maze& maze, int row, int column);
+  uint8_t followCorridor(Maze& maze, MazePosition position, uint8_t direction, uint16_t& length, uint8_t& arrivalDirection,
+                         MazePosition target, long& targetSteps);
+};
+
+#endif
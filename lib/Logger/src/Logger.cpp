@@ -0,0 +1,126 @@
+#include <Arduino.h>
+#include "Logger.hpp"
+
+static const char DROPPED_TEXT[] PROGMEM = "Log dropped messages:";
+
+Logger::Logger(uint8_t capacity, const char* messages) : messages(messages), capacity(capacity) {
+  ring = new Message[capacity];
+}
+
+void Logger::log(uint8_t id) {
+  push(id, 0, 0, 0, 0);
+}
+
+void Logger::log(uint8_t id, int16_t argument) {
+  push(id, 1, argument, 0, 0);
+}
+
+void Logger::log(uint8_t id, int16_t first, int16_t second) {
+  push(id, 2, first, second, 0);
+}
+
+void Logger::log(uint8_t id, int16_t first, int16_t second, int16_t third) {
+  push(id, 3, first, second, third);
+}
+
+void Logger::service() {
+  while (true) {
+    if (lineSent >= lineLength) {
+      // Start the next line, the drop count goes first so it is not lost behind a full buffer
+      lineLength = 0;
+      lineSent = 0;
+      if (unreportedDrops > 0) {
+        appendText(DROPPED_TEXT, true);
+        appendNumber(unreportedDrops);
+        unreportedDrops = 0;
+      } else if (count > 0) {
+        formatMessage(ring[head]);
+        head = (head + 1) % capacity;
+        count--;
+      } else {
+        return;
+      }
+      line[lineLength++] = '\r';
+      line[lineLength++] = '\n';
+    }
+
+    int room = Serial.availableForWrite();
+    if (room <= 0) {
+      return;
+    }
+    uint8_t length = min(room, lineLength - lineSent);
+    lineSent += Serial.write((const uint8_t*)line + lineSent, length);
+  }
+}
+
+uint32_t Logger::getDropped() {
+  return dropped;
+}
+
+int Logger::getRAMBytes() {
+  return capacity * sizeof(Message) + LINE_BYTES;
+}
+
+void Logger::push(uint8_t id, uint8_t argumentCount, int16_t first, int16_t second, int16_t third) {
+  if (count >= capacity) {
+    dropped++;
+    if (unreportedDrops < 0xFFFF) {
+      unreportedDrops++;
+    }
+    return;
+  }
+  Message& message = ring[(head + count) % capacity];
+  message.id = id;
+  message.argumentCount = argumentCount;
+  message.arguments[0] = first;
+  message.arguments[1] = second;
+  message.arguments[2] = third;
+  count++;
+}
+
+void Logger::formatMessage(const Message& message) {
+  // Skip the texts of the IDs before this one
+  const char* text = messages;
+  for (uint8_t id = 0; id < message.id; id++) {
+    while (pgm_read_byte(text) != '\0') {
+      text++;
+    }
+    text++;
+  }
+  appendText(text, true);
+  for (uint8_t i = 0; i < message.argumentCount; i++) {
+    appendText(" ", false);
+    appendNumber(message.arguments[i]);
+  }
+}
+
+void Logger::appendText(const char* text, bool isInFlash) {
+  // Leave room for the line ending, longer texts are cut short
+  while (lineLength < LINE_BYTES - 2) {
+    char character = isInFlash ? pgm_read_byte(text) : *text;
+    if (character == '\0') {
+      break;
+    }
+    line[lineLength++] = character;
+    text++;
+  }
+}
+
+void Logger::appendNumber(long value) {
+  char digits[7];
+  uint8_t digitCount = 0;
+  bool isNegative = value < 0;
+  if (isNegative) {
+    value = -value;
+  }
+  do {
+    digits[digitCount++] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0);
+  if (isNegative) {
+    digits[digitCount++] = '-';
+  }
+  while (digitCount > 0 && lineLength < LINE_BYTES - 2) {
+    line[lineLength++] = digits[--digitCount];
+  }
+}
@@ -0,0 +1,143 @@
+#include <Arduino.h>
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Messages above LOG_LEVEL compile to no code, their arguments are never evaluated but still
+// count as used. Enabled messages log to the Logger the sketch defines as logger.
+#define LOG_DISABLED(...)      \
+  do {                         \
+    if (false) {               \
+      logger.log(__VA_ARGS__); \
+    }                          \
+  } while (0)
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logger.log(__VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logger.log(__VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logger.log(__VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logger.log(__VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+
+/**
+ * @class Logger
+ * @brief Queues log messages in RAM and sends them to Serial without ever blocking.
+ *
+ * A message is a one byte ID and up to three 16-bit arguments, queued in a ring buffer
+ * in constant time. The text of each ID is only looked up when the message is sent:
+ * the texts are a single string in flash, one per ID in order, each ending with '\0'.
+ * service sends at most as many bytes as the hardware TX buffer has room for, so
+ * logging never waits for the serial port. Messages logged while the ring buffer is
+ * full are dropped and counted, the count is sent once there is room again.
+ *
+ * Memory: 8 bytes per queued message plus a LINE_BYTES line buffer, e.g. 176 bytes for
+ * 16 messages.
+ */
+class Logger {
+public:
+  static const uint8_t LINE_BYTES = 48;
+
+  /**
+   * @brief Constructs an empty logger.
+   * @param capacity The number of messages the ring buffer holds.
+   * @param messages The texts of the message IDs in flash (PROGMEM), each ending with '\0'.
+   */
+  Logger(uint8_t capacity, const char* messages);
+
+  /**
+   * @brief Queues a message without arguments.
+   * @param id The ID of the message.
+   */
+  void log(uint8_t id);
+
+  /**
+   * @brief Queues a message with one argument.
+   * @param id The ID of the message.
+   * @param argument Printed after the text.
+   */
+  void log(uint8_t id, int16_t argument);
+
+  /**
+   * @brief Queues a message with two arguments.
+   * @param id The ID of the message.
+   * @param first Printed after the text.
+   * @param second Printed after the first argument.
+   */
+  void log(uint8_t id, int16_t first, int16_t second);
+
+  /**
+   * @brief Queues a message with three arguments.
+   * @param id The ID of the message.
+   * @param first Printed after the text.
+   * @param second Printed after the first argument.
+   * @param third Printed after the second argument.
+   */
+  void log(uint8_t id, int16_t first, int16_t second, int16_t third);
+
+  /**
+   * @brief Sends queued messages as far as the serial TX buffer has room.
+   * @note Call this every frame, it never blocks.
+   */
+  void service();
+
+  /**
+   * @brief Gets the number of messages dropped because the ring buffer was full.
+   * @return The number of dropped messages since startup.
+   */
+  uint32_t getDropped();
+
+  /**
+   * @brief Gets the number of bytes of RAM used by the logger.
+   * @return The RAM used in bytes.
+   */
+  int getRAMBytes();
+
+private:
+  struct Message {
+    uint8_t id;
+    uint8_t argumentCount;
+    int16_t arguments[3];
+  };
+
+  const char* messages;
+  Message* ring;
+  uint8_t capacity;
+  uint8_t head = 0;  // Next message to send
+  uint8_t count = 0; // Messages queued
+  uint32_t dropped = 0;
+  uint16_t unreportedDrops = 0;
+
+  // The line being sent, a few bytes per frame
+  char line[LINE_BYTES];
+  uint8_t lineLength = 0;
+  uint8_t lineSent = 0;
+
+  void push(uint8_t id, uint8_t argumentCount, int16_t first, int16_t second, int16_t third);
+  void formatMessage(const Message& message);
+  void appendText(const char* text, bool isInFlash);
+  void appendNumber(long value);
+};
+
+#endif
@@ -1,15 +1,103 @@
 #include <Arduino.h>
 #include <EEPROM.h>
+#include <Crc8.hpp>
 #include "Maze.hpp"
 
-Maze::Maze(int rows, int columns) : mazeRows(rows), mazeColumns(columns) {
-  // Initialize the maze
-  maze = new uint8_t*[mazeRows];
-  for (int i = 0; i < mazeRows; i++) {
-    maze[i] = new uint8_t[mazeColumns];
+Maze::Maze(int rows, int columns) : mazeRows(rows), mazeColumns(columns), cellColumns(columns / 2) {
+  // Initialize the maze, only cells are stored and every cell starts as a wall
+  cells = new uint8_t[(mazeRows / 2) * (mazeColumns / 2)]();
+}
+
+Maze::Maze(int rows, int columns, TileCache* tileCache)
+    : mazeRows(rows), mazeColumns(columns), cellColumns(columns / 2), tileCache(tileCache) {
+  tileCache->configure(mazeRows, mazeColumns);
+}
+
+uint8_t Maze::getCell(int row, int column) {
+  if (tileCache != nullptr) {
+    return tileCache->read(row, column);
+  }
+  return readCell(cells, row, column);
+}
+
+void Maze::setCell(int row, int column, uint8_t value) {
+  if (tileCache != nullptr) {
+    tileCache->write(row, column, value);
+  } else {
+    writeCell(cells, row, column, value);
+  }
+}
+
+int Maze::getCellIndex(int row, int column) {
+  // Coordinates are never negative, so halving is a shift
+  return (row >> 1) * cellColumns + (column >> 1);
+}
+
+uint8_t Maze::readCell(const uint8_t* cellMasks, int row, int column) {
+  uint8_t isOpen;
+  if (row & 1) {
+    if (column & 1) {
+      isOpen = cellMasks[getCellIndex(row, column)] & CELL_OPEN;
+    } else {
+      // Wall between two cells of a row, stored in the cell on its left or, on the border, on its right
+      isOpen = column > 0 ? cellMasks[getCellIndex(row, column - 1)] & MAZE_RIGHT
+                          : cellMasks[getCellIndex(row, column + 1)] & MAZE_LEFT;
+    }
+  } else if (column & 1) {
+    // Wall between two cells of a column, stored in the cell above or, on the border, below
+    isOpen = row > 0 ? cellMasks[getCellIndex(row - 1, column)] & MAZE_DOWN
+                     : cellMasks[getCellIndex(row + 1, column)] & MAZE_UP;
+  } else {
+    isOpen = 0; // Corners between cells are always walls
+  }
+
+  if (!isOpen) {
+    return WALL;
+  }
+  if (row != 0 && row != mazeRows - 1) {
+    return EMPTY; // Start and end are in the first and last row
+  }
+  MazePosition startPosition = getStartPosition();
+  MazePosition endPosition = getEndPosition();
+  if (row == startPosition.row && column == startPosition.column) {
+    return START;
+  }
+  if (row == endPosition.row && column == endPosition.column) {
+    return END;
+  }
+  return EMPTY;
+}
+
+void Maze::writeCell(uint8_t* cellMasks, int row, int column, uint8_t value) {
+  // Start and end are open cells, found again from their position when read
+  bool isOpen = value != WALL;
+  if (row & 1) {
+    if (column & 1) {
+      setCellBit(cellMasks, row, column, CELL_OPEN, isOpen);
+      return;
+    }
+    // Both cells on the sides of the wall know the passage
+    if (column > 0) {
+      setCellBit(cellMasks, row, column - 1, MAZE_RIGHT, isOpen);
+    }
+    if (column + 1 < mazeColumns) {
+      setCellBit(cellMasks, row, column + 1, MAZE_LEFT, isOpen);
+    }
+  } else if (column & 1) {
+    if (row > 0) {
+      setCellBit(cellMasks, row - 1, column, MAZE_DOWN, isOpen);
+    }
+    if (row + 1 < mazeRows) {
+      setCellBit(cellMasks, row + 1, column, MAZE_UP, isOpen);
+    }
   }
 }
 
+void Maze::setCellBit(uint8_t* cellMasks, int row, int column, uint8_t bit, bool isSet) {
+  uint8_t& mask = cellMasks[getCellIndex(row, column)];
+  mask = isSet ? mask | bit : mask & ~bit;
+}
+
 int Maze::getRows() {
   return mazeRows;
 }
@@ -18,6 +106,10 @@ int Maze::getColumns() {
   return mazeColumns;
 }
 
+uint16_t Maze::getRevision() {
+  return revision;
+}
+
 MazePosition Maze::getStartPosition() {
   MazePosition startPosition = {0, 1};
   return startPosition;
@@ -25,13 +117,17 @@ MazePosition Maze::getStartPosition() {
 
 MazePosition Maze::getEndPosition() {
   MazePosition endPosition = {mazeRows - 1, mazeColumns - 2};
+  // A closed bottom wall (odd rows) is only next to cells at odd columns
+  if (mazeRows % 2 == 1 && endPosition.column % 2 == 0) {
+    endPosition.column--;
+  }
   return endPosition;
 }
   
 void Maze::printToSerial() {
   for (int i = 0; i < mazeRows; i++) {
     for (int j = 0; j < mazeColumns; j++) {
-      if (maze[i][j] == WALL) {
+      if (getCell(i, j) == WALL) {
         Serial.print(WALL_CHAR);
       } else {
         Serial.print(EMPTY_CHAR);
@@ -43,23 +139,7 @@ void Maze::printToSerial() {
 
 void Maze::printToSerialWithPlayer(int playerRow, int playerColumn) {
   for (int i = 0; i < mazeRows; i++) {
-    for (int j = 0; j < mazeColumns; j++) {
-      if (i == playerRow && j == playerColumn) {
-        Serial.print(PLAYER_CHAR);
-      } 
-      else if (maze[i][j] == END) {
-        Serial.print(END_CHAR);
-      }
-      else if (maze[i][j] == START) {
-        Serial.print(START_CHAR);
-      }
-      else if (maze[i][j] == WALL) {
-        Serial.print(WALL_CHAR);
-      } else {
-        Serial.print(EMPTY_CHAR);
-      }
-    }
-    Serial.println();
+    printRowToSerial(i, playerRow, playerColumn);
   }
 }
 
@@ -67,22 +147,123 @@ void Maze::printToSerialWithPlayer(MazePosition playerPosition) {
   printToSerialWithPlayer(playerPosition.row, playerPosition.column);
 }
 
+void Maze::beginPrintToSerial(MazePosition playerPosition) {
+  printRow = 0;
+  printPlayerPosition = playerPosition;
+}
+
+bool Maze::stepPrintToSerial() {
+  if (printRow < 0) {
+    return true;
+  }
+  // A row and its line break, rows wider than the transmit buffer of the serial port wait for it
+  if (Serial.availableForWrite() < min(mazeColumns + 2, SERIAL_TX_BYTES)) {
+    return false;
+  }
+  printRowToSerial(printRow, printPlayerPosition.row, printPlayerPosition.column);
+  if (++printRow < mazeRows) {
+    return false;
+  }
+  printRow = -1;
+  return true;
+}
+
+void Maze::printRowToSerial(int row, int playerRow, int playerColumn) {
+  // Characters are written in chunks rather than one at a time
+  char chunk[16];
+  uint8_t length = 0;
+  for (int j = 0; j < mazeColumns; j++) {
+    uint8_t cell = getCell(row, j);
+    if (row == playerRow && j == playerColumn) {
+      chunk[length++] = PLAYER_CHAR;
+    } else if (cell == END) {
+      chunk[length++] = END_CHAR;
+    } else if (cell == START) {
+      chunk[length++] = START_CHAR;
+    } else if (cell == WALL) {
+      chunk[length++] = WALL_CHAR;
+    } else {
+      chunk[length++] = EMPTY_CHAR;
+    }
+    if (length == sizeof(chunk)) {
+      Serial.write((const uint8_t*)chunk, length);
+      length = 0;
+    }
+  }
+  Serial.write((const uint8_t*)chunk, length);
+  Serial.println();
+}
+
 void Maze::saveToEEPROM() {
-  int address = EEPROM_START_ADDRESS;
+  beginSaveToEEPROM();
+  while (!stepSaveToEEPROM(mazeRows * mazeColumns + 1)) {
+  }
+}
+
+void Maze::beginSaveToEEPROM() {
+  saveIndex = 0;
+  saveChecksum = 0;
+}
+
+bool Maze::stepSaveToEEPROM(int maxBytes) {
+  if (saveIndex < 0) {
+    return true;
+  }
+  if (tileCache != nullptr) {
+    // Paged mazes already live in the backing store, only dirty tiles need writing,
+    // and the checksum once a call has budget left after the last of them
+    if (tileCache->flushBytes(maxBytes) >= maxBytes) {
+      return false;
+    }
+    tileCache->writeChecksum(calculateChecksum());
+    saveIndex = -1;
+    return true;
+  }
+
+  long cellCount = (long)mazeRows * mazeColumns;
+  for (int n = 0; n < maxBytes && saveIndex < cellCount; n++, saveIndex++) {
+    uint8_t cell = getCell(saveIndex / mazeColumns, saveIndex % mazeColumns);
+    EEPROM.write(EEPROM_START_ADDRESS + saveIndex, cell);
+    saveChecksum ^= cell;
+  }
+  if (saveIndex < cellCount) {
+    return false;
+  }
+  // The checksum is written last so an interrupted save never loads
+  EEPROM.write(EEPROM_START_ADDRESS + saveIndex, saveChecksum);
+  saveIndex = -1;
+  return true;
+}
+
+uint8_t Maze::calculateKey() {
+  // CRC of the walls that may be carved, 8 per byte, in the order of the packed format
+  uint8_t crc = 0;
+  uint8_t walls = 0;
+  uint8_t wallCount = 0;
   for (int i = 0; i < mazeRows; i++) {
-    for (int j = 0; j < mazeColumns; j++) {
-      EEPROM.write(address++, maze[i][j]);
+    for (int j = (i + 1) % 2; j < mazeColumns; j += 2) {
+      walls = walls << 1 | isCollision(i, j);
+      if (++wallCount == 8) {
+        crc = crc8(crc, &walls, 1);
+        walls = 0;
+        wallCount = 0;
+      }
     }
   }
-  uint8_t checksum = calculateChecksum();
-  EEPROM.write(address, checksum);
+  return crc8(crc, &walls, 1);
 }
 
 bool Maze::loadFromEEPROM() {
+  revision++;
+  if (tileCache != nullptr) {
+    tileCache->invalidate();
+    isMazeInitialized = tileCache->readChecksum() == calculateChecksum();
+    return isMazeInitialized;
+  }
   int address = EEPROM_START_ADDRESS;
   for (int i = 0; i < mazeRows; i++) {
     for (int j = 0; j < mazeColumns; j++) {
-      maze[i][j] = EEPROM.read(address++);
+      setCell(i, j, EEPROM.read(address++));
     }
   }
   uint8_t storedChecksum = EEPROM.read(address);
@@ -98,7 +279,7 @@ uint8_t Maze::calculateChecksum() {
   uint8_t checksum = 0;
   for (int i = 0; i < mazeRows; i++) {
     for (int j = 0; j < mazeColumns; j++) {
-      checksum ^= maze[i][j];
+      checksum ^= getCell(i, j);
     }
   }
   return checksum;
@@ -110,7 +291,7 @@ void Maze::getSubMaze(int startRow, int startColumn, int numRows, int numColumns
       int mazeRow = startRow + i;
       int mazeCol = startColumn + j;
       if (mazeRow >= 0 && mazeRow < mazeRows && mazeCol >= 0 && mazeCol < mazeColumns && isMazeInitialized) {
-        subMaze[i][j] = maze[mazeRow][mazeCol];
+        subMaze[i][j] = getCell(mazeRow, mazeCol);
       } else {
         subMaze[i][j] = 0; // Pad with zeros if out of bounds
       }
@@ -119,98 +300,244 @@ void Maze::getSubMaze(int startRow, int startColumn, int numRows, int numColumns
 }
 
 bool Maze::isCollision(int row, int column) {
-  if (!isMazeInitialized) {
-    return true;
-  }
-  if (row >= 0 && row < mazeRows && column >= 0 && column < mazeColumns && isMazeInitialized) {
-    return maze[row][column] == WALL;
-  } else {
+  if (!isMazeInitialized || row < 0 || row >= mazeRows || column < 0 || column >= mazeColumns) {
     return true; // Treat out of bounds as a wall
   }
+  return getCell(row, column) == WALL;
+}
+
+uint8_t Maze::getOpenDirections(int row, int column) {
+  if (isMazeInitialized && tileCache == nullptr && row % 2 == 1 && column % 2 == 1 && row < mazeRows && column < mazeColumns) {
+    // Out of bounds neighbours of a cell are never carved, so the stored mask is complete
+    uint8_t mask = cells[getCellIndex(row, column)];
+    return mask & CELL_OPEN ? mask & (MAZE_UP | MAZE_RIGHT | MAZE_DOWN | MAZE_LEFT) : 0;
+  }
+  if (isCollision(row, column)) {
+    return 0;
+  }
+  uint8_t directions = 0;
+  if (!isCollision(row - 1, column)) {
+    directions |= MAZE_UP;
+  }
+  if (!isCollision(row, column + 1)) {
+    directions |= MAZE_RIGHT;
+  }
+  if (!isCollision(row + 1, column)) {
+    directions |= MAZE_DOWN;
+  }
+  if (!isCollision(row, column - 1)) {
+    directions |= MAZE_LEFT;
+  }
+  return directions;
+}
+
+bool Maze::canMove(int row, int column, uint8_t direction) {
+  return getOpenDirections(row, column) & direction;
+}
+
+MazePosition Maze::step(MazePosition position, uint8_t direction) {
+  if (direction == MAZE_UP) {
+    position.row--;
+  } else if (direction == MAZE_RIGHT) {
+    position.column++;
+  } else if (direction == MAZE_DOWN) {
+    position.row++;
+  } else if (direction == MAZE_LEFT) {
+    position.column--;
+  }
+  return position;
+}
+
+uint8_t Maze::getOppositeDirection(uint8_t direction) {
+  // Up and down, right and left are two bits apart
+  return ((direction << 2) | (direction >> 2)) & (MAZE_UP | MAZE_RIGHT | MAZE_DOWN | MAZE_LEFT);
 }
 
 void Maze::generateMaze() {
+  beginGeneration();
+  while (!stepGeneration(mazeRows * mazeColumns)) {
+  }
+}
+
+void Maze::generateMaze(uint32_t seed) {
+  beginGeneration(false, seed);
+  while (!stepGeneration(mazeRows * mazeColumns)) {
+  }
+}
+
+void Maze::beginGeneration(bool intoBackBuffer) {
+  // Mix analog noise with the time so consecutive mazes get different seeds
+  beginGeneration(intoBackBuffer, ((uint32_t)analogRead(0) << 16) ^ micros());
+}
+
+void Maze::beginGeneration(bool intoBackBuffer, uint32_t seed) {
   // Based on the recursive backtracking algorithm implementation found here: 
   // https://github.com/professor-l/mazes/blob/master/scripts/backtracking.js
 
-  // Seed the random number generator
-  randomSeed(analogRead(0));
-  
-  // Fill maze with walls (1s)
-  for (int i = 0; i < mazeRows; i++) {
-    for (int j = 0; j < mazeColumns; j++) {
-      maze[i][j] = WALL;
-    }
+  isGeneratingIntoBackBuffer = intoBackBuffer && backCells != nullptr;
+  if (isGeneratingIntoBackBuffer) {
+    isBackBufferComplete = false;
+    backSeed = seed;
+  } else {
+    this->seed = seed;
+    revision++;
+    isMazeInitialized = false;
   }
-  
-  // Create entrance
-  MazePosition startPosition = getStartPosition();
-  maze[startPosition.row][startPosition.column] = START;
-  
-  // Choose a random starting cell (must be odd coordinates)
-  int startRow, startCol;
-  do {
-    startRow = random(1, mazeRows);
-  } while (startRow % 2 == 0);
-  
-  do {
-    startCol = random(1, mazeColumns);
-  } while (startCol % 2 == 0);
-  
-  maze[startRow][startCol] = EMPTY;
-  
-  // Create stack for backtracking
-  const int MAX_STACK_SIZE = 100; // Adjust based on expected maze size
-  int stackRow[MAX_STACK_SIZE];
-  int stackCol[MAX_STACK_SIZE];
-  int stackSize = 0;
-  
-  // Push starting cell to stack
-  stackRow[stackSize] = startRow;
-  stackCol[stackSize] = startCol;
-  stackSize++;
-  
-  while (stackSize > 0) {
+
+  // Seed the random number generator, zero would make xorshift return zeros forever
+  randomState = seed != 0 ? seed : 0x9E3779B9;
+
+  // Create stack for backtracking, every cell can be on the stack at most once.
+  // Cells are stored as a single index to halve the memory of separate row and column stacks.
+  if (generationStack == nullptr) {
+    generationStack = new uint16_t[(mazeRows / 2) * (mazeColumns / 2)];
+  }
+  generationStackSize = 0;
+  generationRow = 0;
+  visitedCells = 0;
+  generationPhase = GENERATION_FILLING;
+}
+
+bool Maze::stepGeneration(int maxSteps) {
+  return stepGeneration(maxSteps, INT16_MAX);
+}
+
+bool Maze::stepGeneration(int maxSteps, int maxBytes) {
+  int cellColumns = mazeColumns / 2;
+  // A step modifies at most 2 tiles, and a slot left clean serves the tiles it only reads
+  const uint8_t generationCleanSlots = 3;
+
+  for (int step = 0; step < maxSteps; step++) {
+    if (generationPhase == GENERATION_IDLE) {
+      return true;
+    }
+
+    // Evicting a modified tile would write all of it back at once, so the oldest are
+    // written back within the budget and generation waits until enough slots are clean
+    if (tileCache != nullptr && !tileCache->hasCleanSlots(generationCleanSlots)) {
+      maxBytes -= tileCache->flushBytes(maxBytes);
+      if (!tileCache->hasCleanSlots(generationCleanSlots)) {
+        return false;
+      }
+    }
+
+    if (generationPhase == GENERATION_FILLING) {
+      // Fill one row of the maze with walls (1s), in RAM only rows of cells are stored
+      uint8_t* generationCells = isGeneratingIntoBackBuffer ? backCells : cells;
+      if (generationCells != nullptr) {
+        if (generationRow & 1) {
+          memset(&generationCells[getCellIndex(generationRow, 0)], 0, cellColumns);
+        }
+        generationRow++;
+        if (generationRow < mazeRows) {
+          continue;
+        }
+      } else if (generationRow < tileCache->getTileCount()) {
+        // Paged mazes fill a whole tile per step, without reading it first
+        tileCache->fill(generationRow++, WALL);
+        continue;
+      }
+
+      // Create entrance
+      MazePosition startPosition = getStartPosition();
+      setGenerationCell(startPosition.row, startPosition.column, START);
+      
+      // Choose a random starting cell (must be odd coordinates)
+      int startRow, startCol;
+      do {
+        startRow = nextRandom(1, mazeRows);
+      } while (startRow % 2 == 0);
+      
+      do {
+        startCol = nextRandom(1, mazeColumns);
+      } while (startCol % 2 == 0);
+      
+      setGenerationCell(startRow, startCol, EMPTY);
+      visitedCells = 1;
+      
+      // Push starting cell to stack
+      generationStack[generationStackSize] = (startRow / 2) * cellColumns + startCol / 2;
+      generationStackSize++;
+      generationPhase = GENERATION_CARVING;
+      continue;
+    }
+
+    if (generationPhase == GENERATION_CARVING && generationStackSize == 0) {
+      // Create exit at the bottom
+      MazePosition endPosition = getEndPosition();
+      setGenerationCell(endPosition.row, endPosition.column, END);
+      braidStats = {0, 0, 0, 0};
+      generationRow = 1;
+      generationColumn = 1;
+      generationPhase = GENERATION_BRAIDING;
+    }
+
+    if (generationPhase == GENERATION_BRAIDING) {
+      // Braid one row of cells per step, or a single cell in paged mazes
+      if (braidPercent > 0 && generationRow < mazeRows) {
+        if (tileCache == nullptr) {
+          braidRow(generationRow, 1, mazeColumns);
+          generationRow += 2;
+          continue;
+        }
+        braidRow(generationRow, generationColumn, generationColumn + 1);
+        generationColumn += 2;
+        if (generationColumn >= mazeColumns) {
+          generationColumn = 1;
+          generationRow += 2;
+        }
+        continue;
+      }
+      generationPhase = GENERATION_IDLE;
+      if (isGeneratingIntoBackBuffer) {
+        isBackBufferComplete = true;
+      } else {
+        isMazeInitialized = true;
+        revision++; // The maze changed again since beginGeneration
+      }
+      return true;
+    }
+
     // Get current cell from top of stack
-    int row = stackRow[stackSize - 1];
-    int col = stackCol[stackSize - 1];
+    int row = generationStack[generationStackSize - 1] / cellColumns * 2 + 1;
+    int col = generationStack[generationStackSize - 1] % cellColumns * 2 + 1;
     
     // Find unvisited neighbors
     int neighborDirections[4] = {0}; // 0: none, 1: possible direction
     int neighborCount = 0;
     
     // Check up
-    if (row >= 2 && maze[row-2][col] == WALL) {
+    if (row >= 2 && isUnvisitedCell(row-2, col)) {
       neighborDirections[0] = 1;
       neighborCount++;
     }
     
     // Check right
-    if (col < mazeColumns-2 && maze[row][col+2] == WALL) {
+    if (col < mazeColumns-2 && isUnvisitedCell(row, col+2)) {
       neighborDirections[1] = 1;
       neighborCount++;
     }
     
     // Check down
-    if (row < mazeRows-2 && maze[row+2][col] == WALL) {
+    if (row < mazeRows-2 && isUnvisitedCell(row+2, col)) {
       neighborDirections[2] = 1;
       neighborCount++;
     }
     
     // Check left
-    if (col >= 2 && maze[row][col-2] == WALL) {
+    if (col >= 2 && isUnvisitedCell(row, col-2)) {
       neighborDirections[3] = 1;
       neighborCount++;
     }
     
     // If no unvisited neighbors, backtrack
     if (neighborCount == 0) {
-      stackSize--;
+      generationStackSize--;
       continue;
     }
     
     // Choose a random direction
-    int chosen = random(0, neighborCount);
+    int chosen = nextRandom(0, neighborCount);
     int directionIndex = -1;
     
     for (int i = 0; i < 4; i++) {
@@ -230,33 +557,271 @@ void Maze::generateMaze() {
     switch (directionIndex) {
       case 0: // Up
         newRow -= 2;
-        maze[row-1][col] = EMPTY; // Remove wall between cells
+        setGenerationCell(row-1, col, EMPTY); // Remove wall between cells
         break;
       case 1: // Right
         newCol += 2;
-        maze[row][col+1] = EMPTY;
+        setGenerationCell(row, col+1, EMPTY);
         break;
       case 2: // Down
         newRow += 2;
-        maze[row+1][col] = EMPTY;
+        setGenerationCell(row+1, col, EMPTY);
         break;
       case 3: // Left
         newCol -= 2;
-        maze[row][col-1] = EMPTY;
+        setGenerationCell(row, col-1, EMPTY);
         break;
     }
     
     // Mark the new cell as empty
-    maze[newRow][newCol] = EMPTY;
+    setGenerationCell(newRow, newCol, EMPTY);
+    visitedCells++;
     
     // Push the new cell onto the stack
-    stackRow[stackSize] = newRow;
-    stackCol[stackSize] = newCol;
-    stackSize++;
+    generationStack[generationStackSize] = (newRow / 2) * cellColumns + newCol / 2;
+    generationStackSize++;
   }
-  
-  // Create exit at the bottom
+  return generationPhase == GENERATION_IDLE;
+}
+
+void Maze::setBraiding(uint8_t percent) {
+  braidPercent = min(percent, (uint8_t)100);
+}
+
+BraidStats Maze::getBraidStats() {
+  return braidStats;
+}
+
+uint8_t Maze::getGenerationDirections(int row, int column) {
+  uint8_t* generationCells = isGeneratingIntoBackBuffer ? backCells : cells;
+  if (generationCells != nullptr) {
+    return generationCells[getCellIndex(row, column)] & (MAZE_UP | MAZE_RIGHT | MAZE_DOWN | MAZE_LEFT);
+  }
+  uint8_t directions = 0;
+  if (row > 0 && getGenerationCell(row - 1, column) != WALL) {
+    directions |= MAZE_UP;
+  }
+  if (column + 1 < mazeColumns && getGenerationCell(row, column + 1) != WALL) {
+    directions |= MAZE_RIGHT;
+  }
+  if (row + 1 < mazeRows && getGenerationCell(row + 1, column) != WALL) {
+    directions |= MAZE_DOWN;
+  }
+  if (column > 0 && getGenerationCell(row, column - 1) != WALL) {
+    directions |= MAZE_LEFT;
+  }
+  return directions;
+}
+
+void Maze::braidRow(int row, int firstColumn, int endColumn) {
+  uint32_t startMicros = micros();
+  for (int column = firstColumn; column < endColumn; column += 2) {
+    // A dead end has a single open direction, the mask of every cell tells at once
+    uint8_t directions = getGenerationDirections(row, column);
+    if (directions == 0 || (directions & (directions - 1)) != 0) {
+      continue;
+    }
+    braidStats.deadEndsBefore++;
+    if (nextRandom(0, 100) >= braidPercent) {
+      braidStats.deadEndsAfter++;
+      continue;
+    }
+
+    // Open a wall to a neighbouring cell, preferably another dead end so both go at once
+    uint8_t walls = 0;
+    uint8_t deadEndWalls = 0;
+    MazePosition position = {row, column};
+    for (uint8_t direction = MAZE_UP; direction <= MAZE_LEFT; direction <<= 1) {
+      MazePosition neighbour = step(step(position, direction), direction);
+      if ((directions & direction) || neighbour.row < 1 || neighbour.row >= mazeRows || neighbour.column < 1 ||
+          neighbour.column >= mazeColumns) {
+        continue;
+      }
+      walls |= direction;
+      uint8_t neighbourDirections = getGenerationDirections(neighbour.row, neighbour.column);
+      if (neighbourDirections != 0 && (neighbourDirections & (neighbourDirections - 1)) == 0) {
+        deadEndWalls |= direction;
+      }
+    }
+    if (deadEndWalls != 0) {
+      walls = deadEndWalls;
+    }
+    int wallCount = 0;
+    for (uint8_t direction = MAZE_UP; direction <= MAZE_LEFT; direction <<= 1) {
+      wallCount += (walls & direction) != 0;
+    }
+    if (wallCount == 0) {
+      continue;
+    }
+    int chosen = nextRandom(0, wallCount);
+    uint8_t direction = MAZE_UP;
+    while (!(walls & direction) || chosen-- > 0) {
+      direction <<= 1;
+    }
+
+    MazePosition passage = step(position, direction);
+    setGenerationCell(passage.row, passage.column, EMPTY);
+    braidStats.loops++;
+    if (deadEndWalls != 0 && (direction == MAZE_RIGHT || direction == MAZE_DOWN)) {
+      braidStats.deadEndsBefore++; // Not scanned yet, and no longer a dead end when it is
+    } else if (deadEndWalls != 0) {
+      braidStats.deadEndsAfter--; // Scanned and left as a dead end before
+    }
+  }
+  braidStats.micros += micros() - startMicros;
+}
+
+bool Maze::isGenerating() {
+  return generationPhase != GENERATION_IDLE && !isGeneratingIntoBackBuffer;
+}
+
+bool Maze::isGeneratingBackBuffer() {
+  return generationPhase != GENERATION_IDLE && isGeneratingIntoBackBuffer;
+}
+
+bool Maze::enableBackBuffer() {
+  if (tileCache != nullptr) {
+    return false; // The backing store only holds a single maze
+  }
+  if (backCells == nullptr) {
+    backCells = new uint8_t[(mazeRows / 2) * (mazeColumns / 2)]();
+  }
+  return true;
+}
+
+long Maze::getBackBufferBytes() {
+  if (backCells == nullptr) {
+    return 0;
+  }
+  return (long)(mazeRows / 2) * (mazeColumns / 2);
+}
+
+long Maze::getRAMBytes() {
+  const long allocationOverhead = sizeof(size_t); // malloc keeps the size of each block
+  long bytes = 0;
+  if (tileCache == nullptr) {
+    bytes += (long)(mazeRows / 2) * (mazeColumns / 2) + allocationOverhead;
+  }
+  if (backCells != nullptr) {
+    bytes += getBackBufferBytes() + allocationOverhead;
+  }
+  if (generationStack != nullptr) {
+    bytes += (long)(mazeRows / 2) * (mazeColumns / 2) * sizeof(uint16_t) + allocationOverhead;
+  }
+  return bytes;
+}
+
+long Maze::getRAMBytes(int rows, int columns, bool withBackBuffer) {
+  const long allocationOverhead = sizeof(size_t);
+  long gridBytes = (long)(rows / 2) * (columns / 2) + allocationOverhead;
+  long stackBytes = (long)(rows / 2) * (columns / 2) * sizeof(uint16_t) + allocationOverhead;
+  return gridBytes * (withBackBuffer ? 2 : 1) + stackBytes;
+}
+
+bool Maze::isBackBufferReady() {
+  return isBackBufferComplete;
+}
+
+bool Maze::swapBuffers() {
+  if (!isBackBufferComplete) {
+    return false;
+  }
+  uint8_t* previousCells = cells;
+  cells = backCells;
+  backCells = previousCells;
+  seed = backSeed;
+  isBackBufferComplete = false;
+  isMazeInitialized = true;
+  revision++;
+  return true;
+}
+
+uint32_t Maze::getSeed() {
+  return seed;
+}
+
+int Maze::getPackedSize() {
+  // Cells with exactly one odd coordinate are the walls that may be carved
+  long carvableCells = (long)(mazeRows / 2) * ((mazeColumns + 1) / 2) + (long)((mazeRows + 1) / 2) * (mazeColumns / 2);
+  return (carvableCells + 7) / 8;
+}
+
+void Maze::pack(uint8_t* packedMaze) {
+  for (int i = 0; i < getPackedSize(); i++) {
+    packedMaze[i] = 0;
+  }
+  long bit = 0;
+  for (int i = 0; i < mazeRows; i++) {
+    for (int j = (i + 1) % 2; j < mazeColumns; j += 2) {
+      if (getCell(i, j) == WALL) {
+        packedMaze[bit / 8] |= 1 << (bit % 8);
+      }
+      bit++;
+    }
+  }
+}
+
+void Maze::loadFromPack(const uint8_t* packedMaze, uint32_t seed) {
+  revision++;
+  this->seed = seed;
+  long bit = 0;
+  for (int i = 0; i < mazeRows; i++) {
+    for (int j = 0; j < mazeColumns; j++) {
+      if (i % 2 == 1 && j % 2 == 1) {
+        setCell(i, j, EMPTY); // Cells are always open
+      } else if (i % 2 == 0 && j % 2 == 0) {
+        setCell(i, j, WALL); // Corners between cells are always walls
+      } else {
+        bool isWall = (pgm_read_byte(&packedMaze[bit / 8]) >> (bit % 8)) & 1;
+        setCell(i, j, isWall ? WALL : EMPTY);
+        bit++;
+      }
+    }
+  }
+  MazePosition startPosition = getStartPosition();
+  setCell(startPosition.row, startPosition.column, START);
   MazePosition endPosition = getEndPosition();
-  maze[endPosition.row][endPosition.column] = END;
+  setCell(endPosition.row, endPosition.column, END);
   isMazeInitialized = true;
-}
\ No newline at end of file
+}
+
+long Maze::nextRandom(long min, long max) {
+  // xorshift32, the same sequence on every platform so seeds reproduce the same maze anywhere
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return min + randomState % (uint32_t)(max - min);
+}
+
+uint8_t Maze::getGenerationCell(int row, int column) {
+  if (isGeneratingIntoBackBuffer) {
+    return readCell(backCells, row, column);
+  }
+  return getCell(row, column);
+}
+
+void Maze::setGenerationCell(int row, int column, uint8_t value) {
+  if (isGeneratingIntoBackBuffer) {
+    writeCell(backCells, row, column, value);
+  } else {
+    setCell(row, column, value);
+  }
+}
+
+bool Maze::isUnvisitedCell(int row, int column) {
+  uint8_t* generationCells = isGeneratingIntoBackBuffer ? backCells : cells;
+  if (generationCells != nullptr) {
+    return !(generationCells[getCellIndex(row, column)] & CELL_OPEN);
+  }
+  return getGenerationCell(row, column) == WALL;
+}
+
+uint8_t Maze::getGenerationProgress() {
+  if (generationPhase == GENERATION_IDLE) {
+    return 100;
+  }
+  if (generationPhase == GENERATION_FILLING) {
+    return 0;
+  }
+  return (long)visitedCells * 100 / ((mazeRows / 2) * (mazeColumns / 2));
+}
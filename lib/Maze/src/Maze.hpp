@@ -2,19 +2,44 @@
 #ifndef MAZE_HPP
 #define MAZE_HPP
 
+#include "TileCache.hpp"
+
 const uint8_t START = 3;
 const uint8_t END = 2;
 const uint8_t WALL = 1;
 const uint8_t EMPTY = 0;
+const uint8_t GHOST = 4; // Never stored, marks the ghost of a previous run in a view
+
+// Directions in a mask of open directions
+const uint8_t MAZE_UP = 1;
+const uint8_t MAZE_RIGHT = 2;
+const uint8_t MAZE_DOWN = 4;
+const uint8_t MAZE_LEFT = 8;
 
 struct MazePosition {
   int row;
   int column;
 };
 
+/**
+ * @brief What the braiding pass of the last generation did.
+ */
+struct BraidStats {
+  uint16_t deadEndsBefore; // Dead ends of the perfect maze
+  uint16_t deadEndsAfter;  // Dead ends left after braiding
+  uint16_t loops;          // Walls opened, each one closes a loop
+  uint32_t micros;         // Time spent braiding
+};
+
 /**
  * @class Maze
  * @brief A class to represent and manipulate a maze.
+ *
+ * Cells sit at odd coordinates and are separated by walls that may be carved into
+ * passages; the positions where four walls meet are always walls. In RAM only the
+ * cells are stored, one byte each, holding the mask of directions open from the cell
+ * and whether the cell is carved. A 16x16 maze takes 64 bytes instead of 256, and
+ * every grid position is decoded from the cell next to it in constant time.
  */
 class Maze {
 public:
@@ -25,6 +50,19 @@ public:
    */
   Maze(int rows, int columns);
 
+  /**
+   * @brief Constructs a Maze object whose grid is paged in from a backing store.
+   * @note No grid is allocated in RAM; every cell access goes through the tile cache,
+   *       so the maze size is limited by the backing store rather than by RAM.
+   * @note saveToEEPROM and loadFromEEPROM flush and reload the backing store instead
+   *       of using the default EEPROM layout.
+   *
+   * @param rows Number of rows in the maze.
+   * @param columns Number of columns in the maze.
+   * @param tileCache The tile cache serving the maze cells.
+   */
+  Maze(int rows, int columns, TileCache* tileCache);
+
   /**
    * @brief Gets the number of rows in the maze.
    * @return The number of rows in the maze.
@@ -37,6 +75,22 @@ public:
    */
   int getColumns();
 
+  /**
+   * @brief Gets the revision of the maze contents.
+   * @note The revision changes every time the maze is generated or loaded, so derived
+   *       data such as caches can detect when it needs to be recomputed.
+   * @return The revision of the maze contents.
+   */
+  uint16_t getRevision();
+
+  /**
+   * @brief Calculates a key that tells mazes apart, for data saved alongside a maze.
+   * @note Unlike the revision the key survives a power cycle: it is a CRC-8 of the walls,
+   *       so it takes one read per wall that may be carved.
+   * @return The key of the maze.
+   */
+  uint8_t calculateKey();
+
   /**
    * @brief Gets the starting position of the maze.
    * @return The starting position of the maze.
@@ -67,6 +121,24 @@ public:
    */
   void printToSerialWithPlayer(MazePosition playerPosition);
 
+  /**
+   * @brief Starts printing the maze with the player to the serial output a row at a time, so
+   *        the print never waits for the serial port.
+   * @note A print still in progress is dropped.
+   *
+   * @param playerPosition The position of the player.
+   */
+  void beginPrintToSerial(MazePosition playerPosition);
+
+  /**
+   * @brief Prints the next row of the print started by beginPrintToSerial, if the serial port
+   *        has room for all of it.
+   * @note Call this every frame, it returns at once when there is nothing to print.
+   *
+   * @return True once the maze is printed, false otherwise.
+   */
+  bool stepPrintToSerial();
+
   /**
    * @brief Saves the maze to EEPROM for use after a power cycle.
    * 
@@ -75,6 +147,22 @@ public:
    */
   void saveToEEPROM();
 
+  /**
+   * @brief Starts saving the maze to EEPROM a few bytes at a time.
+   * @note The maze must not change until stepSaveToEEPROM returns true.
+   */
+  void beginSaveToEEPROM();
+
+  /**
+   * @brief Advances the save started by beginSaveToEEPROM.
+   * @note The checksum is written last, so a save interrupted by a power cycle
+   *       fails to load instead of loading a partial maze.
+   *
+   * @param maxBytes The maximum number of bytes to write in this call.
+   * @return True once the maze is saved, false otherwise.
+   */
+  bool stepSaveToEEPROM(int maxBytes);
+
   /**
    * @brief Loads the maze from EEPROM.
    * @note The maze must have been previously saved to EEPROM.
@@ -110,24 +198,258 @@ public:
    */
   bool isCollision(int row, int column);
 
+  /**
+   * @brief Gets the directions in which the neighbouring positions are open.
+   * @note For a cell held in RAM this is a single lookup of its stored mask.
+   *
+   * @param row The row of the position.
+   * @param column The column of the position.
+   * @return A mask of MAZE_UP, MAZE_RIGHT, MAZE_DOWN and MAZE_LEFT, 0 for walls.
+   */
+  uint8_t getOpenDirections(int row, int column);
+
+  /**
+   * @brief Checks if the player can move one step from a position.
+   * @param row The row of the position.
+   * @param column The column of the position.
+   * @param direction MAZE_UP, MAZE_RIGHT, MAZE_DOWN or MAZE_LEFT.
+   * @return True if the neighbouring position in that direction is open, false otherwise.
+   */
+  bool canMove(int row, int column, uint8_t direction);
+
+  /**
+   * @brief Gets the position one step away in a direction.
+   * @param position The position to step from.
+   * @param direction MAZE_UP, MAZE_RIGHT, MAZE_DOWN or MAZE_LEFT, any other value stays in place.
+   * @return The position reached.
+   */
+  static MazePosition step(MazePosition position, uint8_t direction);
+
+  /**
+   * @brief Gets the direction opposite to a direction.
+   * @param direction MAZE_UP, MAZE_RIGHT, MAZE_DOWN or MAZE_LEFT.
+   * @return The opposite direction.
+   */
+  static uint8_t getOppositeDirection(uint8_t direction);
+
   /**
    * @brief Generates a new maze using the recursive backtracking algorithm.
    */
   void generateMaze();
 
+  /**
+   * @brief Generates a new maze from a seed.
+   * @note The same seed produces the same maze on every platform.
+   * @param seed The seed of the random number generator.
+   */
+  void generateMaze(uint32_t seed);
+
+  /**
+   * @brief Starts generating a new maze one step at a time.
+   * @note When generating into the maze itself, every cell is a collision and getSubMaze
+   *       returns empty cells until stepGeneration returns true, so callers should show
+   *       something else meanwhile.
+   * @note When generating into the back buffer, the current maze stays playable and the
+   *       new maze replaces it when swapBuffers is called.
+   *
+   * @param intoBackBuffer True to generate into the back buffer, if it is enabled.
+   */
+  void beginGeneration(bool intoBackBuffer = false);
+
+  /**
+   * @brief Starts generating a new maze from a seed one step at a time.
+   * @see beginGeneration(bool)
+   *
+   * @param intoBackBuffer True to generate into the back buffer, if it is enabled.
+   * @param seed The seed of the random number generator.
+   */
+  void beginGeneration(bool intoBackBuffer, uint32_t seed);
+
+  /**
+   * @brief Sets how many dead ends the following generations remove by opening one of their walls.
+   * @note Each opened wall closes a loop, so braided mazes have more than one path. Dead ends are
+   *       found in a single scan over the cells, the same seed and percentage give the same maze.
+   *
+   * @param percent 0 for perfect mazes with a single path, 100 to remove every dead end.
+   */
+  void setBraiding(uint8_t percent);
+
+  /**
+   * @brief Gets what the braiding pass of the last complete generation did.
+   * @return The braiding statistics, all zero when braiding is off.
+   */
+  BraidStats getBraidStats();
+
+  /**
+   * @brief Gets the seed the maze was generated from.
+   * @return The seed of the maze.
+   */
+  uint32_t getSeed();
+
+  /**
+   * @brief Gets the size of the maze in the packed format used by maze packs.
+   * @note The packed format stores one bit per cell with exactly one odd coordinate,
+   *       1 for a wall, in row-major order starting at the least significant bit.
+   *       Cells with two odd coordinates are always open and cells with two even
+   *       coordinates are always walls, so they are not stored.
+   * @return The size of a packed maze in bytes.
+   */
+  int getPackedSize();
+
+  /**
+   * @brief Packs the maze into the packed format used by maze packs.
+   * @param packedMaze Receives getPackedSize() bytes.
+   */
+  void pack(uint8_t* packedMaze);
+
+  /**
+   * @brief Loads a maze from a maze pack stored in flash (PROGMEM).
+   * @note No generation is needed, decoding costs a single pass over the maze.
+   *
+   * @param packedMaze The packed maze, getPackedSize() bytes in flash.
+   * @param seed The seed the packed maze was generated from.
+   */
+  void loadFromPack(const uint8_t* packedMaze, uint32_t seed);
+
+  /**
+   * @brief Advances the generation started by beginGeneration.
+   * @note A step fills one row with walls, or carves into or backtracks from one cell,
+   *       so the time spent per call is bounded by maxSteps.
+   * @note Paged mazes write back modified tiles without a byte budget, use
+   *       stepGeneration(int, int) to bound the time spent writing per call.
+   *
+   * @param maxSteps The maximum number of steps to run in this call.
+   * @return True once the maze is complete, false otherwise.
+   */
+  bool stepGeneration(int maxSteps);
+
+  /**
+   * @brief Advances the generation started by beginGeneration, writing back at most a few bytes.
+   * @note Paged mazes fill a tile or braid a cell per step, so a step modifies at most 2 tiles.
+   *       Before each step enough cached tiles are made clean for it to never evict a modified
+   *       one, the least recently used is written back within maxBytes, and generation waits
+   *       for the next call while it is not clean yet. Mazes in RAM ignore maxBytes.
+   *
+   * @param maxSteps The maximum number of steps to run in this call.
+   * @param maxBytes The maximum number of tile bytes written to the backing store in this call.
+   * @return True once the maze is complete, false otherwise.
+   */
+  bool stepGeneration(int maxSteps, int maxBytes);
+
+  /**
+   * @brief Checks if a generation started by beginGeneration is in progress.
+   * @return True if the maze is being generated, false otherwise.
+   */
+  bool isGenerating();
+
+  /**
+   * @brief Checks if a generation into the back buffer is in progress.
+   * @return True if the back buffer is being generated, false otherwise.
+   */
+  bool isGeneratingBackBuffer();
+
+  /**
+   * @brief Allocates a back buffer so the next maze can be generated while this one is played.
+   * @note The back buffer doubles the RAM used by the maze grid.
+   * @return True if the back buffer is available, false for paged mazes.
+   */
+  bool enableBackBuffer();
+
+  /**
+   * @brief Gets the RAM used by the back buffer.
+   * @return The size of the back buffer in bytes, 0 if it is not enabled.
+   */
+  long getBackBufferBytes();
+
+  /**
+   * @brief Gets the heap used by the maze, including the generator stack once allocated.
+   * @return The RAM used in bytes, allocator overhead included.
+   */
+  long getRAMBytes();
+
+  /**
+   * @brief Gets the heap a maze held in RAM needs once it has been generated.
+   * @param rows Number of rows in the maze.
+   * @param columns Number of columns in the maze.
+   * @param withBackBuffer True to include a back buffer.
+   * @return The RAM needed in bytes, allocator overhead included.
+   */
+  static long getRAMBytes(int rows, int columns, bool withBackBuffer);
+
+  /**
+   * @brief Checks if the back buffer holds a complete maze.
+   * @return True if swapBuffers can be called, false otherwise.
+   */
+  bool isBackBufferReady();
+
+  /**
+   * @brief Replaces the maze with the one generated in the back buffer in constant time.
+   * @return True if the buffers were swapped, false if the back buffer is not ready.
+   */
+  bool swapBuffers();
+
+  /**
+   * @brief Gets the progress of the generation in progress.
+   * @return The percentage of cells carved so far, 100 if no generation is in progress.
+   */
+  uint8_t getGenerationProgress();
+
 private:
   int mazeRows;
   int mazeColumns;
-  uint8_t** maze;
+  int cellColumns; // Cells in a row of the maze
+  uint8_t* cells = nullptr; // Mask of each cell, row by row, null for paged mazes
+  TileCache* tileCache = nullptr;
   bool isMazeInitialized = false;
+  uint16_t revision = 0;
+  uint32_t seed = 0;
+  uint32_t backSeed = 0;
+  uint32_t randomState = 1;
+  long nextRandom(long min, long max);
+
+  enum GenerationPhase : uint8_t {
+    GENERATION_IDLE,
+    GENERATION_FILLING,
+    GENERATION_CARVING,
+    GENERATION_BRAIDING
+  };
+  GenerationPhase generationPhase = GENERATION_IDLE;
+  uint16_t* generationStack = nullptr;
+  int generationStackSize = 0;
+  int generationRow = 0; // Or the next tile to fill with walls in paged mazes
+  int generationColumn = 1; // The next cell of generationRow to braid in paged mazes
+  int visitedCells = 0;
+  uint8_t* backCells = nullptr;
+  bool isGeneratingIntoBackBuffer = false;
+  bool isBackBufferComplete = false;
+  long saveIndex = -1; // Next cell to save, -1 if no save is in progress
+  uint8_t saveChecksum = 0;
+  int printRow = -1; // Next row to print, -1 if no print is in progress
+  MazePosition printPlayerPosition = {0, 0};
   uint8_t calculateChecksum();
+  void printRowToSerial(int row, int playerRow, int playerColumn);
+  uint8_t getCell(int row, int column);
+  void setCell(int row, int column, uint8_t value);
+  int getCellIndex(int row, int column);
+  uint8_t readCell(const uint8_t* cellMasks, int row, int column);
+  void writeCell(uint8_t* cellMasks, int row, int column, uint8_t value);
+  void setCellBit(uint8_t* cellMasks, int row, int column, uint8_t bit, bool isSet);
+  static const uint8_t CELL_OPEN = 16; // Set in a cell mask once the cell is carved
+  uint8_t getGenerationCell(int row, int column);
+  void setGenerationCell(int row, int column, uint8_t value);
+  bool isUnvisitedCell(int row, int column);
+  uint8_t getGenerationDirections(int row, int column);
+  void braidRow(int row, int firstColumn, int endColumn);
+  uint8_t braidPercent = 0;
+  BraidStats braidStats = {0, 0, 0, 0};
 
-  const int EEPROM_START_ADDRESS = 1; // Matrix brightness is stored at address 0
+  const int EEPROM_START_ADDRESS = 1; // Address 0 holds the brightness saved before the settings store
   const char WALL_CHAR = '#';
   const char EMPTY_CHAR = ' ';
   const char PLAYER_CHAR = 'P';
   const char START_CHAR = 'S';
   const char END_CHAR = 'E';
+  const int SERIAL_TX_BYTES = 64; // The transmit buffer of the serial port on AVR boards
 
 };
 
@@ -0,0 +1,210 @@
+#include <Arduino.h>
+#include "TileCache.hpp"
+
+TileCache::TileCache(TileStore& store, uint8_t slotCount) : store(store) {
+  if (slotCount == 0) {
+    slotCount = 1;
+  } else if (slotCount > MAX_SLOTS) {
+    slotCount = MAX_SLOTS;
+  }
+  this->slotCount = slotCount;
+  slots = new Slot[slotCount];
+  for (int i = 0; i < slotCount; i++) {
+    slots[i].data = new uint8_t[TILE_BYTES];
+    slots[i].valid = false;
+    slots[i].dirty = false;
+  }
+  resetStats();
+}
+
+void TileCache::configure(int rows, int columns) {
+  tilesPerRow = (columns + TILE_SIZE - 1) / TILE_SIZE;
+  int tilesPerColumn = (rows + TILE_SIZE - 1) / TILE_SIZE;
+  tileCount = tilesPerRow * tilesPerColumn;
+  invalidate();
+}
+
+uint32_t TileCache::getStoreSize() {
+  return (uint32_t)tileCount * TILE_BYTES + 1;
+}
+
+uint16_t TileCache::getTileCount() {
+  return tileCount;
+}
+
+uint8_t TileCache::read(int row, int column) {
+  Slot& slot = slotFor(row, column);
+  return (slot.data[cellByte(row, column)] >> cellShift(row, column)) & 0x03;
+}
+
+void TileCache::write(int row, int column, uint8_t value) {
+  Slot& slot = slotFor(row, column);
+  uint8_t shift = cellShift(row, column);
+  uint8_t& cells = slot.data[cellByte(row, column)];
+  cells = (cells & ~(0x03 << shift)) | ((value & 0x03) << shift);
+  markDirty(slot);
+}
+
+void TileCache::fill(uint16_t tileIndex, uint8_t value) {
+  Slot& slot = slotForTile(tileIndex, false);
+  memset(slot.data, (value & 0x03) * 0x55, TILE_BYTES); // The value in all 4 cells of each byte
+  markDirty(slot);
+}
+
+void TileCache::flush() {
+  for (int i = 0; i < slotCount; i++) {
+    if (slots[i].valid && slots[i].dirty) {
+      writeBack(slots[i]);
+    }
+  }
+}
+
+int TileCache::flushBytes(int maxBytes) {
+  int written = 0;
+  while (written < maxBytes) {
+    if (flushSlot < 0) {
+      for (int i = 0; i < slotCount; i++) {
+        if (slots[i].valid && slots[i].dirty &&
+            (flushSlot < 0 || (uint16_t)(useClock - slots[i].lastUsed) > (uint16_t)(useClock - slots[flushSlot].lastUsed))) {
+          flushSlot = i;
+        }
+      }
+      if (flushSlot < 0) {
+        break;
+      }
+      flushOffset = 0;
+    }
+    Slot& slot = slots[flushSlot];
+    uint8_t length = min(maxBytes - written, TILE_BYTES - flushOffset);
+    store.write((uint32_t)slot.tileIndex * TILE_BYTES + flushOffset, slot.data + flushOffset, length);
+    flushOffset += length;
+    written += length;
+    if (flushOffset == TILE_BYTES) {
+      slot.dirty = false;
+      stats.writeBacks++;
+      flushSlot = -1;
+    }
+  }
+  return written;
+}
+
+bool TileCache::hasCleanSlots(uint8_t count) {
+  uint8_t cleanSlots = 0;
+  for (int i = 0; i < slotCount; i++) {
+    cleanSlots += !slots[i].valid || !slots[i].dirty;
+  }
+  return cleanSlots >= min(count, slotCount);
+}
+
+void TileCache::invalidate() {
+  for (int i = 0; i < slotCount; i++) {
+    slots[i].valid = false;
+    slots[i].dirty = false;
+  }
+  flushSlot = -1;
+}
+
+uint8_t TileCache::readChecksum() {
+  uint8_t checksum;
+  store.read((uint32_t)tileCount * TILE_BYTES, &checksum, 1);
+  return checksum;
+}
+
+void TileCache::writeChecksum(uint8_t checksum) {
+  store.write((uint32_t)tileCount * TILE_BYTES, &checksum, 1);
+}
+
+TileCacheStats TileCache::getStats() {
+  return stats;
+}
+
+void TileCache::resetStats() {
+  stats.hits = 0;
+  stats.misses = 0;
+  stats.writeBacks = 0;
+  stats.fetchMicros = 0;
+  stats.maxFetchMicros = 0;
+}
+
+TileCache::Slot& TileCache::slotFor(int row, int column) {
+  return slotForTile((row / TILE_SIZE) * tilesPerRow + column / TILE_SIZE, true);
+}
+
+TileCache::Slot& TileCache::slotForTile(uint16_t tileIndex, bool isFetched) {
+  useClock++;
+
+  // Consecutive accesses almost always hit the same tile
+  Slot* slot = &slots[lastSlot];
+  if (slot->valid && slot->tileIndex == tileIndex) {
+    slot->lastUsed = useClock;
+    stats.hits++;
+    return *slot;
+  }
+
+  uint8_t victim = 0;
+  for (uint8_t i = 0; i < slotCount; i++) {
+    if (slots[i].valid && slots[i].tileIndex == tileIndex) {
+      lastSlot = i;
+      slots[i].lastUsed = useClock;
+      stats.hits++;
+      return slots[i];
+    }
+    // Prefer an empty slot, then the least recently used clean one, which needs no write back
+    if (!slots[victim].valid) {
+      continue;
+    }
+    if (!slots[i].valid || (slots[victim].dirty && !slots[i].dirty)) {
+      victim = i;
+    } else if (slots[i].dirty == slots[victim].dirty &&
+               (uint16_t)(useClock - slots[i].lastUsed) > (uint16_t)(useClock - slots[victim].lastUsed)) {
+      victim = i;
+    }
+  }
+
+  uint32_t fetchStart = micros();
+  slot = &slots[victim];
+  if (slot->valid && slot->dirty) {
+    writeBack(*slot);
+  }
+  if (isFetched) {
+    store.read((uint32_t)tileIndex * TILE_BYTES, slot->data, TILE_BYTES);
+  }
+  slot->tileIndex = tileIndex;
+  slot->valid = true;
+  slot->dirty = false;
+  slot->lastUsed = useClock;
+  lastSlot = victim;
+
+  uint32_t fetchMicros = micros() - fetchStart;
+  stats.misses++;
+  stats.fetchMicros += fetchMicros;
+  if (fetchMicros > stats.maxFetchMicros) {
+    stats.maxFetchMicros = fetchMicros;
+  }
+  return *slot;
+}
+
+void TileCache::writeBack(Slot& slot) {
+  store.write((uint32_t)slot.tileIndex * TILE_BYTES, slot.data, TILE_BYTES);
+  slot.dirty = false;
+  stats.writeBacks++;
+  if (&slot - slots == flushSlot) {
+    flushSlot = -1;
+  }
+}
+
+void TileCache::markDirty(Slot& slot) {
+  slot.dirty = true;
+  if (&slot - slots == flushSlot) {
+    // Bytes already flushed may have changed, write the tile back from the start
+    flushOffset = 0;
+  }
+}
+
+uint8_t TileCache::cellShift(int row, int column) {
+  return ((row % TILE_SIZE) * TILE_SIZE + column % TILE_SIZE) % 4 * 2;
+}
+
+uint8_t TileCache::cellByte(int row, int column) {
+  return ((row % TILE_SIZE) * TILE_SIZE + column % TILE_SIZE) / 4;
+}
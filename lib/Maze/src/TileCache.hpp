@@ -0,0 +1,169 @@
+#include <Arduino.h>
+#ifndef TILE_CACHE_HPP
+#define TILE_CACHE_HPP
+
+#include "TileStore.hpp"
+
+/**
+ * @brief Access statistics of a tile cache.
+ */
+struct TileCacheStats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t writeBacks;
+  uint32_t fetchMicros;    // Total time spent reading and writing back tiles
+  uint32_t maxFetchMicros; // Slowest single miss
+};
+
+/**
+ * @class TileCache
+ * @brief A small LRU cache of maze tiles kept in RAM in front of a TileStore.
+ *
+ * The maze is split into square tiles of TILE_SIZE x TILE_SIZE cells. Each cell
+ * is packed into 2 bits, so a tile occupies TILE_BYTES bytes both in the cache
+ * and in the backing store. Modified tiles are written back when they are
+ * evicted or when the cache is flushed. Clean tiles are evicted first, so a
+ * caller that keeps enough slots clean with flushBytes never waits for a whole
+ * tile to be written back at once.
+ */
+class TileCache {
+public:
+  static const uint8_t TILE_SIZE = 8;
+  static const uint8_t TILE_BYTES = TILE_SIZE * TILE_SIZE / 4;
+  static const uint8_t MAX_SLOTS = 8;
+
+  /**
+   * @brief Constructs a tile cache.
+   * @note An 8x8 viewport spans at most 4 tiles, so 4 slots keep the viewport
+   *       resident while the player walks.
+   *
+   * @param store The backing store holding the tiles.
+   * @param slotCount The number of tiles kept in RAM, at most MAX_SLOTS.
+   */
+  TileCache(TileStore& store, uint8_t slotCount);
+
+  /**
+   * @brief Sets the maze dimensions and drops all cached tiles.
+   * @param rows Number of rows in the maze.
+   * @param columns Number of columns in the maze.
+   */
+  void configure(int rows, int columns);
+
+  /**
+   * @brief Gets the number of bytes the maze occupies in the backing store.
+   * @return The number of tile bytes plus one checksum byte.
+   */
+  uint32_t getStoreSize();
+
+  /**
+   * @brief Gets the number of tiles the maze is split into.
+   * @return The number of tiles.
+   */
+  uint16_t getTileCount();
+
+  /**
+   * @brief Reads a cell through the cache.
+   * @param row The row of the cell.
+   * @param column The column of the cell.
+   * @return The value of the cell.
+   */
+  uint8_t read(int row, int column);
+
+  /**
+   * @brief Writes a cell through the cache, marking its tile dirty.
+   * @param row The row of the cell.
+   * @param column The column of the cell.
+   * @param value The new value of the cell (0 to 3).
+   */
+  void write(int row, int column, uint8_t value);
+
+  /**
+   * @brief Sets every cell of a tile, marking it dirty without reading it from the store.
+   * @param tileIndex The index of the tile, row by row.
+   * @param value The new value of the cells (0 to 3).
+   */
+  void fill(uint16_t tileIndex, uint8_t value);
+
+  /**
+   * @brief Writes all dirty tiles back to the backing store.
+   */
+  void flush();
+
+  /**
+   * @brief Writes dirty tiles back to the backing store a few bytes at a time.
+   * @note A tile is written across as many calls as needed and stays dirty until
+   *       its last byte is written, each call resumes where the previous one stopped.
+   *       The least recently used dirty tile is written first, as it is evicted first.
+   *
+   * @param maxBytes The maximum number of bytes to write in this call.
+   * @return The number of bytes written, less than maxBytes once no tile is dirty.
+   */
+  int flushBytes(int maxBytes);
+
+  /**
+   * @brief Checks if enough tiles can be evicted without writing them back.
+   * @note Never asks for more slots than the cache has, so with 1 slot any access
+   *       may still write back a tile.
+   *
+   * @param count The number of empty or unmodified slots needed.
+   * @return True if at least count slots are empty or unmodified, false otherwise.
+   */
+  bool hasCleanSlots(uint8_t count);
+
+  /**
+   * @brief Drops all cached tiles without writing them back.
+   */
+  void invalidate();
+
+  /**
+   * @brief Reads the checksum byte stored after the last tile.
+   * @return The stored checksum.
+   */
+  uint8_t readChecksum();
+
+  /**
+   * @brief Writes the checksum byte stored after the last tile.
+   * @param checksum The checksum to store.
+   */
+  void writeChecksum(uint8_t checksum);
+
+  /**
+   * @brief Gets the access statistics collected since the last reset.
+   * @return The access statistics.
+   */
+  TileCacheStats getStats();
+
+  /**
+   * @brief Resets the access statistics.
+   */
+  void resetStats();
+
+private:
+  struct Slot {
+    uint16_t tileIndex;
+    uint16_t lastUsed;
+    bool valid;
+    bool dirty;
+    uint8_t* data;
+  };
+
+  TileStore& store;
+  Slot* slots;
+  uint8_t slotCount;
+  uint8_t lastSlot = 0;
+  int8_t flushSlot = -1; // The slot flushBytes is writing back, -1 if none
+  uint8_t flushOffset = 0;
+  uint16_t useClock = 0;
+  int tilesPerRow = 0;
+  uint16_t tileCount = 0;
+  TileCacheStats stats;
+
+  Slot& slotFor(int row, int column);
+  Slot& slotForTile(uint16_t tileIndex, bool isFetched);
+  void markDirty(Slot& slot);
+  void writeBack(Slot& slot);
+  uint8_t cellShift(int row, int column);
+  uint8_t cellByte(int row, int column);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include <Arduino.h>
+#ifndef TILE_STORE_HPP
+#define TILE_STORE_HPP
+
+#include <EEPROM.h>
+#ifndef ARDUINO
+#include <stdio.h>
+#endif
+
+/**
+ * @class TileStore
+ * @brief A byte-addressed backing store for paged maze tiles.
+ *
+ * Implement this interface to keep maze tiles in external SPI flash, FRAM or
+ * any other medium that is larger than the available RAM.
+ */
+class TileStore {
+public:
+  virtual ~TileStore() {}
+
+  /**
+   * @brief Reads a block of bytes from the store.
+   * @param offset The offset of the first byte to read.
+   * @param buffer The buffer to read into.
+   * @param length The number of bytes to read.
+   */
+  virtual void read(uint32_t offset, uint8_t* buffer, uint16_t length) = 0;
+
+  /**
+   * @brief Writes a block of bytes to the store.
+   * @param offset The offset of the first byte to write.
+   * @param buffer The bytes to write.
+   * @param length The number of bytes to write.
+   */
+  virtual void write(uint32_t offset, const uint8_t* buffer, uint16_t length) = 0;
+};
+
+/**
+ * @class EEPROMTileStore
+ * @brief Keeps maze tiles in the on-chip EEPROM.
+ * @note Writes use EEPROM.update so unchanged bytes do not wear the cells. On the native
+ *       build it keeps them in the simulated EEPROM of tools/host, so the sketch runs there
+ *       with PAGED_MAZE too.
+ */
+class EEPROMTileStore : public TileStore {
+public:
+  /**
+   * @brief Constructs an EEPROM tile store.
+   * @param baseAddress The EEPROM address of the first tile byte.
+   */
+  EEPROMTileStore(int baseAddress) : baseAddress(baseAddress) {}
+
+  void read(uint32_t offset, uint8_t* buffer, uint16_t length) override {
+    for (uint16_t i = 0; i < length; i++) {
+      buffer[i] = EEPROM.read(baseAddress + offset + i);
+    }
+  }
+
+  void write(uint32_t offset, const uint8_t* buffer, uint16_t length) override {
+    for (uint16_t i = 0; i < length; i++) {
+      EEPROM.update(baseAddress + offset + i, buffer[i]);
+    }
+  }
+
+private:
+  int baseAddress;
+};
+
+#ifndef ARDUINO
+/**
+ * @class FileTileStore
+ * @brief Keeps maze tiles in a file on the native build.
+ * @note The file is created if it does not exist.
+ */
+class FileTileStore : public TileStore {
+public:
+  /**
+   * @brief Opens the file backing the tile store.
+   * @param path The path of the file.
+   */
+  FileTileStore(const char* path) {
+    file = fopen(path, "r+b");
+    if (file == nullptr) {
+      file = fopen(path, "w+b");
+    }
+  }
+
+  ~FileTileStore() override {
+    if (file != nullptr) {
+      fclose(file);
+    }
+  }
+
+  void read(uint32_t offset, uint8_t* buffer, uint16_t length) override {
+    size_t bytesRead = 0;
+    if (file != nullptr && fseek(file, offset, SEEK_SET) == 0) {
+      bytesRead = fread(buffer, 1, length, file);
+    }
+    // Bytes past the end of the file read as zeros
+    for (size_t i = bytesRead; i < length; i++) {
+      buffer[i] = 0;
+    }
+  }
+
+  void write(uint32_t offset, const uint8_t* buffer, uint16_t length) override {
+    if (file != nullptr && fseek(file, offset, SEEK_SET) == 0) {
+      fwrite(buffer, 1, length, file);
+      fflush(file);
+    }
+  }
+
+private:
+  FILE* file;
+};
+#endif
+
+#endif
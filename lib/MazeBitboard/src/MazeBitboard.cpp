@@ -0,0 +1,150 @@
+#include <Arduino.h>
+#include "MazeBitboard.hpp"
+
+MazeBitboard::MazeBitboard(int rows, int columns) : bitboardRows(rows), bitboardColumns(columns) {
+  wordsPerRow = (bitboardColumns + BITBOARD_WORD_BITS - 1) / BITBOARD_WORD_BITS;
+  bits = new BitboardWord[bitboardRows * wordsPerRow];
+  scratch = new BitboardWord[5 * wordsPerRow];
+  for (int i = 0; i < bitboardRows * wordsPerRow; i++) {
+    bits[i] = 0;
+  }
+}
+
+MazeBitboard::~MazeBitboard() {
+  delete[] bits;
+  delete[] scratch;
+}
+
+void MazeBitboard::load(Maze& maze) {
+  for (int i = 0; i < bitboardRows; i++) {
+    BitboardWord* row = &bits[i * wordsPerRow];
+    for (int w = 0; w < wordsPerRow; w++) {
+      row[w] = 0;
+    }
+    for (int j = 0; j < bitboardColumns; j++) {
+      if (!maze.isCollision(i, j)) {
+        row[j / BITBOARD_WORD_BITS] |= (BitboardWord)1 << (j % BITBOARD_WORD_BITS);
+      }
+    }
+  }
+}
+
+int MazeBitboard::getWordsPerRow() {
+  return wordsPerRow;
+}
+
+const BitboardWord* MazeBitboard::getOpenRow(int row) {
+  return &bits[row * wordsPerRow];
+}
+
+bool MazeBitboard::isOpen(int row, int column) {
+  if (row < 0 || row >= bitboardRows || column < 0 || column >= bitboardColumns) {
+    return false;
+  }
+  return (bits[row * wordsPerRow + column / BITBOARD_WORD_BITS] >> (column % BITBOARD_WORD_BITS)) & 1;
+}
+
+uint8_t MazeBitboard::getOpenDirections(int row, int column) {
+  uint8_t directions = 0;
+  if (isOpen(row - 1, column)) {
+    directions |= BITBOARD_UP;
+  }
+  if (isOpen(row, column + 1)) {
+    directions |= BITBOARD_RIGHT;
+  }
+  if (isOpen(row + 1, column)) {
+    directions |= BITBOARD_DOWN;
+  }
+  if (isOpen(row, column - 1)) {
+    directions |= BITBOARD_LEFT;
+  }
+  return directions;
+}
+
+void MazeBitboard::getNeighbourMasks(int row, BitboardWord* up, BitboardWord* right, BitboardWord* down, BitboardWord* left) {
+  const BitboardWord* open = getOpenRow(row);
+  const BitboardWord* above = row > 0 ? getOpenRow(row - 1) : nullptr;
+  const BitboardWord* below = row < bitboardRows - 1 ? getOpenRow(row + 1) : nullptr;
+
+  for (int w = 0; w < wordsPerRow; w++) {
+    if (up != nullptr) {
+      up[w] = above != nullptr ? open[w] & above[w] : 0;
+    }
+    if (down != nullptr) {
+      down[w] = below != nullptr ? open[w] & below[w] : 0;
+    }
+    if (right != nullptr) {
+      // Bit n is set if column n + 1 is open, carrying the lowest bit of the next word
+      BitboardWord shifted = open[w] >> 1;
+      if (w < wordsPerRow - 1) {
+        shifted |= (BitboardWord)(open[w + 1] << (BITBOARD_WORD_BITS - 1));
+      }
+      right[w] = open[w] & shifted;
+    }
+    if (left != nullptr) {
+      // Bit n is set if column n - 1 is open, carrying the highest bit of the previous word
+      BitboardWord shifted = (BitboardWord)(open[w] << 1);
+      if (w > 0) {
+        shifted |= open[w - 1] >> (BITBOARD_WORD_BITS - 1);
+      }
+      left[w] = open[w] & shifted;
+    }
+  }
+}
+
+void MazeBitboard::getDeadEndsAndJunctions(int row, BitboardWord* deadEnds, BitboardWord* junctions) {
+  BitboardWord* up = scratch;
+  BitboardWord* right = scratch + wordsPerRow;
+  BitboardWord* down = scratch + 2 * wordsPerRow;
+  BitboardWord* left = scratch + 3 * wordsPerRow;
+  getNeighbourMasks(row, up, right, down, left);
+
+  for (int w = 0; w < wordsPerRow; w++) {
+    // Sum the four neighbour bits of every cell into a 3 bit count (sum2 sum1 sum0)
+    BitboardWord upRight0 = up[w] ^ right[w];
+    BitboardWord upRight1 = up[w] & right[w];
+    BitboardWord downLeft0 = down[w] ^ left[w];
+    BitboardWord downLeft1 = down[w] & left[w];
+    BitboardWord sum0 = upRight0 ^ downLeft0;
+    BitboardWord carry0 = upRight0 & downLeft0;
+    BitboardWord pairs = upRight1 ^ downLeft1;
+    BitboardWord sum1 = pairs ^ carry0;
+    BitboardWord sum2 = (upRight1 & downLeft1) | (pairs & carry0);
+
+    BitboardWord open = getOpenRow(row)[w];
+    if (deadEnds != nullptr) {
+      deadEnds[w] = open & sum0 & ~sum1 & ~sum2;
+    }
+    if (junctions != nullptr) {
+      junctions[w] = open & ((sum0 & sum1) | sum2);
+    }
+  }
+}
+
+int MazeBitboard::countDeadEnds() {
+  BitboardWord* deadEnds = scratch + 4 * wordsPerRow;
+  int count = 0;
+  for (int i = 0; i < bitboardRows; i++) {
+    getDeadEndsAndJunctions(i, deadEnds, nullptr);
+    count += countBits(deadEnds);
+  }
+  return count;
+}
+
+int MazeBitboard::countJunctions() {
+  BitboardWord* junctions = scratch + 4 * wordsPerRow;
+  int count = 0;
+  for (int i = 0; i < bitboardRows; i++) {
+    getDeadEndsAndJunctions(i, nullptr, junctions);
+    count += countBits(junctions);
+  }
+  return count;
+}
+
+int MazeBitboard::countBits(const BitboardWord* words) {
+  int count = 0;
+  for (int w = 0; w < wordsPerRow; w++) {
+    count += __builtin_popcountl(words[w]);
+  }
+  return count;
+}
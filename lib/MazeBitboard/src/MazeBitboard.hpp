@@ -0,0 +1,125 @@
+#include <Arduino.h>
+#ifndef MAZE_BITBOARD_HPP
+#define MAZE_BITBOARD_HPP
+
+#include <Maze.hpp>
+
+// One machine word holds a segment of a row, bit n of word w is column w * BITBOARD_WORD_BITS + n
+#ifdef __AVR__
+typedef uint8_t BitboardWord;
+#else
+typedef uint32_t BitboardWord;
+#endif
+const int BITBOARD_WORD_BITS = sizeof(BitboardWord) * 8;
+
+/**
+ * @class MazeBitboard
+ * @brief A bit-row copy of a maze with word-parallel analysis kernels.
+ *
+ * Every row is stored as a bit mask of its open (non-wall) cells. Neighbour
+ * masks are produced by shifting whole rows, and the number of open neighbours
+ * of every cell in a row is summed with bitwise adders, so dead ends and
+ * junctions are found a whole word of cells at a time instead of cell by cell.
+ */
+class MazeBitboard {
+public:
+  /**
+   * @brief Constructs an empty bitboard with specified rows and columns.
+   * @param rows Number of rows in the bitboard.
+   * @param columns Number of columns in the bitboard.
+   */
+  MazeBitboard(int rows, int columns);
+
+  ~MazeBitboard();
+
+  // The rows are owned by the bitboard, copies would free them twice
+  MazeBitboard(const MazeBitboard&) = delete;
+  MazeBitboard& operator=(const MazeBitboard&) = delete;
+
+  /**
+   * @brief Copies the open cells of a maze into the bitboard.
+   * @note Must be called again after the maze is regenerated or loaded.
+   * @param maze The maze to copy, with the same dimensions as the bitboard.
+   */
+  void load(Maze& maze);
+
+  /**
+   * @brief Gets the number of words used for each row.
+   * @return The number of words per row.
+   */
+  int getWordsPerRow();
+
+  /**
+   * @brief Gets the open cells of a row.
+   * @param row The row to get.
+   * @return getWordsPerRow() words with one bit set per open cell.
+   */
+  const BitboardWord* getOpenRow(int row);
+
+  /**
+   * @brief Checks if a cell is open. Out of bounds cells are not open.
+   * @param row The row of the cell.
+   * @param column The column of the cell.
+   * @return True if the cell is open, false otherwise.
+   */
+  bool isOpen(int row, int column);
+
+  /**
+   * @brief Gets the open directions of a cell.
+   * @param row The row of the cell.
+   * @param column The column of the cell.
+   * @return A mask of BITBOARD_UP, BITBOARD_RIGHT, BITBOARD_DOWN and BITBOARD_LEFT.
+   */
+  uint8_t getOpenDirections(int row, int column);
+
+  /**
+   * @brief Computes which open cells of a row have an open neighbour in each direction.
+   * @note Any output pointer may be nullptr if that direction is not needed.
+   *
+   * @param row The row to compute.
+   * @param up Receives the cells whose upper neighbour is open.
+   * @param right Receives the cells whose right neighbour is open.
+   * @param down Receives the cells whose lower neighbour is open.
+   * @param left Receives the cells whose left neighbour is open.
+   */
+  void getNeighbourMasks(int row, BitboardWord* up, BitboardWord* right, BitboardWord* down, BitboardWord* left);
+
+  /**
+   * @brief Computes the dead ends (exactly one open neighbour) and junctions
+   *        (three or more open neighbours) of a row.
+   * @note Either output pointer may be nullptr if it is not needed.
+   *
+   * @param row The row to compute.
+   * @param deadEnds Receives the dead end cells of the row.
+   * @param junctions Receives the junction cells of the row.
+   */
+  void getDeadEndsAndJunctions(int row, BitboardWord* deadEnds, BitboardWord* junctions);
+
+  /**
+   * @brief Counts the dead ends of the whole maze.
+   * @return The number of dead ends.
+   */
+  int countDeadEnds();
+
+  /**
+   * @brief Counts the junctions of the whole maze.
+   * @return The number of junctions.
+   */
+  int countJunctions();
+
+  static const uint8_t BITBOARD_UP = MAZE_UP;
+  static const uint8_t BITBOARD_RIGHT = MAZE_RIGHT;
+  static const uint8_t BITBOARD_DOWN = MAZE_DOWN;
+  static const uint8_t BITBOARD_LEFT = MAZE_LEFT;
+
+private:
+  int bitboardRows;
+  int bitboardColumns;
+  int wordsPerRow;
+  BitboardWord* bits;
+  BitboardWord* scratch; // Four rows of neighbour masks used by the kernels, and a row they count
+
+  int countBits(const BitboardWord* words);
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include <Arduino.h>
+#include "MemoryStats.hpp"
+
+#ifdef __AVR__
+
+extern char __heap_start;
+extern char* __brkval;
+
+static const uint8_t STACK_PAINT = 0xC5;
+
+// Runs from .init3, before globals are constructed and before anything is on the
+// stack, so all of the RAM above the global variables can be painted
+void paintStack() __attribute__((naked, used, section(".init3")));
+void paintStack() {
+  for (uint8_t* address = (uint8_t*)&__heap_start; address <= (uint8_t*)RAMEND; address++) {
+    *address = STACK_PAINT;
+  }
+}
+
+uint16_t MemoryStats::getHeapBytes() {
+  return __brkval == nullptr ? 0 : __brkval - &__heap_start;
+}
+
+uint16_t MemoryStats::getStackBytes() {
+  return RAMEND - SP;
+}
+
+void MemoryStats::begin() {
+  maxHeapBytes = 0;
+  maxStackBytes = 0;
+  update();
+}
+
+MemoryReport MemoryStats::getReport() {
+  update();
+
+  // The stack grows down into the painted RAM, the first overwritten byte above the heap is its deepest point.
+  // Heap that grew and shrank again between two updates leaves garbage behind, so this errs on the safe side.
+  const uint8_t* address = (const uint8_t*)&__heap_start + getHeapBytes();
+  while (address <= (const uint8_t*)RAMEND && *address == STACK_PAINT) {
+    address++;
+  }
+  uint16_t paintedStackBytes = (const uint8_t*)RAMEND + 1 - address;
+  if (paintedStackBytes > maxStackBytes) {
+    maxStackBytes = paintedStackBytes;
+  }
+
+  MemoryReport report;
+  report.ramBytes = RAMEND - RAMSTART + 1;
+  report.staticBytes = &__heap_start - (char*)RAMSTART;
+  report.heapBytes = getHeapBytes();
+  report.maxHeapBytes = maxHeapBytes;
+  report.maxStackBytes = maxStackBytes;
+  report.minFreeBytes = (long)report.ramBytes - report.staticBytes - maxHeapBytes - maxStackBytes;
+  return report;
+}
+
+#else
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+// Every allocation is counted with a size header, as the AVR malloc does
+static std::atomic<long> simulatedHeapBytes(0);
+static std::atomic<long> simulatedMaxHeapBytes(0);
+static const size_t HEADER_BYTES = alignof(std::max_align_t);
+
+#ifdef MEMORY_STATS
+void* operator new(size_t size) {
+  uint8_t* block = (uint8_t*)malloc(size + HEADER_BYTES);
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  *(size_t*)block = size;
+  long heapBytes = simulatedHeapBytes += size + sizeof(size_t);
+  long maxHeapBytes = simulatedMaxHeapBytes;
+  while (heapBytes > maxHeapBytes && !simulatedMaxHeapBytes.compare_exchange_weak(maxHeapBytes, heapBytes)) {
+  }
+  return block + HEADER_BYTES;
+}
+
+void operator delete(void* pointer) noexcept {
+  if (pointer == nullptr) {
+    return;
+  }
+  uint8_t* block = (uint8_t*)pointer - HEADER_BYTES;
+  simulatedHeapBytes -= *(size_t*)block + sizeof(size_t);
+  free(block);
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete[](void* pointer) noexcept {
+  operator delete(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  operator delete(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+  operator delete(pointer);
+}
+#endif
+
+void MemoryStats::simulate(uint16_t ramBytes, uint16_t staticBytes) {
+  simulatedRAMBytes = ramBytes;
+  simulatedStaticBytes = staticBytes;
+}
+
+uint16_t MemoryStats::getHeapBytes() {
+  return min(simulatedHeapBytes.load(), 0xFFFFL);
+}
+
+uint16_t MemoryStats::getStackBytes() {
+  volatile char marker;
+  uintptr_t address = (uintptr_t)&marker;
+  return address < stackBase ? min((unsigned long)(stackBase - address), 0xFFFFUL) : 0;
+}
+
+void MemoryStats::begin() {
+  volatile char marker;
+  stackBase = (uintptr_t)&marker;
+  simulatedMaxHeapBytes = simulatedHeapBytes.load();
+  maxHeapBytes = 0;
+  maxStackBytes = 0;
+  update();
+}
+
+MemoryReport MemoryStats::getReport() {
+  update();
+  maxHeapBytes = max(maxHeapBytes, (uint16_t)min(simulatedMaxHeapBytes.load(), 0xFFFFL));
+
+  MemoryReport report;
+  report.ramBytes = simulatedRAMBytes;
+  report.staticBytes = simulatedStaticBytes;
+  report.heapBytes = getHeapBytes();
+  report.maxHeapBytes = maxHeapBytes;
+  report.maxStackBytes = maxStackBytes;
+  report.minFreeBytes = constrain((long)report.ramBytes - report.staticBytes - maxHeapBytes - maxStackBytes, -32768L, 32767L);
+  return report;
+}
+
+#endif
+
+void MemoryStats::update() {
+  uint16_t heapBytes = getHeapBytes();
+  uint16_t stackBytes = getStackBytes();
+  if (heapBytes > maxHeapBytes) {
+    maxHeapBytes = heapBytes;
+  }
+  if (stackBytes > maxStackBytes) {
+    maxStackBytes = stackBytes;
+  }
+}
+
+int MemoryStats::getLargestSafeMazeSize(Maze& maze, bool withBackBuffer) {
+  // The RAM of the current maze is freed when it is replaced by the larger one
+  long availableBytes = getReport().minFreeBytes - SAFETY_MARGIN + maze.getRAMBytes();
+  int size = 0;
+  while (Maze::getRAMBytes(size + 1, size + 1, withBackBuffer) <= availableBytes) {
+    size++;
+  }
+  return size;
+}
+
+void MemoryStats::printToSerial(Maze& maze, bool withBackBuffer) {
+  MemoryReport report = getReport();
+  Serial.print("RAM: ");
+  Serial.print(report.staticBytes);
+  Serial.print(" static, heap ");
+  Serial.print(report.heapBytes);
+  Serial.print(" (max ");
+  Serial.print(report.maxHeapBytes);
+  Serial.print("), stack max ");
+  Serial.print(report.maxStackBytes);
+  Serial.print(", min free ");
+  Serial.print(report.minFreeBytes);
+  Serial.print(" of ");
+  Serial.print(report.ramBytes);
+  Serial.println(" bytes");
+
+  int size = getLargestSafeMazeSize(maze, withBackBuffer);
+  Serial.print("Largest safe maze: ");
+  Serial.print(size);
+  Serial.print("x");
+  Serial.print(size);
+  Serial.print(withBackBuffer ? " with back buffer, " : ", ");
+  Serial.print(SAFETY_MARGIN);
+  Serial.println(" bytes kept free");
+}
@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#ifndef MEMORY_STATS_HPP
+#define MEMORY_STATS_HPP
+
+#include <Maze.hpp>
+
+/**
+ * @brief A snapshot of RAM usage.
+ */
+struct MemoryReport {
+  uint16_t ramBytes;       // Size of the RAM
+  uint16_t staticBytes;    // Global variables (.data and .bss)
+  uint16_t heapBytes;      // Current size of the heap
+  uint16_t maxHeapBytes;   // Largest size of the heap seen
+  uint16_t maxStackBytes;  // Deepest stack seen
+  int16_t minFreeBytes;    // Smallest gap left between the heap and the stack, negative if they collided
+};
+
+/**
+ * @class MemoryStats
+ * @brief Tracks the high-water marks of the heap and the stack.
+ *
+ * On AVR the free RAM between the heap and the stack is painted with a known byte
+ * before setup runs, and the deepest stack is found by looking for the first byte the
+ * stack overwrote. The heap break (__brkval) is sampled by update.
+ *
+ * On other platforms the same API works on a simulated memory map: heap allocations
+ * are counted by replacing operator new and delete, and the stack depth is sampled by
+ * update relative to the frame that called begin. Host pointers are larger than AVR
+ * ones, so host figures overestimate the heap used by pointer arrays. The replacement
+ * is only compiled in when MEMORY_STATS is defined for the whole build (-DMEMORY_STATS),
+ * so other host programs linking this library keep the standard allocator and the
+ * heap reads as empty.
+ */
+class MemoryStats {
+public:
+  /**
+   * @brief Bytes kept free for interrupts and code paths not taken yet when computing the largest safe maze.
+   */
+  static const uint16_t SAFETY_MARGIN = 128;
+
+  /**
+   * @brief Starts tracking. Call this first thing in setup.
+   * @note On AVR the stack has already been painted at boot, this only resets the high-water marks.
+   */
+  void begin();
+
+  /**
+   * @brief Samples the heap break and the stack pointer. Call this every frame.
+   */
+  void update();
+
+  /**
+   * @brief Gets the RAM usage and high-water marks.
+   * @note On AVR this scans the painted RAM, which takes about a millisecond.
+   * @return The RAM usage.
+   */
+  MemoryReport getReport();
+
+  /**
+   * @brief Gets the largest square maze that fits in the RAM left, for mazes held in RAM.
+   * @note The stack high-water mark only covers the code paths run so far, so call this
+   *       after a maze has been generated and played for a while.
+   *
+   * @param maze The maze currently in use, its RAM is available to a larger maze.
+   * @param withBackBuffer True if the larger maze needs a back buffer.
+   * @return The number of rows and columns of the largest safe maze.
+   */
+  int getLargestSafeMazeSize(Maze& maze, bool withBackBuffer);
+
+  /**
+   * @brief Prints the RAM usage and the largest safe maze size over serial.
+   * @param maze The maze currently in use.
+   * @param withBackBuffer True if the larger maze needs a back buffer.
+   */
+  void printToSerial(Maze& maze, bool withBackBuffer);
+
+#ifndef __AVR__
+  /**
+   * @brief Sets the simulated memory map, an ATmega328 without globals by default.
+   * @param ramBytes Size of the simulated RAM.
+   * @param staticBytes Size of the simulated global variables, e.g. .data + .bss as reported by avr-size.
+   */
+  void simulate(uint16_t ramBytes, uint16_t staticBytes);
+#endif
+
+private:
+  uint16_t maxHeapBytes = 0;
+  uint16_t maxStackBytes = 0;
+#ifndef __AVR__
+  uint16_t simulatedRAMBytes = 2048;
+  uint16_t simulatedStaticBytes = 0;
+  uintptr_t stackBase = 0;
+#endif
+
+  uint16_t getHeapBytes();
+  uint16_t getStackBytes();
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include <Arduino.h>
+#include "Minimap.hpp"
+
+Minimap::Minimap(MinimapReduction reduction) : reduction(reduction) {
+  for (int i = 0; i < MINIMAP_SIZE; i++) {
+    pixels[i] = 0;
+    workingPixels[i] = 0;
+    wallCounts[i] = 0;
+  }
+}
+
+void Minimap::update(Maze& maze, int rowsPerUpdate) {
+  int rows = maze.getRows();
+  int columns = maze.getColumns();
+
+  // Restart from the top whenever the maze changes
+  if (nextRow < 0 || maze.getRevision() != revision) {
+    revision = maze.getRevision();
+    nextRow = 0;
+    bandRows = 0;
+    for (int i = 0; i < MINIMAP_SIZE; i++) {
+      wallCounts[i] = 0;
+    }
+  }
+
+  for (int n = 0; n < rowsPerUpdate && nextRow < rows; n++, nextRow++) {
+    int band = nextRow * MINIMAP_SIZE / rows;
+    for (int j = 0; j < columns; j++) {
+      if (maze.isCollision(nextRow, j)) {
+        wallCounts[j * MINIMAP_SIZE / columns]++;
+      }
+    }
+    bandRows++;
+
+    bool isLastRowOfBand = nextRow == rows - 1 || (nextRow + 1) * MINIMAP_SIZE / rows != band;
+    if (!isLastRowOfBand) {
+      continue;
+    }
+
+    uint8_t bandPixels = 0;
+    for (int j = 0; j < MINIMAP_SIZE; j++) {
+      // Columns c with c * MINIMAP_SIZE / columns == j
+      int blockColumns = ((j + 1) * columns + MINIMAP_SIZE - 1) / MINIMAP_SIZE - (j * columns + MINIMAP_SIZE - 1) / MINIMAP_SIZE;
+      int blockCells = blockColumns * bandRows;
+      bool isOn;
+      if (reduction == MINIMAP_OR) {
+        isOn = wallCounts[j] > 0;
+      } else {
+        isOn = wallCounts[j] * 2 > blockCells;
+      }
+      if (isOn) {
+        bandPixels |= 1 << j;
+      }
+      wallCounts[j] = 0;
+    }
+    workingPixels[band] = bandPixels;
+    bandRows = 0;
+  }
+
+  if (nextRow == rows) {
+    for (int i = 0; i < MINIMAP_SIZE; i++) {
+      pixels[i] = workingPixels[i];
+    }
+    ready = true;
+    nextRow++; // Past the last row, nothing left to do until the maze changes
+  }
+}
+
+bool Minimap::isReady() {
+  return ready;
+}
+
+uint8_t Minimap::getRow(int row) {
+  return pixels[row];
+}
+
+MazePosition Minimap::toMinimapPosition(Maze& maze, MazePosition position) {
+  MazePosition minimapPosition = {position.row * MINIMAP_SIZE / maze.getRows(), position.column * MINIMAP_SIZE / maze.getColumns()};
+  return minimapPosition;
+}
@@ -0,0 +1,78 @@
+#include <Arduino.h>
+#ifndef MINIMAP_HPP
+#define MINIMAP_HPP
+
+#include <Maze.hpp>
+
+/**
+ * @brief How the cells of a block are reduced to a single minimap pixel.
+ */
+enum MinimapReduction {
+  MINIMAP_OR,       // The pixel is on if any cell of the block is a wall
+  MINIMAP_MAJORITY  // The pixel is on if more than half of the block are walls
+};
+
+/**
+ * @class Minimap
+ * @brief An 8x8 downscaled view of the whole maze.
+ *
+ * The maze is split into 8x8 blocks of roughly equal size and every block is
+ * reduced to one pixel. The minimap is computed a few maze rows at a time and
+ * cached, it is only recomputed when the maze revision changes, so showing it
+ * never costs more than drawing the regular view.
+ */
+class Minimap {
+public:
+  static const int MINIMAP_SIZE = 8;
+
+  /**
+   * @brief Constructs an empty minimap.
+   * @param reduction How blocks of cells are reduced to pixels.
+   */
+  Minimap(MinimapReduction reduction = MINIMAP_MAJORITY);
+
+  /**
+   * @brief Advances the computation of the minimap.
+   * @note Call this every frame. It does nothing once the minimap matches the
+   *       current maze revision.
+   *
+   * @param maze The maze to downscale.
+   * @param rowsPerUpdate The maximum number of maze rows to read in this call.
+   */
+  void update(Maze& maze, int rowsPerUpdate);
+
+  /**
+   * @brief Checks if the minimap has been computed for a maze at least once.
+   * @note After the maze changes the previous minimap stays available until the
+   *       new one is complete.
+   * @return True if the minimap is available, false otherwise.
+   */
+  bool isReady();
+
+  /**
+   * @brief Gets a row of the minimap.
+   * @param row The row of the minimap.
+   * @return The pixels of the row, bit n is column n.
+   */
+  uint8_t getRow(int row);
+
+  /**
+   * @brief Converts a maze position to the minimap pixel containing it.
+   * @param maze The maze the position belongs to.
+   * @param position The position in the maze.
+   * @return The position of the pixel on the minimap.
+   */
+  static MazePosition toMinimapPosition(Maze& maze, MazePosition position);
+
+private:
+  MinimapReduction reduction;
+  uint8_t pixels[MINIMAP_SIZE];
+  uint8_t workingPixels[MINIMAP_SIZE];
+  uint16_t wallCounts[MINIMAP_SIZE];
+  uint16_t revision = 0;
+  int nextRow = -1; // -1 until the first update
+  int bandRows = 0;
+  bool ready = false;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include <Arduino.h>
+#include "SerialConsole.hpp"
+
+// Command names in the order of ConsoleCommand, starting at CONSOLE_SEED
+static const char COMMAND_NAMES[] PROGMEM = "seed\0regen\0size\0dump\0stats\0goto\0bench\0rec\0tilt\0help";
+
+static const char HELP_TEXT[] PROGMEM =
+  "Commands:\n"
+  "  seed <n>             generate the maze of a seed\n"
+  "  regen                generate a new random maze\n"
+  "  size <rows> <cols>   change the maze size\n"
+  "  dump [bin]           print the maze, or send it packed\n"
+  "  stats                print game and timing statistics\n"
+  "  goto <row> <col>     move the player\n"
+  "  bench [n]            time the next n frames\n"
+  "  rec                  print the input recording\n"
+  "  tilt                 calibrate the tilt control, hold the nunchuk level\n";
+
+bool SerialConsole::poll(uint8_t maxBytes) {
+  uint32_t startMicros = micros();
+  bool isComplete = false;
+  for (uint8_t n = 0; n < maxBytes && !isComplete && Serial.available() > 0; n++) {
+    isComplete = feed(Serial.read());
+  }
+  uint32_t elapsedMicros = micros() - startMicros;
+  if (elapsedMicros > maxPollMicros) {
+    maxPollMicros = elapsedMicros;
+  }
+  return isComplete;
+}
+
+bool SerialConsole::feed(char character) {
+  if (character == '\r') {
+    return false;
+  }
+  if (character != '\n') {
+    if (lineLength < LINE_BYTES) {
+      line[lineLength++] = character;
+    } else {
+      isOverflowing = true;
+    }
+    return false;
+  }
+
+  line[lineLength] = '\0';
+  if (isOverflowing) {
+    command = CONSOLE_UNKNOWN;
+    argumentCount = 0;
+  } else {
+    parseLine();
+  }
+  lineLength = 0;
+  isOverflowing = false;
+  return command != CONSOLE_NONE;
+}
+
+ConsoleCommand SerialConsole::getCommand() {
+  return command;
+}
+
+uint8_t SerialConsole::getArgumentCount() {
+  return argumentCount;
+}
+
+bool SerialConsole::getNumber(uint8_t index, long& value) {
+  if (index >= argumentCount) {
+    return false;
+  }
+  const char* text = &line[argumentStarts[index]];
+  bool isNegative = *text == '-';
+  if (isNegative) {
+    text++;
+  }
+  if (*text == '\0') {
+    return false;
+  }
+  value = 0;
+  for (; *text != '\0'; text++) {
+    if (*text < '0' || *text > '9') {
+      return false;
+    }
+    value = value * 10 + (*text - '0');
+  }
+  if (isNegative) {
+    value = -value;
+  }
+  return true;
+}
+
+bool SerialConsole::isArgument(uint8_t index, const char* word) {
+  return index < argumentCount && strcmp(&line[argumentStarts[index]], word) == 0;
+}
+
+void SerialConsole::printHelp() {
+  for (const char* text = HELP_TEXT; pgm_read_byte(text) != '\0'; text++) {
+    Serial.write((uint8_t)pgm_read_byte(text));
+  }
+}
+
+uint32_t SerialConsole::getMaxPollMicros() {
+  return maxPollMicros;
+}
+
+void SerialConsole::parseLine() {
+  // Split the line into words in place, ending each one with '\0'
+  uint8_t wordStarts[MAX_ARGUMENTS + 1];
+  uint8_t wordCount = 0;
+  bool isInWord = false;
+  for (uint8_t i = 0; i < lineLength; i++) {
+    if (line[i] == ' ' || line[i] == '\t') {
+      line[i] = '\0';
+      isInWord = false;
+    } else if (!isInWord) {
+      isInWord = true;
+      if (wordCount > MAX_ARGUMENTS) {
+        command = CONSOLE_UNKNOWN; // Too many arguments
+        argumentCount = 0;
+        return;
+      }
+      wordStarts[wordCount++] = i;
+    }
+  }
+  argumentCount = 0;
+  if (wordCount == 0) {
+    command = CONSOLE_NONE;
+    return;
+  }
+  for (uint8_t i = 1; i < wordCount; i++) {
+    argumentStarts[argumentCount++] = wordStarts[i];
+  }
+
+  // Look the command up among the names, which follow each other in flash
+  command = CONSOLE_UNKNOWN;
+  const char* name = COMMAND_NAMES;
+  for (uint8_t id = CONSOLE_SEED; id <= CONSOLE_HELP; id++) {
+    const char* word = &line[wordStarts[0]];
+    while (pgm_read_byte(name) != '\0' && pgm_read_byte(name) == *word) {
+      name++;
+      word++;
+    }
+    if (pgm_read_byte(name) == '\0' && *word == '\0') {
+      command = (ConsoleCommand)id;
+      return;
+    }
+    while (pgm_read_byte(name) != '\0') {
+      name++;
+    }
+    name++;
+  }
+}
@@ -0,0 +1,107 @@
+#include <Arduino.h>
+#ifndef SERIAL_CONSOLE_HPP
+#define SERIAL_CONSOLE_HPP
+
+/**
+ * @brief The commands understood by the console.
+ */
+enum ConsoleCommand : uint8_t {
+  CONSOLE_NONE,    // Empty line
+  CONSOLE_UNKNOWN, // Unknown command or line too long
+  CONSOLE_SEED,    // seed <n>: generate the maze of a seed
+  CONSOLE_REGEN,   // regen: generate a new random maze
+  CONSOLE_SIZE,    // size <rows> <columns>: change the maze size
+  CONSOLE_DUMP,    // dump [bin]: print the maze, or send it packed
+  CONSOLE_STATS,   // stats: print the game and timing statistics
+  CONSOLE_GOTO,    // goto <row> <column>: move the player
+  CONSOLE_BENCH,   // bench [n]: time the next n frames, or n mazes on the native build
+  CONSOLE_RECORD,  // rec: print the input recording
+  CONSOLE_TILT,    // tilt: calibrate the tilt control
+  CONSOLE_HELP     // help: list the commands
+};
+
+/**
+ * @class SerialConsole
+ * @brief Reads command lines from Serial a few bytes at a time.
+ *
+ * Every call to poll reads at most a given number of bytes, so a frame never waits for
+ * input and the time spent per frame is bounded. A complete line is split into a
+ * command and up to MAX_ARGUMENTS arguments in place, with no copies. Lines longer
+ * than LINE_BYTES are reported as unknown commands. On the native build the same lines
+ * can be fed from a script, see tools/mazeconsole.
+ *
+ * Memory: LINE_BYTES plus a few bytes of bookkeeping.
+ */
+class SerialConsole {
+public:
+  static const uint8_t LINE_BYTES = 32;
+  static const uint8_t MAX_ARGUMENTS = 3;
+
+  /**
+   * @brief Reads the bytes waiting on Serial, up to a limit.
+   * @note Call this every frame. Once it returns true, handle the command before the next call.
+   *
+   * @param maxBytes The maximum number of bytes to read in this call.
+   * @return True if a command line is complete, false otherwise.
+   */
+  bool poll(uint8_t maxBytes);
+
+  /**
+   * @brief Adds a character to the line being read.
+   * @param character The character read, a line ends with '\n'.
+   * @return True if the character completed a command line, false otherwise.
+   */
+  bool feed(char character);
+
+  /**
+   * @brief Gets the command of the last complete line.
+   * @return The command.
+   */
+  ConsoleCommand getCommand();
+
+  /**
+   * @brief Gets the number of arguments after the command.
+   * @return The number of arguments.
+   */
+  uint8_t getArgumentCount();
+
+  /**
+   * @brief Reads an argument as a number.
+   * @param index The index of the argument, 0 for the first one after the command.
+   * @param value Receives the number.
+   * @return True if the argument is a decimal number, false if it is missing or not a number.
+   */
+  bool getNumber(uint8_t index, long& value);
+
+  /**
+   * @brief Checks if an argument is a given word.
+   * @param index The index of the argument, 0 for the first one after the command.
+   * @param word The word to compare with.
+   * @return True if the argument matches the word, false otherwise.
+   */
+  bool isArgument(uint8_t index, const char* word);
+
+  /**
+   * @brief Prints the list of commands.
+   */
+  static void printHelp();
+
+  /**
+   * @brief Gets the slowest call to poll.
+   * @return The slowest poll in microseconds.
+   */
+  uint32_t getMaxPollMicros();
+
+private:
+  char line[LINE_BYTES + 1];
+  uint8_t lineLength = 0;
+  bool isOverflowing = false;
+  ConsoleCommand command = CONSOLE_NONE;
+  uint8_t argumentCount = 0;
+  uint8_t argumentStarts[MAX_ARGUMENTS];
+  uint32_t maxPollMicros = 0;
+
+  void parseLine();
+};
+
+#endif
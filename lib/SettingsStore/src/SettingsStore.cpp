@@ -0,0 +1,119 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Crc8.hpp>
+#include "SettingsStore.hpp"
+
+SettingsStore::SettingsStore(int eepromAddress, int slotCount, const Settings& defaults)
+    : eepromAddress(eepromAddress), slotCount(slotCount), defaults(defaults) {
+  settings = defaults;
+  committedSettings = defaults;
+}
+
+bool SettingsStore::load() {
+  // The newest valid record wins, sequence numbers wrap around so compare their difference
+  int newestSlot = -1;
+  uint8_t record[RECORD_BYTES];
+  uint8_t newest[RECORD_BYTES];
+  for (int slot = 0; slot < slotCount; slot++) {
+    for (int i = 0; i < RECORD_BYTES; i++) {
+      record[i] = EEPROM.read(eepromAddress + slot * RECORD_BYTES + i);
+    }
+    if (record[0] != SETTINGS_MAGIC || record[1] != SCHEMA_VERSION ||
+        crc8(0, record, RECORD_BYTES - 1) != record[RECORD_BYTES - 1]) {
+      continue;
+    }
+    if (newestSlot < 0 || (int8_t)(record[2] - newest[2]) > 0) {
+      newestSlot = slot;
+      memcpy(newest, record, RECORD_BYTES);
+    }
+  }
+  if (newestSlot < 0) {
+    return false;
+  }
+
+  Settings loaded;
+  loaded.brightness = newest[3];
+  loaded.responseCurve = newest[4];
+  loaded.joystickDeadzone = newest[5];
+  loaded.braidPercent = newest[6];
+  settings = validate(loaded);
+  committedSettings = settings;
+  sequence = newest[2] + 1;
+  nextSlot = (newestSlot + 1) % slotCount;
+  return true;
+}
+
+const Settings& SettingsStore::get() {
+  return settings;
+}
+
+void SettingsStore::set(const Settings& settings, uint32_t currentTime) {
+  this->settings = validate(settings);
+  lastChangeTime = currentTime;
+}
+
+void SettingsStore::persist(uint32_t currentTime, uint32_t quietPeriod, int maxBytes) {
+  if (pendingWritten >= RECORD_BYTES) {
+    if (isEqual(settings, committedSettings) || currentTime - lastChangeTime < quietPeriod) {
+      return;
+    }
+    pending[0] = SETTINGS_MAGIC;
+    pending[1] = SCHEMA_VERSION;
+    pending[2] = sequence++;
+    pending[3] = settings.brightness;
+    pending[4] = settings.responseCurve;
+    pending[5] = settings.joystickDeadzone;
+    pending[6] = settings.braidPercent;
+    pending[7] = 0; // Reserved for the maze size
+    pending[8] = 0; // Reserved for the maze algorithm
+    pending[9] = crc8(0, pending, RECORD_BYTES - 1);
+    pendingAddress = eepromAddress + nextSlot * RECORD_BYTES;
+    pendingWritten = 0;
+    nextSlot = (nextSlot + 1) % slotCount;
+    committedSettings = settings;
+    commits++;
+  }
+
+  // The CRC is the last byte written, so a record torn by a power cut never validates
+  for (int n = 0; n < maxBytes && pendingWritten < RECORD_BYTES; n++, pendingWritten++) {
+    int address = pendingAddress + pendingWritten;
+    if (EEPROM.read(address) != pending[pendingWritten]) {
+      EEPROM.write(address, pending[pendingWritten]);
+      eepromWrites++;
+    }
+  }
+}
+
+bool SettingsStore::isDirty() {
+  return pendingWritten < RECORD_BYTES || !isEqual(settings, committedSettings);
+}
+
+uint16_t SettingsStore::getCommits() {
+  return commits;
+}
+
+uint32_t SettingsStore::getEEPROMWrites() {
+  return eepromWrites;
+}
+
+Settings SettingsStore::validate(const Settings& settings) {
+  Settings valid = settings;
+  if (valid.brightness > 15) {
+    valid.brightness = defaults.brightness;
+  }
+  if (valid.responseCurve != CURVE_LINEAR && valid.responseCurve != CURVE_EXPONENTIAL) {
+    valid.responseCurve = defaults.responseCurve; // A custom curve lives in flash and cannot be saved
+  }
+  if (valid.joystickDeadzone > 126) {
+    valid.joystickDeadzone = defaults.joystickDeadzone;
+  }
+  if (valid.braidPercent > 100) {
+    valid.braidPercent = defaults.braidPercent;
+  }
+  return valid;
+}
+
+bool SettingsStore::isEqual(const Settings& first, const Settings& second) {
+  return first.brightness == second.brightness && first.responseCurve == second.responseCurve &&
+         first.joystickDeadzone == second.joystickDeadzone && first.braidPercent == second.braidPercent;
+}
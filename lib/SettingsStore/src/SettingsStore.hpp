@@ -0,0 +1,128 @@
+#include <Arduino.h>
+#ifndef SETTINGS_STORE_HPP
+#define SETTINGS_STORE_HPP
+
+#include <InputShaper.hpp>
+
+/**
+ * @brief The player preferences that survive a power cycle.
+ * @note The maze size and generation algorithm are chosen at compile time in this sketch,
+ *       so they are not settings yet. Each record reserves a byte for each of them.
+ */
+struct Settings {
+  uint8_t brightness;       // Matrix brightness, 0 (dimmest) to 15
+  uint8_t responseCurve;    // CURVE_LINEAR or CURVE_EXPONENTIAL
+  uint8_t joystickDeadzone; // Largest ignored joystick tilt, 0 to 126
+  uint8_t braidPercent;     // Percentage of dead ends braided away in new mazes, 0 to 100
+};
+
+/**
+ * @class SettingsStore
+ * @brief Keeps the settings in RAM and saves them to EEPROM once they stop changing.
+ *
+ * Changes only mark the settings dirty. Once no change has been made for a quiet period
+ * the settings are committed as a single record, a few bytes per frame, so cycling
+ * through values never stalls a frame and only the last value is written.
+ *
+ * Records go to a ring of slots in turn, each with a schema version, a sequence number
+ * and a CRC written last, so the newest complete record wins and a record torn by a
+ * power cut is ignored. A field outside its valid range falls back to its default on
+ * its own, and without any valid record every field does; 0 is a valid brightness.
+ *
+ * Record layout: magic, schema version, sequence, brightness, response curve, deadzone,
+ * braid percent, maze size, maze algorithm, CRC. The maze size and algorithm bytes are
+ * reserved, written as 0 and ignored when loading. Once they become settings, 0 keeps
+ * meaning the compile-time choice, so records saved before then load without a schema
+ * version change.
+ *
+ * Wear: every byte of a slot is written at most once per cycle through all slots, and
+ * unchanged bytes are skipped. With 6 slots the rated 100000 write cycles allow 600000
+ * commits.
+ */
+class SettingsStore {
+public:
+  static const int RECORD_BYTES = 10;
+
+  /**
+   * @brief Constructs a store holding the defaults.
+   * @param eepromAddress The EEPROM address of the first slot.
+   * @param slotCount The number of record slots, the region is slotCount * RECORD_BYTES bytes.
+   * @param defaults The settings used when nothing valid was saved.
+   */
+  SettingsStore(int eepromAddress, int slotCount, const Settings& defaults);
+
+  /**
+   * @brief Loads the newest valid record from EEPROM.
+   * @note Call this once at startup, before any change.
+   * @return True if a record was loaded, false if the defaults are used.
+   */
+  bool load();
+
+  /**
+   * @brief Gets the current settings, including changes not committed yet.
+   * @return The current settings.
+   */
+  const Settings& get();
+
+  /**
+   * @brief Changes the settings and restarts the quiet period.
+   * @note Out of range fields are replaced by their defaults.
+   *
+   * @param settings The new settings.
+   * @param currentTime The current time in milliseconds.
+   */
+  void set(const Settings& settings, uint32_t currentTime);
+
+  /**
+   * @brief Writes changed settings to EEPROM once they have stopped changing.
+   * @note Call this every frame, it returns immediately unless a commit is due.
+   *
+   * @param currentTime The current time in milliseconds.
+   * @param quietPeriod The time without changes before a commit in milliseconds.
+   * @param maxBytes The maximum number of bytes to write in this call.
+   */
+  void persist(uint32_t currentTime, uint32_t quietPeriod, int maxBytes);
+
+  /**
+   * @brief Checks if changes are waiting to be written.
+   * @return True if the settings in RAM differ from the last record, false otherwise.
+   */
+  bool isDirty();
+
+  /**
+   * @brief Gets the number of records committed since startup.
+   * @return The number of commits.
+   */
+  uint16_t getCommits();
+
+  /**
+   * @brief Gets the number of EEPROM bytes written since startup.
+   * @return The number of EEPROM bytes written.
+   */
+  uint32_t getEEPROMWrites();
+
+private:
+  int eepromAddress;
+  int slotCount;
+  Settings defaults;
+  Settings settings;
+  Settings committedSettings;
+  uint8_t nextSlot = 0;
+  uint8_t sequence = 0;
+  uint32_t lastChangeTime = 0;
+  uint16_t commits = 0;
+  uint32_t eepromWrites = 0;
+
+  // The record being written, a few bytes per frame
+  uint8_t pending[RECORD_BYTES];
+  int pendingAddress = 0;
+  int pendingWritten = RECORD_BYTES;
+
+  static const uint8_t SETTINGS_MAGIC = 0x53;
+  static const uint8_t SCHEMA_VERSION = 1;
+
+  Settings validate(const Settings& settings);
+  bool isEqual(const Settings& first, const Settings& second);
+};
+
+#endif
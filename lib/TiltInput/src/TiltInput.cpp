@@ -0,0 +1,82 @@
+#include <Arduino.h>
+#include "TiltInput.hpp"
+
+static const uint8_t FRACTION_BITS = 4;
+
+TiltInput::TiltInput(uint8_t filterShift, uint16_t engageTilt, uint16_t releaseTilt, uint16_t fullTilt)
+    : filterShift(filterShift), engageTilt(engageTilt), releaseTilt(min(releaseTilt, engageTilt)),
+      fullTilt(max(fullTilt, (uint16_t)(engageTilt + 1))) {}
+
+void TiltInput::setDeadzone(uint8_t deadzone) {
+  this->deadzone = min(deadzone, (uint8_t)126);
+}
+
+void TiltInput::startCalibration() {
+  calibrationSums[0] = 0;
+  calibrationSums[1] = 0;
+  calibrationSamplesLeft = CALIBRATION_SAMPLES;
+  engaged[0] = 0;
+  engaged[1] = 0;
+  joystick[0] = 128;
+  joystick[1] = 128;
+}
+
+bool TiltInput::isCalibrating() {
+  return calibrationSamplesLeft > 0;
+}
+
+void TiltInput::update(uint16_t accelX, uint16_t accelY) {
+  uint16_t samples[2] = {accelX, accelY};
+
+  if (calibrationSamplesLeft > 0) {
+    calibrationSums[0] += samples[0];
+    calibrationSums[1] += samples[1];
+    if (--calibrationSamplesLeft == 0) {
+      // The filter starts settled on the level position
+      for (uint8_t axis = 0; axis < 2; axis++) {
+        level[axis] = (calibrationSums[axis] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
+        filtered[axis] = level[axis] << FRACTION_BITS;
+      }
+    }
+    return;
+  }
+
+  for (uint8_t axis = 0; axis < 2; axis++) {
+    // filtered += (sample - filtered) / 2^filterShift
+    int16_t sample = (int16_t)samples[axis] << FRACTION_BITS;
+    filtered[axis] += (sample - filtered[axis]) >> filterShift;
+
+    // An engaged axis stays engaged until its tilt drops below the release tilt, on its side
+    int16_t tilt = getTilt(axis);
+    if (engaged[axis] != 0 && engaged[axis] * tilt < (int16_t)releaseTilt) {
+      engaged[axis] = 0;
+    }
+    if (engaged[axis] == 0 && abs(tilt) >= (int16_t)engageTilt) {
+      engaged[axis] = tilt > 0 ? 1 : -1;
+    }
+    joystick[axis] = toJoystick(axis, tilt);
+  }
+}
+
+uint8_t TiltInput::joyX() {
+  return joystick[0];
+}
+
+uint8_t TiltInput::joyY() {
+  return joystick[1];
+}
+
+int16_t TiltInput::getTilt(uint8_t axis) {
+  return ((filtered[axis] + (1 << (FRACTION_BITS - 1))) >> FRACTION_BITS) - level[axis];
+}
+
+uint8_t TiltInput::toJoystick(uint8_t axis, int16_t tilt) {
+  if (engaged[axis] == 0) {
+    return 128;
+  }
+
+  // From just past the deadzone at the release tilt to full deflection at full tilt
+  uint16_t magnitude = constrain(engaged[axis] * tilt, (int16_t)releaseTilt, (int16_t)fullTilt);
+  uint8_t deflection = deadzone + 1 + (uint32_t)(magnitude - releaseTilt) * (126 - deadzone) / (fullTilt - releaseTilt);
+  return engaged[axis] > 0 ? 128 + deflection : 128 - deflection;
+}
@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#ifndef TILT_INPUT_HPP
+#define TILT_INPUT_HPP
+
+/**
+ * @class TiltInput
+ * @brief Turns the tilt of the nunchuk, read from its accelerometer, into joystick readings.
+ *
+ * Each sample goes through a first order low-pass (IIR) filter kept in 16-bit fixed point,
+ * with 4 fractional bits and a power of two coefficient, so filtering costs a subtraction, a
+ * shift and an addition per axis and no floating point. The filtered tilt is taken from the
+ * level position found by calibration, then each axis goes through hysteresis: it engages
+ * past one tilt and only releases below a smaller one, so holding the nunchuk near the edge
+ * neither stutters nor drifts.
+ *
+ * The result is a joystick reading for InputShaper, 128 at rest, in which an engaged axis
+ * always lies past the deadzone and reaches full deflection at full tilt, at the cost of one
+ * division. Anything that takes joystick readings, such as an input recording, works unchanged.
+ */
+class TiltInput {
+public:
+  static const uint8_t CALIBRATION_SAMPLES = 16;
+
+  /**
+   * @brief Constructs a tilt input, level at the middle of the accelerometer range until it
+   *        is calibrated.
+   * @param filterShift The coefficient of the filter is 1 / 2^filterShift, 0 leaves samples
+   *                    unfiltered and each step up roughly doubles the delay of a tilt.
+   * @param engageTilt The tilt past which an axis moves, in accelerometer units, about 200
+   *                   per g.
+   * @param releaseTilt The tilt below which an engaged axis stops, smaller than engageTilt.
+   * @param fullTilt The tilt at which an axis moves at full speed.
+   */
+  TiltInput(uint8_t filterShift, uint16_t engageTilt, uint16_t releaseTilt, uint16_t fullTilt);
+
+  /**
+   * @brief Changes the deadzone of the joystick readings, which engaged axes are kept past.
+   * @param deadzone The deadzone of the InputShaper the readings are given to.
+   */
+  void setDeadzone(uint8_t deadzone);
+
+  /**
+   * @brief Starts taking the level position from the next CALIBRATION_SAMPLES samples, the
+   *        readings stay at rest meanwhile.
+   * @note The nunchuk should be held level and still while it is calibrated.
+   */
+  void startCalibration();
+
+  /**
+   * @brief Checks if the level position is being calibrated.
+   * @return True while calibration samples are taken, false otherwise.
+   */
+  bool isCalibrating();
+
+  /**
+   * @brief Filters an accelerometer sample, or adds it to the calibration.
+   * @note Call this at each nunchuk poll, the delay of the filter is counted in polls.
+   *
+   * @param accelX The X axis of the accelerometer, 0 to 1023, larger values rolled right.
+   * @param accelY The Y axis of the accelerometer, 0 to 1023, larger values pitched forward.
+   */
+  void update(uint16_t accelX, uint16_t accelY);
+
+  /**
+   * @brief Gets the horizontal joystick reading of the last sample.
+   * @return 128 at rest, larger values right.
+   */
+  uint8_t joyX();
+
+  /**
+   * @brief Gets the vertical joystick reading of the last sample.
+   * @return 128 at rest, larger values up, which is pitching forward.
+   */
+  uint8_t joyY();
+
+  /**
+   * @brief Gets the filtered tilt from the level position.
+   * @param axis 0 for X, 1 for Y.
+   * @return The tilt in accelerometer units.
+   */
+  int16_t getTilt(uint8_t axis);
+
+private:
+  uint8_t filterShift;
+  uint16_t engageTilt;
+  uint16_t releaseTilt;
+  uint16_t fullTilt;
+  uint8_t deadzone = 0;
+
+  int16_t level[2] = {512, 512};
+  int16_t filtered[2] = {512 << 4, 512 << 4}; // Fixed point with 4 fractional bits
+  int8_t engaged[2] = {0, 0};                  // -1 or 1 while an axis is engaged, 0 at rest
+  uint8_t joystick[2] = {128, 128};            // The readings of the last sample
+  uint16_t calibrationSums[2] = {0, 0};
+  uint8_t calibrationSamplesLeft = 0;
+
+  uint8_t toJoystick(uint8_t axis, int16_t tilt);
+};
+
+#endif
@@ -0,0 +1,335 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Crc8.hpp>
+#include "TimeTrial.hpp"
+
+// Slot layout: magic, sequence, seed (4 bytes), best time (4), time the path starts (4), moves
+// of the path (2), bytes of the path, CRC of the header and the path, then the path itself.
+// A byte of the path is ddllllll, with dd the direction and llllll the length of the run minus 1.
+static const uint8_t SEQUENCE_OFFSET = 1;
+static const uint8_t SEED_OFFSET = 2;
+static const uint8_t BEST_TIME_OFFSET = 6;
+static const uint8_t START_TIME_OFFSET = 10;
+static const uint8_t MOVES_OFFSET = 14;
+static const uint8_t PATH_BYTES_OFFSET = 16;
+static const uint8_t CRC_OFFSET = 17;
+
+// Indexed by the direction of a run: up, right, down, left
+static const int8_t ROW_STEPS[4] = {-1, 0, 1, 0};
+static const int8_t COLUMN_STEPS[4] = {0, 1, 0, -1};
+
+TimeTrial::TimeTrial(int eepromAddress, uint8_t slotCount, uint8_t slotBytes)
+    : eepromAddress(eepromAddress), slotCount(slotCount), slotBytes(slotBytes) {
+  pathCapacity = slotBytes - HEADER_BYTES;
+  path = new uint8_t[pathCapacity];
+  pending = new uint8_t[slotBytes];
+}
+
+void TimeTrial::startRun(uint32_t seed, MazePosition start) {
+  this->seed = seed;
+  startPosition = start;
+  lastPosition = start;
+  isRunInProgress = true;
+  isRunValid = true;
+  pathBytes = 0;
+  pathMoves = 0;
+  pathStartTime = 0;
+  isPathFull = false;
+
+  // The ghost is the newest slot of the seed. The run is saved to an older slot of the seed left
+  // by a power cut, or a free slot, or the least recently written one but the ghost, so the
+  // ghost stays valid until the run is complete. Sequence numbers wrap around so compare their
+  // difference
+  uint8_t header[HEADER_BYTES];
+  uint8_t ghostSequence = 0;
+  int supersededSlot = -1;
+  int freeSlot = -1;
+  int oldestSlot = -1;
+  int secondOldestSlot = -1;
+  uint8_t oldestSequence = 0;
+  uint8_t secondOldestSequence = 0;
+  uint8_t newestSequence = 0;
+  bool isAnySlotValid = false;
+  ghostSlot = -1;
+  bestTime = 0;
+  for (int slot = 0; slot < slotCount; slot++) {
+    if (!readHeader(slot, header)) {
+      if (freeSlot < 0) {
+        freeSlot = slot;
+      }
+      continue;
+    }
+    uint8_t sequence = header[SEQUENCE_OFFSET];
+    if (!isAnySlotValid || (int8_t)(sequence - newestSequence) > 0) {
+      newestSequence = sequence;
+    }
+    if (oldestSlot < 0 || (int8_t)(sequence - oldestSequence) < 0) {
+      secondOldestSlot = oldestSlot;
+      secondOldestSequence = oldestSequence;
+      oldestSequence = sequence;
+      oldestSlot = slot;
+    } else if (secondOldestSlot < 0 || (int8_t)(sequence - secondOldestSequence) < 0) {
+      secondOldestSequence = sequence;
+      secondOldestSlot = slot;
+    }
+    isAnySlotValid = true;
+    if (readWord(&header[SEED_OFFSET], 4) != seed) {
+      continue;
+    }
+    if (ghostSlot >= 0 && (int8_t)(sequence - ghostSequence) < 0) {
+      supersededSlot = slot;
+      continue;
+    }
+    supersededSlot = ghostSlot;
+    ghostSlot = slot;
+    ghostSequence = sequence;
+    bestTime = readWord(&header[BEST_TIME_OFFSET], 4);
+    ghostStartTime = readWord(&header[START_TIME_OFFSET], 4);
+    ghostMoves = readWord(&header[MOVES_OFFSET], 2);
+    ghostBytes = header[PATH_BYTES_OFFSET];
+  }
+  nextSequence = isAnySlotValid ? newestSequence + 1 : 0;
+  if (supersededSlot >= 0) {
+    writeSlot = supersededSlot;
+  } else if (freeSlot >= 0) {
+    writeSlot = freeSlot;
+  } else if (oldestSlot != ghostSlot || secondOldestSlot < 0) {
+    writeSlot = oldestSlot;
+  } else {
+    writeSlot = secondOldestSlot;
+  }
+  restartGhost();
+}
+
+void TimeTrial::cancelRun() {
+  isRunInProgress = false;
+  ghostSlot = -1;
+  bestTime = 0;
+}
+
+void TimeTrial::recordPosition(Maze& maze, MazePosition position, uint32_t elapsedTime) {
+  if (!isRunInProgress || (position.row == lastPosition.row && position.column == lastPosition.column)) {
+    return;
+  }
+  MazePosition from = lastPosition;
+  int rowStep = position.row - from.row;
+  int columnStep = position.column - from.column;
+  lastPosition = position;
+
+  if (abs(rowStep) + abs(columnStep) == 1) {
+    recordStep(rowStep, columnStep);
+  } else if (abs(rowStep) == 1 && abs(columnStep) == 1 && !maze.isCollision(from.row, position.column)) {
+    recordStep(0, columnStep);
+    recordStep(rowStep, 0);
+  } else if (abs(rowStep) == 1 && abs(columnStep) == 1 && !maze.isCollision(position.row, from.column)) {
+    recordStep(rowStep, 0);
+    recordStep(0, columnStep);
+  } else if (position.row == startPosition.row && position.column == startPosition.column) {
+    // Sent back to the start, the ghost will wait there until the player left it for the last time
+    pathBytes = 0;
+    pathMoves = 0;
+    pathStartTime = elapsedTime;
+    isPathFull = false;
+  } else {
+    isRunValid = false;
+  }
+}
+
+void TimeTrial::recordStep(int rowStep, int columnStep) {
+  uint8_t direction = rowStep < 0 ? 0 : columnStep > 0 ? 1 : rowStep > 0 ? 2 : 3;
+  uint8_t* lastRun = pathBytes > 0 ? &path[pathBytes - 1] : nullptr;
+  if (isPathFull) {
+    // Only the beginning of the path fits, the moves are still counted for the pace of the ghost
+  } else if (lastRun != nullptr && *lastRun >> 6 == direction && (*lastRun & 0x3F) < MAX_RUN_LENGTH - 1) {
+    (*lastRun)++;
+  } else if (pathBytes < pathCapacity) {
+    path[pathBytes++] = direction << 6;
+  } else {
+    isPathFull = true;
+  }
+  if (pathMoves < 0xFFFF) {
+    pathMoves++;
+  }
+}
+
+bool TimeTrial::finishRun(uint32_t elapsedTime) {
+  if (!isRunInProgress) {
+    return false;
+  }
+  isRunInProgress = false;
+  if (!isRunValid || (ghostSlot >= 0 && elapsedTime >= bestTime)) {
+    return false;
+  }
+
+  // A single slot is staged, one still being written is finished first
+  step(slotBytes);
+  pending[0] = SLOT_MAGIC;
+  pending[SEQUENCE_OFFSET] = nextSequence;
+  writeWord(&pending[SEED_OFFSET], seed, 4);
+  writeWord(&pending[BEST_TIME_OFFSET], elapsedTime, 4);
+  writeWord(&pending[START_TIME_OFFSET], pathStartTime, 4);
+  writeWord(&pending[MOVES_OFFSET], pathMoves, 2);
+  pending[PATH_BYTES_OFFSET] = pathBytes;
+  memcpy(&pending[HEADER_BYTES], path, pathBytes);
+  pending[CRC_OFFSET] = crc8(crc8(0, pending, CRC_OFFSET), path, pathBytes);
+  pendingSlot = writeSlot;
+  pendingLength = HEADER_BYTES + pathBytes;
+  pendingWritten = 0;
+  supersededSlot = ghostSlot != writeSlot ? ghostSlot : -1;
+
+  // The next run of this maze races this one
+  ghostSlot = writeSlot;
+  bestTime = elapsedTime;
+  ghostStartTime = pathStartTime;
+  ghostMoves = pathMoves;
+  ghostBytes = pathBytes;
+  nextSequence++;
+  restartGhost();
+  return true;
+}
+
+void TimeTrial::step(int maxBytes) {
+  if (pendingSlot < 0) {
+    return;
+  }
+  // The CRC is the last byte written, so a slot torn by a power cut never validates
+  int address = getSlotAddress(pendingSlot);
+  int n = 0;
+  for (; n < maxBytes && pendingWritten < pendingLength; n++, pendingWritten++) {
+    uint8_t offset = pendingWritten < CRC_OFFSET ? pendingWritten : pendingWritten + 1;
+    if (pendingWritten == pendingLength - 1) {
+      offset = CRC_OFFSET;
+    }
+    writeByte(address + offset, pending[offset]);
+  }
+  if (pendingWritten < pendingLength || n >= maxBytes) {
+    return;
+  }
+  // Then the previous best of the maze is erased, so its slot is free for the next run
+  if (supersededSlot >= 0) {
+    writeByte(getSlotAddress(supersededSlot), 0xFF);
+    supersededSlot = -1;
+  }
+  pendingSlot = -1;
+}
+
+bool TimeTrial::isRunning() {
+  return isRunInProgress;
+}
+
+bool TimeTrial::hasGhost() {
+  return ghostSlot >= 0;
+}
+
+uint32_t TimeTrial::getBestTime() {
+  return bestTime;
+}
+
+bool TimeTrial::getGhostPosition(uint32_t elapsedTime, MazePosition& position) {
+  if (ghostSlot < 0) {
+    return false;
+  }
+
+  // The move the ghost is at, at the average pace of the best run. Both times are scaled
+  // down so the product fits in 32 bits
+  uint16_t move = ghostMoves;
+  if (elapsedTime < bestTime && ghostStartTime < bestTime) {
+    uint32_t walked = elapsedTime > ghostStartTime ? elapsedTime - ghostStartTime : 0;
+    uint32_t span = bestTime - ghostStartTime;
+    while (span > 0xFFFF) {
+      span >>= 1;
+      walked >>= 1;
+    }
+    move = walked * ghostMoves / span;
+  }
+
+  // Decoding carries on from the previous frame, the ghost rarely enters more than one run
+  if (move < ghostRunFirstMove) {
+    restartGhost();
+  }
+  while (ghostRunIndex + 1 < ghostBytes && move >= ghostRunFirstMove + (ghostRun & 0x3F) + 1) {
+    uint8_t length = (ghostRun & 0x3F) + 1;
+    ghostRunStart = advance(ghostRunStart, ghostRun, length);
+    ghostRunFirstMove += length;
+    ghostRunIndex++;
+    ghostRun = readSlotByte(ghostSlot, HEADER_BYTES + ghostRunIndex);
+  }
+  if (ghostBytes == 0) {
+    position = ghostRunStart;
+    return true;
+  }
+  uint16_t steps = move - ghostRunFirstMove;
+  position = advance(ghostRunStart, ghostRun, min(steps, (uint16_t)((ghostRun & 0x3F) + 1)));
+  return true;
+}
+
+int TimeTrial::getRAMBytes() {
+  return pathCapacity + slotBytes;
+}
+
+uint32_t TimeTrial::getEEPROMWrites() {
+  return eepromWrites;
+}
+
+bool TimeTrial::readHeader(int slot, uint8_t* header) {
+  for (uint8_t i = 0; i < HEADER_BYTES; i++) {
+    header[i] = readSlotByte(slot, i);
+  }
+  if (header[0] != SLOT_MAGIC || header[PATH_BYTES_OFFSET] > pathCapacity) {
+    return false;
+  }
+  uint8_t crc = crc8(0, header, CRC_OFFSET);
+  for (uint8_t i = 0; i < header[PATH_BYTES_OFFSET]; i++) {
+    uint8_t run = readSlotByte(slot, HEADER_BYTES + i);
+    crc = crc8(crc, &run, 1);
+  }
+  return crc == header[CRC_OFFSET];
+}
+
+void TimeTrial::restartGhost() {
+  ghostRunIndex = 0;
+  ghostRunFirstMove = 0;
+  ghostRunStart = startPosition;
+  ghostRun = ghostSlot >= 0 && ghostBytes > 0 ? readSlotByte(ghostSlot, HEADER_BYTES) : 0;
+}
+
+int TimeTrial::getSlotAddress(int slot) {
+  return eepromAddress + slot * slotBytes;
+}
+
+uint8_t TimeTrial::readSlotByte(int slot, uint8_t offset) {
+  // The slot being written is read from RAM until it is complete
+  if (slot == pendingSlot) {
+    return pending[offset];
+  }
+  return EEPROM.read(getSlotAddress(slot) + offset);
+}
+
+void TimeTrial::writeByte(int address, uint8_t value) {
+  // Like EEPROM.update, an unchanged byte is neither written nor worn
+  if (EEPROM.read(address) != value) {
+    EEPROM.write(address, value);
+    eepromWrites++;
+  }
+}
+
+MazePosition TimeTrial::advance(MazePosition position, uint8_t run, uint8_t steps) {
+  uint8_t direction = run >> 6;
+  position.row += ROW_STEPS[direction] * steps;
+  position.column += COLUMN_STEPS[direction] * steps;
+  return position;
+}
+
+uint32_t TimeTrial::readWord(const uint8_t* bytes, uint8_t length) {
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < length; i++) {
+    value |= (uint32_t)bytes[i] << (8 * i);
+  }
+  return value;
+}
+
+void TimeTrial::writeWord(uint8_t* bytes, uint32_t value, uint8_t length) {
+  for (uint8_t i = 0; i < length; i++) {
+    bytes[i] = value >> (8 * i);
+  }
+}
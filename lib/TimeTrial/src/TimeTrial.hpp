@@ -0,0 +1,185 @@
+#include <Arduino.h>
+#ifndef TIME_TRIAL_HPP
+#define TIME_TRIAL_HPP
+
+#include <Maze.hpp>
+
+/**
+ * @class TimeTrial
+ * @brief Keeps the best time of recently played mazes in EEPROM, along with the path of the
+ *        best run, which is played back as a ghost in later runs of the same maze.
+ *
+ * Mazes are told apart by their seed. Each slot holds a seed, its best time and the path of
+ * the best run as runs of moves in one direction, 2 bits of direction and 6 bits of length per
+ * byte, so a straight corridor of up to 64 steps costs a single byte. A run through a 16x16
+ * maze takes 20 to 60 bytes. A path longer than a slot keeps its beginning, the ghost then
+ * stops where the stored path ends.
+ *
+ * The ghost walks the path at the average pace of the best run, from the last time the player
+ * left the start, so a run that was sent back by the enemy still has a ghost. Playback is
+ * incremental: a frame costs one division, plus one EEPROM read when the ghost enters the next
+ * run of moves.
+ *
+ * A slot is written only when its best time is beaten. The slot is staged in RAM and written a
+ * few bytes per frame by step, with a CRC written last so a slot torn by a power cut is ignored.
+ * A new best time goes to another slot than the previous one, which is erased once the new one
+ * is complete, so the previous best stays valid until then. If a power cut leaves both, the
+ * newest sequence number wins and the older slot is written next. Otherwise a free slot is
+ * taken, or the maze improved least recently makes room, so when every slot holds another
+ * maze an improved time costs a slot like a new maze does. With a single slot the previous
+ * best is overwritten in place.
+ */
+class TimeTrial {
+public:
+  static const uint8_t HEADER_BYTES = 18;
+
+  /**
+   * @brief Constructs a time trial with no run in progress.
+   * @param eepromAddress The EEPROM address of the first slot.
+   * @param slotCount The number of mazes whose best time is kept, the region is
+   *                  slotCount * slotBytes bytes.
+   * @param slotBytes The size of a slot, the path of a run gets slotBytes - HEADER_BYTES bytes
+   *                  and as much RAM while it is recorded, and slotBytes more RAM stage a
+   *                  slot while it is written.
+   */
+  TimeTrial(int eepromAddress, uint8_t slotCount, uint8_t slotBytes);
+
+  /**
+   * @brief Starts timing a run from the start of a maze, with the best run of the maze as the
+   *        ghost if it has one.
+   * @param seed The seed of the maze.
+   * @param start The start position of the maze.
+   */
+  void startRun(uint32_t seed, MazePosition start);
+
+  /**
+   * @brief Stops timing the run in progress without saving it, and hides the ghost.
+   */
+  void cancelRun();
+
+  /**
+   * @brief Adds the player's position to the path of the run. A run in which the player jumps
+   *        anywhere but back to the start can no longer set a best time.
+   * @note Call this every frame, it returns immediately unless the player moved. A diagonal
+   *       move is recorded as the two straight moves around the open corner it cuts.
+   *
+   * @param maze The maze of the run.
+   * @param position The position of the player.
+   * @param elapsedTime The time since the start of the run in milliseconds.
+   */
+  void recordPosition(Maze& maze, MazePosition position, uint32_t elapsedTime);
+
+  /**
+   * @brief Ends the run in progress at the end of the maze, and stages it to be saved if it is
+   *        the best one.
+   * @note The staged slot counts as saved at once, the next run of the maze races it while
+   *       step writes it. Only a slot still being written when another run sets a best time
+   *       is written in full here.
+   *
+   * @param elapsedTime The time the run took in milliseconds.
+   * @return True if the run set a new best time, false otherwise.
+   */
+  bool finishRun(uint32_t elapsedTime);
+
+  /**
+   * @brief Writes the staged slot to EEPROM a few bytes at a time.
+   * @note Call this every frame, it returns immediately unless a slot is staged.
+   * @param maxBytes The maximum number of bytes to write in this call.
+   */
+  void step(int maxBytes);
+
+  /**
+   * @brief Checks if a run is being timed.
+   * @return True if a run is in progress, false otherwise.
+   */
+  bool isRunning();
+
+  /**
+   * @brief Checks if the maze of the run has a best time and a ghost.
+   * @return True if the maze was completed before, false otherwise.
+   */
+  bool hasGhost();
+
+  /**
+   * @brief Gets the best time of the maze of the run.
+   * @return The best time in milliseconds, 0 without one.
+   */
+  uint32_t getBestTime();
+
+  /**
+   * @brief Gets where the ghost of the best run is at a time of the current run.
+   * @note Meant to be called every frame with increasing times, going back in time restarts
+   *       the ghost from the beginning of its path.
+   *
+   * @param elapsedTime The time since the start of the run in milliseconds.
+   * @param position Set to the position of the ghost.
+   * @return True if there is a ghost, false otherwise.
+   */
+  bool getGhostPosition(uint32_t elapsedTime, MazePosition& position);
+
+  /**
+   * @brief Gets the RAM used to record the path of a run.
+   * @return The number of bytes.
+   */
+  int getRAMBytes();
+
+  /**
+   * @brief Gets the number of EEPROM bytes written since startup.
+   * @return The number of EEPROM bytes written.
+   */
+  uint32_t getEEPROMWrites();
+
+private:
+  int eepromAddress;
+  uint8_t slotCount;
+  uint8_t slotBytes;
+  uint8_t pathCapacity;
+  uint32_t eepromWrites = 0;
+
+  // The run in progress
+  bool isRunInProgress = false;
+  bool isRunValid = false;
+  uint32_t seed = 0;
+  MazePosition startPosition = {0, 0};
+  MazePosition lastPosition = {0, 0};
+  uint8_t* path;
+  uint8_t pathBytes = 0;
+  uint16_t pathMoves = 0; // Moves since the last start, including those past the end of the path
+  bool isPathFull = false;
+  uint32_t pathStartTime = 0;
+  int writeSlot = 0;
+  uint8_t nextSequence = 0;
+
+  // The slot being written, a few bytes per frame
+  uint8_t* pending;
+  int pendingSlot = -1; // -1 if no slot is being written
+  int supersededSlot = -1; // The previous best of the maze, erased once the pending slot is complete
+  uint8_t pendingLength = 0;
+  uint8_t pendingWritten = 0;
+
+  // The best run of the maze, played back from its slot
+  int ghostSlot = -1;
+  uint32_t bestTime = 0;
+  uint32_t ghostStartTime = 0;
+  uint16_t ghostMoves = 0;
+  uint8_t ghostBytes = 0;
+  uint8_t ghostRunIndex = 0; // The run of moves the ghost is in
+  uint8_t ghostRun = 0;
+  uint16_t ghostRunFirstMove = 0;
+  MazePosition ghostRunStart = {0, 0};
+
+  static const uint8_t SLOT_MAGIC = 0x47;
+  static const uint8_t MAX_RUN_LENGTH = 64;
+
+  bool readHeader(int slot, uint8_t* header);
+  void restartGhost();
+  void recordStep(int rowStep, int columnStep);
+  int getSlotAddress(int slot);
+  uint8_t readSlotByte(int slot, uint8_t offset);
+  void writeByte(int address, uint8_t value);
+  static MazePosition advance(MazePosition position, uint8_t run, uint8_t steps);
+  static uint32_t readWord(const uint8_t* bytes, uint8_t length);
+  static void writeWord(uint8_t* bytes, uint32_t value, uint8_t length);
+};
+
+#endif
@@ -5,15 +5,173 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_LEDBackpack.h>
 #include <NintendoExtensionCtrl.h>
+#include <Minimap.hpp>
+#include <GameJournal.hpp>
+#include <InputShaper.hpp>
+#include <SettingsStore.hpp>
+// Log messages above this level are left out of the build: LOG_LEVEL_NONE, LOG_LEVEL_ERROR, LOG_LEVEL_WARN,
+// LOG_LEVEL_INFO or LOG_LEVEL_DEBUG. Every move and collision is logged at LOG_LEVEL_DEBUG
+#define LOG_LEVEL LOG_LEVEL_INFO
+#include <Logger.hpp>
 
 // Uncomment the line below to enable player position debug output, which slows down the game
 // #define DEBUG_PLAYER_POSITION
 
-void printSubMazeToLEDMatrix(uint8_t** subMaze, int width, int height, bool playerBlinkState, bool endBlinkState = false);
+// Uncomment the line below to page the maze in from EEPROM tiles instead of keeping it in RAM.
+// This allows mazes larger than RAM permits and reports tile cache hits, misses and fetch time as the player moves
+// #define PAGED_MAZE
+
+// Uncomment the line below to only draw the cells the player has seen. Seen cells are saved to EEPROM in small
+// batches, so they survive a power cycle along with the run in progress
+// #define FOG_OF_WAR
+
+// Uncomment the line below to play the precomputed mazes of include/MazePack.h, from easiest to hardest, instead of
+// generating new ones. Regenerate the pack with tools/mazepack
+// #define USE_MAZE_PACK
+
+// Uncomment the line below to time dead end and junction counting with bitboards against per-cell loops at startup
+// #define BENCHMARK_MAZE_ANALYSIS
+
+// Uncomment the line below to time the integer joystick processing against the previous floating point version at
+// startup
+// #define BENCHMARK_INPUT_SHAPING
+
+// Uncomment the line below to track the heap and stack high-water marks and print them, along with the largest maze
+// that fits in RAM, at startup and whenever a new maze is ready. The native build counts the heap only when the whole
+// build is compiled with -DMEMORY_STATS
+// #define MEMORY_STATS
+
+// Uncomment the line below to keep walking along a corridor after a single tilt, up to the next junction or dead end.
+// Each maze is compressed into a graph of its junctions once, its size and the time to solve it are printed
+// #define AUTO_RUN
+
+// Uncomment the line below to add an enemy that chases the player along the shortest path and sends them back to
+// the start when it catches them. The time spent keeping its path up to date is printed for every maze
+// #define CHASING_ENEMY
+
+// Uncomment the line below to braid generated mazes, opening walls at a share of the dead ends so the mazes have
+// loops and more than one way through. The dead ends removed, loops added and time taken are printed for every maze.
+// Not available with CHASING_ENEMY, whose path is only updated cheaply in mazes without loops
+// #define BRAIDED_MAZES
+
+// Uncomment the line below to control the game from the serial monitor: seed, regen, dump, stats, goto and bench,
+// type help for the list. Commands are read a few bytes per frame, so typing never stalls the game
+// #define SERIAL_CONSOLE
+
+// Uncomment the line below to stream the game to tools/mazeviewer as binary frames, a compact alternative to
+// DEBUG_PLAYER_POSITION. Each maze is sent once and each move costs 6 bytes instead of a reprint of the maze
+// #define FRAME_STREAM
+
+// Uncomment the line below to record the nunchuk samples of each maze in a RAM ring, so a reported bug or a real
+// session can be replayed exactly, and as fast as possible, on a computer with tools/mazereplay. The recording is
+// printed whenever the end of a maze is reached, and by the rec command of SERIAL_CONSOLE. A maze loaded from EEPROM
+// at power on is not recorded, its seed is not saved
+// #define INPUT_RECORDING
+
+// Uncomment the line below to race against your best time. Reaching the end restarts the same maze, with the best run
+// of it played back as a dim blinking ghost, and C moves on to a new maze. The best times and paths of the last 4
+// mazes played are kept in EEPROM
+// #define TIME_TRIAL
+
+// Uncomment the line below to steer by tilting the nunchuk instead of with the joystick. The nunchuk is calibrated
+// level while the up arrow is shown at power on, and again with the tilt command of SERIAL_CONSOLE. The delay the
+// tilt filter adds over the joystick is printed at startup
+// #define TILT_CONTROL
+
+#if defined(CHASING_ENEMY) && defined(BRAIDED_MAZES)
+#error "CHASING_ENEMY cannot be combined with BRAIDED_MAZES, the path of the enemy would be rebuilt on every move"
+#endif
+
+#ifdef FOG_OF_WAR
+#include <FogOfWar.hpp>
+#endif
+#ifdef BENCHMARK_MAZE_ANALYSIS
+#include <MazeBitboard.hpp>
+#endif
+#ifdef MEMORY_STATS
+#include <MemoryStats.hpp>
+#endif
+#ifdef USE_MAZE_PACK
+#include <MazePack.h>
+#endif
+#ifdef AUTO_RUN
+#include <JunctionGraph.hpp>
+#endif
+#ifdef CHASING_ENEMY
+#include <DistanceField.hpp>
+#endif
+#ifdef SERIAL_CONSOLE
+#include <SerialConsole.hpp>
+#endif
+#ifdef FRAME_STREAM
+#include <FrameStream.hpp>
+#endif
+#ifdef INPUT_RECORDING
+#include <InputRecorder.hpp>
+#endif
+#ifdef TIME_TRIAL
+#include <TimeTrial.hpp>
+#endif
+#ifdef TILT_CONTROL
+#include <TiltInput.hpp>
+#endif
+
+void printSubMazeToLEDMatrix(uint8_t** subMaze, int width, int height, bool playerBlinkState, bool endBlinkState = false, bool ghostBlinkState = false);
 void playEndAnimation();
 void printUpArrowToLEDMatrix();
+void printMinimapToLEDMatrix(bool playerBlinkState, bool endBlinkState);
+void startNewMaze();
+void beginLevelTransition();
+void finishNewMaze();
+void startRun();
+void printGenerationProgressToLEDMatrix(uint8_t progress);
+void trackRegenerationFrame(uint32_t frameStartMicros);
+void applySettings();
+void readJoystick(uint8_t& joyX, uint8_t& joyY);
+GameState getGameState();
+#ifdef BENCHMARK_MAZE_ANALYSIS
+void benchmarkMazeAnalysis();
+#endif
+#ifdef BENCHMARK_INPUT_SHAPING
+void benchmarkInputShaping();
+#endif
+#ifdef AUTO_RUN
+void startAutoRun(uint8_t direction);
+void printJunctionGraphToSerial();
+#endif
+#ifdef CHASING_ENEMY
+void resetEnemy(uint32_t currentTime);
+void updateEnemy(uint32_t currentTime);
+void logEnemyStats();
+#endif
+#ifdef BRAIDED_MAZES
+void logBraidStats();
+#endif
+#ifdef SERIAL_CONSOLE
+void handleConsoleCommand();
+void startSeededMaze(uint32_t seed);
+void updateFrameBench(uint32_t frameStartMicros);
+#endif
+#ifdef INPUT_RECORDING
+void startRecording(uint32_t currentTime);
+void restoreRecording(const RecordingStart& start);
+#endif
+#ifdef TIME_TRIAL
+void startTimeTrial();
+#endif
+#ifdef TILT_CONTROL
+void printTiltLatencyToSerial();
+#endif
 
-Maze maze(16, 16); // max size depends on EEPROM storage and RAM, feel free to experiment
+#ifdef PAGED_MAZE
+EEPROMTileStore tileStore(1); // Address 0 holds the brightness saved before the settings store
+TileCache tileCache(tileStore, 4); // 4 tiles cover the 8x8 view wherever the player stands
+Maze maze(32, 32, &tileCache); // max size depends on EEPROM storage (2 bits per cell), feel free to experiment
+#elif defined(USE_MAZE_PACK)
+Maze maze(MAZE_PACK_ROWS, MAZE_PACK_COLUMNS); // The size of the mazes in the pack
+#else
+Maze maze(16, 16); // max size depends on EEPROM storage and RAM, MEMORY_STATS prints the largest size that fits
+#endif
 Adafruit_8x8matrix matrix = Adafruit_8x8matrix();
 Nunchuk nunchuck;
 
@@ -24,49 +182,325 @@ const int PLAYER_MATRIX_POSITION_Y = 3;
 const int PLAYER_MATRIX_POSITION_X = 3;
 
 const int NUNCHUCK_CHECK_FREQUENCY = 100; // Frequency to check nunchuck in milliseconds
+const uint32_t UP_ARROW_TIME = 2000; // How long the up arrow is shown at power on, unless the player moves first
 const int JOYSTICK_DEADZONE = 55; // Deadzone for joystick
 const int MIN_MOVE_DELAY = 100; // Minimum delay between player movements
 const int MAX_MOVE_DELAY = 500; // Maximum delay between player movements
+const ResponseCurve JOYSTICK_CURVE = CURVE_LINEAR; // How the movement speed follows the joystick tilt
+const int MINIMAP_ROWS_PER_FRAME = 4; // Maze rows downscaled per frame while the minimap is out of date
+const int GENERATION_STEPS_PER_FRAME = 16; // Maze generation steps run per frame while a new maze is generated
+const int GENERATION_BYTES_PER_FRAME = 4; // Tile bytes a paged maze writes back per frame while it is generated
+const int BACKGROUND_GENERATION_STEPS_PER_FRAME = 8; // Steps per frame spent generating the next maze in the background
+const int MAZE_SAVE_BYTES_PER_FRAME = 2; // Maze bytes written to EEPROM per frame, each write takes about 3.3 ms
+
+const int EEPROM_LEGACY_BRIGHTNESS_ADDRESS = 0; // Where brightness was stored before the settings store, read to migrate it
+const uint8_t DEFAULT_BRIGHTNESS = 15; // Default brightness if none was saved
+const int EEPROM_SETTINGS_ADDRESS = 960; // The last 64 bytes of EEPROM, past the maze, journal and fog of war
+const int SETTINGS_SLOTS = 6; // Settings records written in turn, each byte wears 6 times slower
+const uint32_t SETTINGS_QUIET_PERIOD = 3000; // Time without changes before settings are saved in milliseconds
+const int SETTINGS_BYTES_PER_FRAME = 1; // Maximum EEPROM bytes written per frame while saving settings
+
+const int EEPROM_JOURNAL_ADDRESS = 258; // After the maze and its checksum
+const int JOURNAL_HALF_SIZE = 64; // Each half holds a snapshot and 10 deltas
+const uint32_t JOURNAL_RECORD_INTERVAL = 5000; // Minimum time between journal records in milliseconds
+const int JOURNAL_BYTES_PER_FRAME = 2; // Maximum EEPROM bytes written per frame by the journal
 
-const int EEPROM_BRIGHTNESS_ADDRESS = 0; // EEPROM address to store brightness
-const uint8_t DEFAULT_BRIGHTNESS = 15; // Default brightness if EEPROM value is 0
-uint8_t currentBrightness = DEFAULT_BRIGHTNESS; // Default brightness
+#ifdef FOG_OF_WAR
+const int EEPROM_FOG_ADDRESS = EEPROM_JOURNAL_ADDRESS + 2 * JOURNAL_HALF_SIZE; // After the journal
+const int FOG_VIEW_DISTANCE = 4; // How far the player sees along a corridor
+const uint32_t FOG_COMMIT_INTERVAL = 10000; // Minimum time between saves of the fog of war in milliseconds
+const int FOG_BYTES_PER_FRAME = 8; // Maximum EEPROM bytes written per frame while saving
+#endif
+
+#ifdef CHASING_ENEMY
+const uint32_t ENEMY_START_DELAY = 5000; // Head start of the player in each maze in milliseconds
+const int ENEMY_MOVE_DELAY = 300; // Delay between enemy moves in milliseconds
+const int ENEMY_BLINK_FREQUENCY = 125; // In milliseconds, faster than the player so both can be told apart
+#endif
+
+#ifdef BRAIDED_MAZES
+const uint8_t BRAID_PERCENT = 30; // Default percentage of dead ends opened into loops, 100 leaves almost none
+#else
+const uint8_t BRAID_PERCENT = 0; // Mazes stay perfect
+#endif
 
 MazePosition playerPosition = maze.getStartPosition();
+uint16_t moveCount = 0; // Moves made in the current maze
+uint8_t mazeKey = 0; // Maze::calculateKey of the current maze, so a journaled run only resumes in its own maze
+uint32_t elapsedTime = 0; // Time spent in the current maze in milliseconds
+uint32_t lastPlayerMoveTime = 0;
+uint32_t lastNunchuckCheckTime = 0;
+bool isNunchuckConnected = false; // The joystick reads at rest while the nunchuk is not connected
+bool wasZPressed = false; // Z acts once per press
+bool wasCPressed = false; // C acts when it is released
+bool isChordHeld = false; // C and Z were pressed together, neither acts alone until both are released
+
+// Milliseconds from power on to the up arrow, to the first frame of the maze and to the first reading of the
+// nunchuk, reported once all three happened
+uint32_t firstFrameTime = 0;
+uint32_t firstMazeFrameTime = 0;
+uint32_t firstInputTime = 0;
+bool isUpArrowShown = true;
+
+bool isRegenerating = false; // True while a new maze is being generated or saved
+bool isSavingMaze = false;
+uint16_t regenerationFrames = 0;
+uint32_t worstRegenerationFrameMicros = 0;
+uint32_t levelTransitionStartMicros = 0;
+
+#ifdef USE_MAZE_PACK
+int packLevel = 0; // Index of the maze pack entry being played
+#endif
+
+#ifdef SERIAL_CONSOLE
+const uint8_t CONSOLE_BYTES_PER_FRAME = 8; // Maximum console input bytes read per frame
+const uint16_t DEFAULT_BENCH_FRAMES = 256; // Frames timed by bench without an argument
+SerialConsole console;
+uint16_t benchFrames = 0; // Frames the running bench times
+uint16_t benchFramesLeft = 0; // Frames left to time, 0 when no bench is running
+uint32_t benchStartMicros = 0;
+uint32_t lastBenchFrameMicros = 0;
+uint32_t worstBenchFrameMicros = 0;
+#endif
+
+#ifdef FRAME_STREAM
+FrameStream frameStream;
+#endif
+
+#ifdef INPUT_RECORDING
+const int INPUT_RECORDING_BYTES = 256; // Ring of the latest recordings, a quick run through a 16x16 maze takes ~150
+InputRecorder recorder(INPUT_RECORDING_BYTES, NUNCHUCK_CHECK_FREQUENCY);
+#endif
+
+#ifdef TIME_TRIAL
+const int TIME_TRIAL_SLOTS = 4; // Mazes whose best time is kept
+const int TIME_TRIAL_SLOT_BYTES = 96; // Holds the path of a run through a 16x16 maze, the start of it in larger mazes
+const int EEPROM_TIME_TRIAL_ADDRESS = EEPROM_SETTINGS_ADDRESS - TIME_TRIAL_SLOTS * TIME_TRIAL_SLOT_BYTES; // Clear of the fog of war of a 32x32 maze
+const int TIME_TRIAL_BYTES_PER_FRAME = 2; // Maximum EEPROM bytes written per frame while saving a best run
+const int GHOST_BLINK_FREQUENCY = 400; // In milliseconds
+const int GHOST_ON_TIME = 50; // The ghost is lit for a short part of each blink, so it looks dimmer than the player
+TimeTrial timeTrial(EEPROM_TIME_TRIAL_ADDRESS, TIME_TRIAL_SLOTS, TIME_TRIAL_SLOT_BYTES);
+#endif
+
+#ifdef TILT_CONTROL
+const uint8_t TILT_FILTER_SHIFT = 1; // Each poll moves the filtered tilt halfway to the sample
+const uint16_t TILT_ENGAGE = 52; // About 15 degrees, the accelerometer reads about 200 per g
+const uint16_t TILT_RELEASE = 35; // About 10 degrees
+const uint16_t TILT_FULL = 130; // About 40 degrees, moves at full speed from there
+TiltInput tiltInput(TILT_FILTER_SHIFT, TILT_ENGAGE, TILT_RELEASE, TILT_FULL);
+#endif
+
+GameJournal journal(EEPROM_JOURNAL_ADDRESS, JOURNAL_HALF_SIZE);
+
+InputShaper inputShaper(JOYSTICK_DEADZONE, MIN_MOVE_DELAY, MAX_MOVE_DELAY, JOYSTICK_CURVE);
+
+const Settings DEFAULT_SETTINGS = {DEFAULT_BRIGHTNESS, JOYSTICK_CURVE, JOYSTICK_DEADZONE, BRAID_PERCENT};
+SettingsStore settingsStore(EEPROM_SETTINGS_ADDRESS, SETTINGS_SLOTS, DEFAULT_SETTINGS);
+
+// Log message IDs, in the order of their texts in LOG_MESSAGES
+enum LogMessage : uint8_t {
+  LOG_NUNCHUCK_LOST,
+  LOG_NUNCHUCK_RECONNECTED,
+  LOG_NUNCHUCK_CONNECTED,
+  LOG_BOOT_TIMES,
+  LOG_MINIMAP_SHOWN,
+  LOG_MINIMAP_HIDDEN,
+  LOG_BRIGHTNESS_ADJUSTED,
+  LOG_REGENERATING,
+  LOG_MOVED_RIGHT,
+  LOG_MOVED_LEFT,
+  LOG_MOVED_UP,
+  LOG_MOVED_DOWN,
+  LOG_COLLISION,
+  LOG_AUTO_RUN,
+  LOG_AUTO_RUN_STOPPED,
+  LOG_END_REACHED,
+  LOG_COMPLETED,
+  LOG_MAZE_SAVED,
+  LOG_TILE_CACHE,
+  LOG_CAUGHT,
+  LOG_TIME_TO_BEAT,
+  LOG_BEST_TIME,
+  LOG_MAZE_READY,
+  LOG_ENEMY_UPDATES,
+  LOG_ENEMY_REBUILDS,
+  LOG_BRAIDED,
+  LOG_BRAID_TIME,
+  LOG_REGENERATED,
+  LOG_SETTINGS,
+  LOG_BRAIDING
+};
+const char LOG_MESSAGES[] PROGMEM =
+  "Failed to poll nunchuck, reconnecting...\0"
+  "Reconnected to nunchuck!\0"
+  "Connected to nunchuck!\0"
+  "Boot ms to arrow, maze, input:\0"
+  "Minimap shown\0"
+  "Minimap hidden\0"
+  "Brightness adjusted to:\0"
+  "C button pressed, regenerating maze...\0"
+  "Joystick moved right\0"
+  "Joystick moved left\0"
+  "Joystick moved up\0"
+  "Joystick moved down\0"
+  "Collision detected at\0"
+  "Auto-run steps, to row, column:\0"
+  "Auto-run stopped\0"
+  "Congratulations! You reached the end!\0"
+  "Completed in moves, seconds:\0"
+  "New maze saved to EEPROM.\0"
+  "Tile cache hits, misses, fetch us:\0"
+  "Caught by the enemy, back to the start!\0"
+  "Time to beat in seconds, milliseconds:\0"
+  "New best time in seconds, milliseconds:\0"
+  "New maze ready in ms, us:\0"
+  "Enemy updates, avg us, RAM:\0"
+  "Enemy rebuilds, avg, max us:\0"
+  "Dead ends braided, of, loops:\0"
+  "Braided in us:\0"
+  "Regen frames, worst ms, us:\0"
+  "Brightness, curve, deadzone:\0"
+  "Braiding percent:";
+const uint8_t LOG_CAPACITY = 16; // Messages queued while the serial port is busy, more are dropped and counted
+Logger logger(LOG_CAPACITY, LOG_MESSAGES);
 
 uint8_t** subMaze8x8;  // Declare globally
 
+Minimap minimap;
+bool showMinimap = false; // Toggled by pressing C and Z together
+
+#ifdef FOG_OF_WAR
+FogOfWar fogOfWar(maze.getRows(), maze.getColumns(), EEPROM_FOG_ADDRESS);
+#endif
+
+#ifdef MEMORY_STATS
+MemoryStats memoryStats;
+#endif
+
+#ifdef CHASING_ENEMY
+DistanceField enemyField(maze.getRows(), maze.getColumns());
+MazePosition enemyPosition;
+uint32_t enemyStartTime = 0; // When the enemy may start moving
+#endif
+
+#ifdef AUTO_RUN
+JunctionGraph junctionGraph;
+uint8_t autoRunDirection = 0; // Direction the player keeps walking in, 0 when not running
+#endif
+
 void setup() {
+  #ifdef MEMORY_STATS
+    memoryStats.begin();
+  #endif
   Serial.begin(115200);
   Serial.println("Starting Maze Game");
 
   matrix.begin(0x70);  // Initialize with the I2C address of the matrix
-  nunchuck.begin(); // Initialize the nunchuck
 
-  while (!nunchuck.connect()) {
-    Serial.println("Nunchuk not detected!");
-    delay(1000);
+  // Read the settings from EEPROM, or migrate the brightness saved before there were settings
+  if (settingsStore.load()) {
+    Serial.println("Settings loaded from EEPROM");
+  } else {
+    Settings settings = DEFAULT_SETTINGS;
+    uint8_t legacyBrightness = EEPROM.read(EEPROM_LEGACY_BRIGHTNESS_ADDRESS);
+    if (legacyBrightness <= 15) {
+      settings.brightness = legacyBrightness;
+    }
+    settingsStore.set(settings, millis());
+    Serial.println("No saved settings, using defaults");
   }
+  applySettings();
 
-  // Read brightness from EEPROM
-  uint8_t storedBrightness = EEPROM.read(EEPROM_BRIGHTNESS_ADDRESS);
-  if (storedBrightness > 0) {
-    storedBrightness = storedBrightness % 16; // Ensure brightness is between 0 and 15
-  }
-  matrix.setBrightness(storedBrightness);
-  currentBrightness = storedBrightness;
-  Serial.print("Brightness set to: ");
-  Serial.println(currentBrightness);
+  // Print up arrow initially so player knows which way is up, it stays while the game starts, see loop
+  printUpArrowToLEDMatrix();
+  firstFrameTime = millis();
+
+  // The nunchuk is connected by the polls of loop, as after it is unplugged, so a missing or slow
+  // nunchuk never holds up the game
+  nunchuck.begin();
+  lastNunchuckCheckTime = millis() - NUNCHUCK_CHECK_FREQUENCY; // The first poll is in the first frame
 
   Serial.println("Maze:");
-  if (maze.loadFromEEPROM()) {
+  bool isMazeLoaded = maze.loadFromEEPROM();
+  mazeKey = maze.calculateKey();
+
+  // Always recover the journal, even for a new maze it tells where to continue writing
+  GameState savedState;
+  bool hasSavedState = journal.recover(savedState, mazeKey);
+  if (isMazeLoaded) {
     Serial.println("Maze loaded from EEPROM:");
+    // Resume the run in progress if it was journaled in this maze and its position is still valid
+    if (hasSavedState && !maze.isCollision(savedState.playerPosition.row, savedState.playerPosition.column)) {
+      playerPosition = savedState.playerPosition;
+      moveCount = savedState.moves;
+      elapsedTime = savedState.elapsedSeconds * 1000UL;
+      Serial.println("Resumed run from EEPROM");
+    } else {
+      journal.reset(getGameState());
+    }
+    #ifdef FOG_OF_WAR
+      if (!fogOfWar.loadFromEEPROM(maze)) {
+        fogOfWar.reset(maze);
+      }
+      fogOfWar.reveal(maze, playerPosition, FOG_VIEW_DISTANCE);
+    #endif
+    // The maze is printed over the first frames. It is neither recorded nor timed, its seed is not saved
+    maze.beginPrintToSerial(playerPosition);
+    #ifdef CHASING_ENEMY
+      resetEnemy(millis());
+    #endif
   } else {
+    // A new maze is started like any other, it is saved to EEPROM over the first frames
     Serial.println("Failed to load maze from EEPROM, generating new maze:");
-    maze.generateMaze();
-    maze.saveToEEPROM();
+    beginLevelTransition();
+    #ifdef USE_MAZE_PACK
+      maze.loadFromPack(MAZE_PACK[packLevel], pgm_read_dword(&MAZE_PACK_SEEDS[packLevel]));
+    #else
+      #ifdef BRAIDED_MAZES
+        maze.setBraiding(settingsStore.get().braidPercent);
+      #endif
+      maze.generateMaze();
+    #endif
+    finishNewMaze();
   }
-  maze.printToSerialWithPlayer(playerPosition);
+
+  #ifdef FOG_OF_WAR
+    Serial.print("Fog of war uses ");
+    Serial.print(fogOfWar.getRAMBytes());
+    Serial.print(" bytes of RAM and ");
+    Serial.print(fogOfWar.getEEPROMBytes());
+    Serial.print(" bytes of EEPROM, at most ");
+    Serial.print(fogOfWar.getEEPROMBytes());
+    Serial.print(" bytes written every ");
+    Serial.print(FOG_COMMIT_INTERVAL / 1000);
+    Serial.println(" s");
+  #endif
+
+  #ifdef TILT_CONTROL
+    // Calibrated from the first polls, while the up arrow is shown and the nunchuk is held level
+    tiltInput.startCalibration();
+    printTiltLatencyToSerial();
+  #endif
+
+  #ifdef BENCHMARK_MAZE_ANALYSIS
+    benchmarkMazeAnalysis();
+  #endif
+  #ifdef BENCHMARK_INPUT_SHAPING
+    benchmarkInputShaping();
+  #endif
+
+  // Generate the next maze in the background while this one is played, pack mazes need no generation
+  #ifndef USE_MAZE_PACK
+    #ifdef BRAIDED_MAZES
+      maze.setBraiding(settingsStore.get().braidPercent);
+    #endif
+    if (maze.enableBackBuffer()) {
+      Serial.print("Maze back buffer uses ");
+      Serial.print(maze.getBackBufferBytes());
+      Serial.println(" bytes of RAM");
+      maze.beginGeneration(true);
+    }
+  #endif
   
   // Allocate once
   subMaze8x8 = new uint8_t*[LED_MATRIX_SIZE];
@@ -74,9 +508,9 @@ void setup() {
     subMaze8x8[i] = new uint8_t[LED_MATRIX_SIZE];
   }
 
-  // Print up arrow initially so player knows which way is up
-  printUpArrowToLEDMatrix();
-  delay(2000);
+  #ifdef MEMORY_STATS
+    memoryStats.printToSerial(maze, maze.getBackBufferBytes() > 0);
+  #endif
 }
 
 void loop() {
@@ -84,10 +518,26 @@ void loop() {
   static uint64_t lastEndBlinkTime = 0;
   static bool playerBlinkState = false;
   static bool endBlinkState = false;
-  static uint64_t lastNunchuckCheckTime = 0;
-  static uint64_t lastPlayerMoveTime = 0;
+  static uint32_t lastFrameTime = millis();
+  static bool isBootReported = false;
 
+  #ifdef MEMORY_STATS
+    memoryStats.update();
+  #endif
+  uint32_t frameStartMicros = micros();
   uint32_t currentTime = millis();
+
+  // Send queued log messages as far as the serial port takes them without waiting
+  logger.service();
+
+  #ifdef SERIAL_CONSOLE
+    if (console.poll(CONSOLE_BYTES_PER_FRAME)) {
+      handleConsoleCommand();
+    }
+    updateFrameBench(frameStartMicros);
+  #endif
+  elapsedTime += currentTime - lastFrameTime;
+  lastFrameTime = currentTime;
   if (currentTime - lastPlayerBlinkTime >= PLAYER_BLINK_FREQUENCY) {
     playerBlinkState = !playerBlinkState;
     lastPlayerBlinkTime = currentTime;
@@ -97,85 +547,160 @@ void loop() {
     lastEndBlinkTime = currentTime;
   }
 
+  // Generate the new maze a few steps per frame, showing the progress until it is complete
+  if (maze.isGenerating()) {
+    if (!maze.stepGeneration(GENERATION_STEPS_PER_FRAME, GENERATION_BYTES_PER_FRAME)) {
+      printGenerationProgressToLEDMatrix(maze.getGenerationProgress());
+      trackRegenerationFrame(frameStartMicros);
+      return;
+    }
+    finishNewMaze();
+  }
+
+  // Print the maze to serial a row per frame, as the serial port takes it
+  maze.stepPrintToSerial();
+
+  #ifdef AUTO_RUN
+    // Compress each new maze once it is complete
+    if (junctionGraph.update(maze)) {
+      printJunctionGraphToSerial();
+    }
+  #endif
+
   if (currentTime - lastNunchuckCheckTime >= NUNCHUCK_CHECK_FREQUENCY) {
     lastNunchuckCheckTime = currentTime;
 
-    if (!nunchuck.update()) {
-      Serial.println("Failed to poll nunchuck, attempting reconnection...");
-      if (nunchuck.connect()) {
-          Serial.println("Reconnected to nunchuck!");
-      } else {
-          delay(500);  // Don't spam reconnection attempts
+    // Connecting takes a few short I2C transfers, so it is tried at every poll until it works
+    bool wasConnected = isNunchuckConnected;
+    if (!isNunchuckConnected && nunchuck.connect()) {
+      isNunchuckConnected = true;
+      LOG_INFO(firstInputTime > 0 ? LOG_NUNCHUCK_RECONNECTED : LOG_NUNCHUCK_CONNECTED);
+    }
+    if (!isNunchuckConnected || !nunchuck.update()) {
+      #ifdef INPUT_RECORDING
+        recorder.recordLost(currentTime);
+      #endif
+      if (wasConnected) {
+        LOG_WARN(LOG_NUNCHUCK_LOST);
       }
+      isNunchuckConnected = false;
       return;
     }
-
-    // Adjust brightness with Z button
-    if (nunchuck.buttonZ()) {
-      currentBrightness = (currentBrightness + 1) % 16; // Cycle brightness between 0 and 15
-      matrix.setBrightness(currentBrightness);
-      EEPROM.write(EEPROM_BRIGHTNESS_ADDRESS, currentBrightness);
-      Serial.print("Brightness adjusted to: ");
-      Serial.println(currentBrightness);
-      delay(200); // Debounce delay
+    if (firstInputTime == 0) {
+      firstInputTime = max(currentTime, (uint32_t)1);
     }
+    #ifdef TILT_CONTROL
+      tiltInput.update(nunchuck.accelX(), nunchuck.accelY());
+    #endif
+    #ifdef INPUT_RECORDING
+      // With TILT_CONTROL the joystick reading of the tilt is recorded, which replays without it
+      NunchukSample sample = {128, 128, nunchuck.buttonC(), nunchuck.buttonZ()};
+      readJoystick(sample.joyX, sample.joyY);
+      recorder.recordSample(currentTime, sample);
+    #endif
 
-    // Regenerate maze with C button
-    if (nunchuck.buttonC()) {
-      Serial.println("C button pressed, regenerating maze...");
-      maze.generateMaze();
-      maze.saveToEEPROM();
-      playerPosition = maze.getStartPosition();
-      Serial.println("New maze generated and saved to EEPROM.");
-      maze.printToSerialWithPlayer(playerPosition);
-      delay(200); // Debounce delay
+    bool isCPressed = nunchuck.buttonC();
+    bool isZPressed = nunchuck.buttonZ();
+
+    // Toggle the whole maze minimap with C and Z together, once per press
+    if (isCPressed && isZPressed) {
+      if (!isChordHeld) {
+        isChordHeld = true;
+        showMinimap = !showMinimap;
+        LOG_INFO(showMinimap ? LOG_MINIMAP_SHOWN : LOG_MINIMAP_HIDDEN);
+      }
+    }
+    // Adjust brightness with Z button, one level per press. It is saved once the presses stop
+    else if (isZPressed && !isChordHeld) {
+      if (!wasZPressed) {
+        Settings settings = settingsStore.get();
+        settings.brightness = (settings.brightness + 1) % 16; // Cycle brightness between 0 and 15
+        settingsStore.set(settings, currentTime);
+        matrix.setBrightness(settings.brightness);
+        LOG_INFO(LOG_BRIGHTNESS_ADJUSTED, settings.brightness);
+      }
     }
+    // Regenerate maze when C is released, unless it was pressed together with Z
+    else if (wasCPressed && !isCPressed && !isChordHeld && !isRegenerating) {
+      LOG_INFO(LOG_REGENERATING);
+      startNewMaze();
+    }
+    if (!isCPressed && !isZPressed) {
+      isChordHeld = false;
+    }
+    wasCPressed = isCPressed;
+    wasZPressed = isZPressed;
   }
 
   // Move maze based on joystick input
   int newMazeX = playerPosition.column;
   int newMazeY = playerPosition.row;
 
-  // Get joystick input and center values
-  int joyX = nunchuck.joyX();
-  int joyY = nunchuck.joyY();
-  int joyXCentered = joyX - 128;  // Center at 0
-  int joyYCentered = joyY - 128;  // Center at 0
-  int moveSpeedX = 1;
-  int moveSpeedY = 1;
-
-  // Calculate joystick direction and magnitude
-  int joyMagnitude = sqrt(joyXCentered*joyXCentered + joyYCentered*joyYCentered);
- 
-
-  // Adaptive movement delay - faster response for stronger joystick tilt
-  unsigned long playerMovementDelay = map(constrain(joyMagnitude, JOYSTICK_DEADZONE, 127),
-                              JOYSTICK_DEADZONE, 127, 
-                              MAX_MOVE_DELAY, MIN_MOVE_DELAY);
-
+  // Direction and adaptive movement delay, faster response for stronger joystick tilt
+  uint8_t joyX;
+  uint8_t joyY;
+  readJoystick(joyX, joyY);
+  ShapedInput input = inputShaper.shape(joyX, joyY);
 
-  if (joyMagnitude > JOYSTICK_DEADZONE && currentTime - lastPlayerMoveTime >= playerMovementDelay) {
+  if ((input.rowStep != 0 || input.columnStep != 0) && currentTime - lastPlayerMoveTime >= input.moveDelay) {
     lastPlayerMoveTime = currentTime;
-    if (joyX > 128 + JOYSTICK_DEADZONE) {
-      newMazeX = min(newMazeX + moveSpeedX, maze.getColumns() - 1);
-      Serial.println("Joystick moved right");
-    } else if (joyX < 128 - JOYSTICK_DEADZONE) {
-      newMazeX = max(newMazeX - moveSpeedX, 0);
-      Serial.println("Joystick moved left");
+    if (input.columnStep > 0) {
+      newMazeX = min(newMazeX + 1, maze.getColumns() - 1);
+      LOG_DEBUG(LOG_MOVED_RIGHT);
+    } else if (input.columnStep < 0) {
+      newMazeX = max(newMazeX - 1, 0);
+      LOG_DEBUG(LOG_MOVED_LEFT);
     }
-    // Need to invert Y axis to account for different coordinate systems
-    if (joyY > 128 + JOYSTICK_DEADZONE) {
-      newMazeY = max(newMazeY - moveSpeedY, 0);
-      Serial.println("Joystick moved up");
-    } else if (joyY < 128 - JOYSTICK_DEADZONE) {
-      newMazeY = min(newMazeY + moveSpeedY, maze.getRows() - 1);
-      Serial.println("Joystick moved down");
+    if (input.rowStep < 0) {
+      newMazeY = max(newMazeY - 1, 0);
+      LOG_DEBUG(LOG_MOVED_UP);
+    } else if (input.rowStep > 0) {
+      newMazeY = min(newMazeY + 1, maze.getRows() - 1);
+      LOG_DEBUG(LOG_MOVED_DOWN);
+    }
+
+    // Straight moves are a single lookup in the open directions of the player's position
+    uint8_t openDirections = maze.getOpenDirections(playerPosition.row, playerPosition.column);
+    uint8_t horizontalDirection = input.columnStep > 0 ? MAZE_RIGHT : MAZE_LEFT;
+    uint8_t verticalDirection = input.rowStep < 0 ? MAZE_UP : MAZE_DOWN;
+    bool isOpen;
+    if (newMazeX != playerPosition.column && newMazeY != playerPosition.row) {
+      isOpen = !maze.isCollision(newMazeY, newMazeX);
+      // A blocked diagonal move slides along the wall if one of its two axes is open
+      if (!isOpen && (openDirections & horizontalDirection)) {
+        newMazeY = playerPosition.row;
+        isOpen = true;
+      } else if (!isOpen && (openDirections & verticalDirection)) {
+        newMazeX = playerPosition.column;
+        isOpen = true;
+      }
+    } else {
+      isOpen = openDirections & (newMazeX != playerPosition.column ? horizontalDirection : verticalDirection);
     }
 
     if (newMazeX != playerPosition.column || newMazeY != playerPosition.row) {
-      if (!maze.isCollision(newMazeY, newMazeX)) {
+      #ifdef AUTO_RUN
+        // Only straight moves start a run, diagonal moves and collisions stop it
+        uint8_t moveDirection = 0;
+        if (isOpen && newMazeY == playerPosition.row) {
+          moveDirection = horizontalDirection;
+        } else if (isOpen && newMazeX == playerPosition.column) {
+          moveDirection = verticalDirection;
+        }
+        startAutoRun(moveDirection);
+      #endif
+      if (isOpen) {
         playerPosition.column = newMazeX;
         playerPosition.row = newMazeY;
+        moveCount++;
+        #ifdef AUTO_RUN
+          if (moveDirection != 0) {
+            autoRunDirection = junctionGraph.getRunDirection(maze, playerPosition, moveDirection);
+          }
+        #endif
+        #ifdef FOG_OF_WAR
+          fogOfWar.reveal(maze, playerPosition, FOG_VIEW_DISTANCE);
+        #endif
         #ifdef DEBUG_PLAYER_POSITION
           Serial.print("Moved to new position: ");
           Serial.print("X = ");
@@ -185,25 +710,341 @@ void loop() {
           maze.printToSerialWithPlayer(playerPosition);
         #endif
       } else {
-        Serial.println("Collision detected, position not updated");
+        LOG_DEBUG(LOG_COLLISION, newMazeY, newMazeX);
       }
     }
   }
 
+  #ifdef AUTO_RUN
+    // Keep running at full speed while the joystick is released
+    if (autoRunDirection != 0 && input.rowStep == 0 && input.columnStep == 0 &&
+        currentTime - lastPlayerMoveTime >= MIN_MOVE_DELAY) {
+      lastPlayerMoveTime = currentTime;
+      playerPosition = Maze::step(playerPosition, autoRunDirection);
+      moveCount++;
+      autoRunDirection = junctionGraph.getRunDirection(maze, playerPosition, autoRunDirection);
+      #ifdef FOG_OF_WAR
+        fogOfWar.reveal(maze, playerPosition, FOG_VIEW_DISTANCE);
+      #endif
+      if (autoRunDirection == 0) {
+        LOG_INFO(LOG_AUTO_RUN_STOPPED);
+      }
+    }
+  #endif
+
+  #ifdef CHASING_ENEMY
+    updateEnemy(currentTime);
+  #endif
+
+  #ifdef INPUT_RECORDING
+    recorder.recordPosition(currentTime, playerPosition);
+    if (lastPlayerMoveTime == currentTime) {
+      recorder.recordTick(currentTime); // A blocked move restarts the move delay all the same
+    }
+  #endif
+  #ifdef TIME_TRIAL
+    timeTrial.recordPosition(maze, playerPosition, elapsedTime);
+  #endif
+
   MazePosition endPosition = maze.getEndPosition();
-  if (playerPosition.row == endPosition.row && playerPosition.column == endPosition.column) {
-    Serial.println("Congratulations! You have reached the end of the maze!");
+  if (playerPosition.row == endPosition.row && playerPosition.column == endPosition.column && !isRegenerating) {
+    LOG_INFO(LOG_END_REACHED);
+    LOG_INFO(LOG_COMPLETED, min(moveCount, (uint16_t)INT16_MAX), min(elapsedTime / 1000, (uint32_t)INT16_MAX));
+    #ifdef INPUT_RECORDING
+      recorder.dump();
+    #endif
+    #ifdef FRAME_STREAM
+      frameStream.sendGoalReached(moveCount, elapsedTime / 1000);
+    #endif
+    #ifdef TIME_TRIAL
+      if (timeTrial.finishRun(elapsedTime)) {
+        LOG_INFO(LOG_BEST_TIME, elapsedTime / 1000, elapsedTime % 1000);
+      }
+    #endif
     delay(500); // Delay to prevent accidental restart
     playEndAnimation();
-    maze.generateMaze();
-    maze.saveToEEPROM();
-    playerPosition = maze.getStartPosition();
-    Serial.println("New maze generated and saved to EEPROM.");
-    maze.printToSerialWithPlayer(playerPosition);
+    #ifdef TIME_TRIAL
+      // Race the ghost of the best run in the same maze, C moves on to a new one
+      startRun();
+    #else
+      startNewMaze();
+    #endif
+  }
+
+  // Save the new maze a few bytes at a time while it is already being played
+  if (isSavingMaze && maze.stepSaveToEEPROM(MAZE_SAVE_BYTES_PER_FRAME)) {
+    isSavingMaze = false;
+    LOG_INFO(LOG_MAZE_SAVED);
+  }
+
+  // Use the time left after saving to generate the next maze
+  if (maze.isGeneratingBackBuffer() && !isSavingMaze) {
+    maze.stepGeneration(BACKGROUND_GENERATION_STEPS_PER_FRAME);
+  }
+
+  // Journal the run a few bytes at a time so it can be resumed after a power cycle
+  journal.record(getGameState(), currentTime, JOURNAL_RECORD_INTERVAL);
+  journal.service(JOURNAL_BYTES_PER_FRAME);
+
+  // Save changed settings once they have stopped changing
+  settingsStore.persist(currentTime, SETTINGS_QUIET_PERIOD, SETTINGS_BYTES_PER_FRAME);
+
+  #ifdef TIME_TRIAL
+    // Save a new best run a few bytes at a time
+    timeTrial.step(TIME_TRIAL_BYTES_PER_FRAME);
+  #endif
+
+  #ifdef FRAME_STREAM
+    frameStream.service(maze, playerPosition);
+  #endif
+
+  #ifdef FOG_OF_WAR
+    fogOfWar.persist(currentTime, FOG_COMMIT_INTERVAL, FOG_BYTES_PER_FRAME);
+  #endif
+
+  // Keep the minimap up to date in the background so showing it never stalls a frame
+  minimap.update(maze, MINIMAP_ROWS_PER_FRAME);
+
+  // The up arrow shown at power on makes way for the maze once it has been seen, or at the first move
+  if (isUpArrowShown && (currentTime - firstFrameTime >= UP_ARROW_TIME || input.rowStep != 0 || input.columnStep != 0)) {
+    isUpArrowShown = false;
+    firstMazeFrameTime = currentTime;
+  }
+  if (!isBootReported && firstInputTime > 0 && !isUpArrowShown) {
+    isBootReported = true;
+    LOG_INFO(LOG_BOOT_TIMES, firstFrameTime, firstMazeFrameTime, min(firstInputTime, (uint32_t)INT16_MAX));
   }
 
-  maze.getSubMaze(playerPosition.row - PLAYER_MATRIX_POSITION_Y, playerPosition.column - PLAYER_MATRIX_POSITION_X, LED_MATRIX_SIZE, LED_MATRIX_SIZE, subMaze8x8);
-  printSubMazeToLEDMatrix(subMaze8x8, LED_MATRIX_SIZE, LED_MATRIX_SIZE, playerBlinkState, endBlinkState);
+  if (isUpArrowShown) {
+    // Left on the matrix since setup
+  } else if (showMinimap && minimap.isReady()) {
+    printMinimapToLEDMatrix(playerBlinkState, endBlinkState);
+  } else {
+    maze.getSubMaze(playerPosition.row - PLAYER_MATRIX_POSITION_Y, playerPosition.column - PLAYER_MATRIX_POSITION_X, LED_MATRIX_SIZE, LED_MATRIX_SIZE, subMaze8x8);
+    bool ghostBlinkState = false;
+    #ifdef TIME_TRIAL
+      // The ghost walks the best run of this maze, it is hidden by the fog of war like the maze
+      MazePosition ghostPosition;
+      if (timeTrial.getGhostPosition(elapsedTime, ghostPosition)) {
+        int ghostRow = ghostPosition.row - playerPosition.row + PLAYER_MATRIX_POSITION_Y;
+        int ghostColumn = ghostPosition.column - playerPosition.column + PLAYER_MATRIX_POSITION_X;
+        if (ghostRow >= 0 && ghostRow < LED_MATRIX_SIZE && ghostColumn >= 0 && ghostColumn < LED_MATRIX_SIZE) {
+          subMaze8x8[ghostRow][ghostColumn] = GHOST;
+        }
+        ghostBlinkState = currentTime % GHOST_BLINK_FREQUENCY < GHOST_ON_TIME;
+      }
+    #endif
+    #ifdef FOG_OF_WAR
+      // Hide the cells the player has not seen yet
+      for (int i = 0; i < LED_MATRIX_SIZE; i++) {
+        for (int j = 0; j < LED_MATRIX_SIZE; j++) {
+          if (!fogOfWar.isSeen(playerPosition.row - PLAYER_MATRIX_POSITION_Y + i, playerPosition.column - PLAYER_MATRIX_POSITION_X + j)) {
+            subMaze8x8[i][j] = EMPTY;
+          }
+        }
+      }
+    #endif
+    #ifdef CHASING_ENEMY
+      // The enemy blinks on top of the view, quicker than the player
+      int enemyRow = enemyPosition.row - playerPosition.row + PLAYER_MATRIX_POSITION_Y;
+      int enemyColumn = enemyPosition.column - playerPosition.column + PLAYER_MATRIX_POSITION_X;
+      if (enemyRow >= 0 && enemyRow < LED_MATRIX_SIZE && enemyColumn >= 0 && enemyColumn < LED_MATRIX_SIZE) {
+        subMaze8x8[enemyRow][enemyColumn] = (currentTime / ENEMY_BLINK_FREQUENCY) % 2 ? WALL : EMPTY;
+      }
+    #endif
+    printSubMazeToLEDMatrix(subMaze8x8, LED_MATRIX_SIZE, LED_MATRIX_SIZE, playerBlinkState, endBlinkState, ghostBlinkState);
+  }
+
+  #ifdef PAGED_MAZE
+    // Report the tiles fetched to render the view after each move
+    static MazePosition lastReportedPosition = playerPosition;
+    if (playerPosition.row != lastReportedPosition.row || playerPosition.column != lastReportedPosition.column) {
+      lastReportedPosition = playerPosition;
+      TileCacheStats stats = tileCache.getStats();
+      LOG_INFO(LOG_TILE_CACHE, min(stats.hits, (uint32_t)INT16_MAX), min(stats.misses, (uint32_t)INT16_MAX),
+               min(stats.fetchMicros, (uint32_t)INT16_MAX));
+      tileCache.resetStats();
+    }
+  #endif
+
+  #ifdef INPUT_RECORDING
+    bool wasRegenerating = isRegenerating;
+  #endif
+  trackRegenerationFrame(frameStartMicros);
+  #ifdef INPUT_RECORDING
+    if (wasRegenerating && !isRegenerating) {
+      recorder.recordSettled(currentTime);
+    }
+  #endif
+}
+
+/**
+ * @brief Switches to the maze pre-generated in the back buffer, or starts generating a new
+ *        maze over the following frames if it is not ready yet, see finishNewMaze.
+ */
+void startNewMaze() {
+  beginLevelTransition();
+  #ifdef USE_MAZE_PACK
+    // Decoding the next maze of the pack takes a single pass, so it is ready within this frame
+    packLevel = (packLevel + 1) % MAZE_PACK_COUNT;
+    maze.loadFromPack(MAZE_PACK[packLevel], pgm_read_dword(&MAZE_PACK_SEEDS[packLevel]));
+    finishNewMaze();
+    return;
+  #endif
+  if (maze.swapBuffers()) {
+    finishNewMaze();
+  } else {
+    maze.beginGeneration();
+  }
+}
+
+/**
+ * @brief Starts timing the switch to a new maze, see trackRegenerationFrame.
+ */
+void beginLevelTransition() {
+  levelTransitionStartMicros = micros();
+  isRegenerating = true;
+  regenerationFrames = 0;
+  worstRegenerationFrameMicros = 0;
+}
+
+/**
+ * @brief Moves the player to the start of the newly generated maze and starts saving it to EEPROM.
+ */
+void finishNewMaze() {
+  maze.beginSaveToEEPROM();
+  isSavingMaze = true;
+  #ifdef CHASING_ENEMY
+    logEnemyStats();
+  #endif
+  #if defined(BRAIDED_MAZES) && !defined(USE_MAZE_PACK)
+    logBraidStats();
+  #endif
+  uint32_t transitionMicros = micros() - levelTransitionStartMicros;
+  LOG_INFO(LOG_MAZE_READY, min(transitionMicros / 1000, (uint32_t)INT16_MAX), transitionMicros % 1000);
+  maze.beginPrintToSerial(maze.getStartPosition());
+  #ifdef MEMORY_STATS
+    memoryStats.printToSerial(maze, maze.getBackBufferBytes() > 0);
+  #endif
+
+  // The maze starts once it is ready
+  startRun();
+
+  // Start on the maze after this one
+  if (maze.getBackBufferBytes() > 0) {
+    maze.beginGeneration(true);
+  }
+}
+
+/**
+ * @brief Puts the player back at the start of the maze for a new run of it.
+ */
+void startRun() {
+  playerPosition = maze.getStartPosition();
+  moveCount = 0;
+  elapsedTime = 0;
+  mazeKey = maze.calculateKey();
+  journal.reset(getGameState());
+  #ifdef FOG_OF_WAR
+    fogOfWar.reset(maze);
+    fogOfWar.reveal(maze, playerPosition, FOG_VIEW_DISTANCE);
+  #endif
+  #ifdef AUTO_RUN
+    autoRunDirection = 0;
+  #endif
+  #if defined(CHASING_ENEMY) || defined(INPUT_RECORDING)
+    // A recording of the run and the enemy start at the same time
+    uint32_t startTime = millis();
+  #endif
+  #ifdef CHASING_ENEMY
+    resetEnemy(startTime);
+  #endif
+  #ifdef INPUT_RECORDING
+    startRecording(startTime);
+  #endif
+  #ifdef TIME_TRIAL
+    startTimeTrial();
+  #endif
+}
+
+/**
+ * @brief Applies the current settings to the matrix and the joystick and logs them.
+ */
+void applySettings() {
+  const Settings& settings = settingsStore.get();
+  matrix.setBrightness(settings.brightness);
+  inputShaper.setCurve((ResponseCurve)settings.responseCurve);
+  inputShaper.setDeadzone(settings.joystickDeadzone);
+  #ifdef TILT_CONTROL
+    tiltInput.setDeadzone(settings.joystickDeadzone);
+  #endif
+  LOG_INFO(LOG_SETTINGS, settings.brightness, settings.responseCurve, settings.joystickDeadzone);
+  LOG_INFO(LOG_BRAIDING, settings.braidPercent);
+}
+
+/**
+ * @brief Reads the joystick, or with TILT_CONTROL the tilt of the nunchuk as a joystick reading.
+ * @param joyX Set to the horizontal reading, 128 at rest, larger values right.
+ * @param joyY Set to the vertical reading, 128 at rest, larger values up.
+ */
+void readJoystick(uint8_t& joyX, uint8_t& joyY) {
+  if (!isNunchuckConnected) {
+    joyX = 128;
+    joyY = 128;
+    return;
+  }
+  #ifdef TILT_CONTROL
+    joyX = tiltInput.joyX();
+    joyY = tiltInput.joyY();
+  #else
+    joyX = nunchuck.joyX();
+    joyY = nunchuck.joyY();
+  #endif
+}
+
+/**
+ * @brief Records the duration of a frame spent generating or saving a new maze and
+ *        reports the worst one once the new maze is saved.
+ * 
+ * @param frameStartMicros The time the frame started in microseconds.
+ */
+void trackRegenerationFrame(uint32_t frameStartMicros) {
+  if (!isRegenerating) {
+    return;
+  }
+  uint32_t frameMicros = micros() - frameStartMicros;
+  regenerationFrames++;
+  if (frameMicros > worstRegenerationFrameMicros) {
+    worstRegenerationFrameMicros = frameMicros;
+  }
+  if (!maze.isGenerating() && !isSavingMaze) {
+    isRegenerating = false;
+    LOG_INFO(LOG_REGENERATED, min(regenerationFrames, (uint16_t)INT16_MAX),
+             min(worstRegenerationFrameMicros / 1000, (uint32_t)INT16_MAX), worstRegenerationFrameMicros % 1000);
+  }
+}
+
+/**
+ * @brief Prints the progress of the maze generation to the LED matrix, filling it row by row.
+ * 
+ * @param progress The progress of the generation in percent.
+ */
+void printGenerationProgressToLEDMatrix(uint8_t progress) {
+  matrix.clear();
+  int litPixels = progress * LED_MATRIX_SIZE * LED_MATRIX_SIZE / 100;
+  for (int i = 0; i < litPixels; i++) {
+    matrix.drawPixel(i % LED_MATRIX_SIZE, i / LED_MATRIX_SIZE, LED_ON);
+  }
+  matrix.writeDisplay();
+}
+
+/**
+ * @brief Gets the state of the run in progress.
+ * @return The player position, moves and elapsed time in the current maze.
+ */
+GameState getGameState() {
+  GameState state = {playerPosition, moveCount, (uint16_t)(elapsedTime / 1000), mazeKey};
+  return state;
 }
 
 /**
@@ -242,8 +1083,9 @@ void printUpArrowToLEDMatrix() {
  * @param height The height of the sub-maze.
  * @param playerBlinkState The state of the player blink effect.
  * @param endBlinkState The state of the end blink effect.
+ * @param ghostBlinkState The state of the ghost blink effect, see TIME_TRIAL.
  */
-void printSubMazeToLEDMatrix(uint8_t** subMaze, int width, int height, bool playerBlinkState, bool endBlinkState) {
+void printSubMazeToLEDMatrix(uint8_t** subMaze, int width, int height, bool playerBlinkState, bool endBlinkState, bool ghostBlinkState) {
   matrix.clear();
   for (int i = 0; i < height; i++) {
     for (int j = 0; j < width; j++) {
@@ -254,6 +1096,8 @@ void printSubMazeToLEDMatrix(uint8_t** subMaze, int width, int height, bool play
           matrix.drawPixel(j, i, LED_ON);
         } else if (subMaze[i][j] == END) {
           matrix.drawPixel(j, i, endBlinkState ? LED_ON : LED_OFF);
+        } else if (subMaze[i][j] == GHOST) {
+          matrix.drawPixel(j, i, ghostBlinkState ? LED_ON : LED_OFF);
         } else {
           matrix.drawPixel(j, i, LED_OFF);
         }
@@ -263,6 +1107,27 @@ void printSubMazeToLEDMatrix(uint8_t** subMaze, int width, int height, bool play
   matrix.writeDisplay();
 }
 
+/**
+ * @brief Prints the whole maze minimap to the LED matrix.
+ * 
+ * @param playerBlinkState The state of the player blink effect.
+ * @param endBlinkState The state of the end blink effect.
+ */
+void printMinimapToLEDMatrix(bool playerBlinkState, bool endBlinkState) {
+  matrix.clear();
+  for (int i = 0; i < Minimap::MINIMAP_SIZE; i++) {
+    uint8_t row = minimap.getRow(i);
+    for (int j = 0; j < Minimap::MINIMAP_SIZE; j++) {
+      matrix.drawPixel(j, i, (row >> j) & 1 ? LED_ON : LED_OFF);
+    }
+  }
+  MazePosition endPixel = Minimap::toMinimapPosition(maze, maze.getEndPosition());
+  matrix.drawPixel(endPixel.column, endPixel.row, endBlinkState ? LED_ON : LED_OFF);
+  MazePosition playerPixel = Minimap::toMinimapPosition(maze, playerPosition);
+  matrix.drawPixel(playerPixel.column, playerPixel.row, playerBlinkState ? LED_ON : LED_OFF);
+  matrix.writeDisplay();
+}
+
 /**
  * @brief Plays an animation when the player reaches the end of the maze.
  */
@@ -285,3 +1150,524 @@ void playEndAnimation() {
   matrix.clear();
   matrix.writeDisplay();
 }
+
+#ifdef BENCHMARK_MAZE_ANALYSIS
+/**
+ * @brief Counts dead ends and junctions with per-cell loops and with bitboard kernels
+ *        and prints the time each approach takes.
+ */
+void benchmarkMazeAnalysis() {
+  const int ITERATIONS = 10;
+
+  uint32_t scalarStart = micros();
+  int scalarDeadEnds = 0;
+  int scalarJunctions = 0;
+  for (int n = 0; n < ITERATIONS; n++) {
+    scalarDeadEnds = 0;
+    scalarJunctions = 0;
+    for (int i = 0; i < maze.getRows(); i++) {
+      for (int j = 0; j < maze.getColumns(); j++) {
+        if (maze.isCollision(i, j)) {
+          continue;
+        }
+        int openNeighbours = 0;
+        if (!maze.isCollision(i - 1, j)) openNeighbours++;
+        if (!maze.isCollision(i + 1, j)) openNeighbours++;
+        if (!maze.isCollision(i, j - 1)) openNeighbours++;
+        if (!maze.isCollision(i, j + 1)) openNeighbours++;
+        if (openNeighbours == 1) {
+          scalarDeadEnds++;
+        } else if (openNeighbours >= 3) {
+          scalarJunctions++;
+        }
+      }
+    }
+  }
+  uint32_t scalarMicros = (micros() - scalarStart) / ITERATIONS;
+
+  MazeBitboard bitboard(maze.getRows(), maze.getColumns());
+  uint32_t loadStart = micros();
+  bitboard.load(maze);
+  uint32_t loadMicros = micros() - loadStart;
+
+  uint32_t bitboardStart = micros();
+  int bitboardDeadEnds = 0;
+  int bitboardJunctions = 0;
+  for (int n = 0; n < ITERATIONS; n++) {
+    bitboardDeadEnds = bitboard.countDeadEnds();
+    bitboardJunctions = bitboard.countJunctions();
+  }
+  uint32_t bitboardMicros = (micros() - bitboardStart) / ITERATIONS;
+
+  Serial.print("Scalar: ");
+  Serial.print(scalarDeadEnds);
+  Serial.print(" dead ends, ");
+  Serial.print(scalarJunctions);
+  Serial.print(" junctions in ");
+  Serial.print(scalarMicros);
+  Serial.println(" us");
+  Serial.print("Bitboard: ");
+  Serial.print(bitboardDeadEnds);
+  Serial.print(" dead ends, ");
+  Serial.print(bitboardJunctions);
+  Serial.print(" junctions in ");
+  Serial.print(bitboardMicros);
+  Serial.print(" us (+");
+  Serial.print(loadMicros);
+  Serial.println(" us to load)");
+}
+#endif
+
+#ifdef BENCHMARK_INPUT_SHAPING
+/**
+ * @brief Processes a sweep of joystick readings with the previous floating point code and with
+ *        the input shaper and prints the time per frame each takes.
+ */
+void benchmarkInputShaping() {
+  const int STEP = 4; // 64x64 readings
+  volatile long sink = 0; // Keeps the compiler from dropping the work
+  long readings = 0;
+
+  uint32_t floatStart = micros();
+  for (int joyX = 0; joyX < 256; joyX += STEP) {
+    for (int joyY = 0; joyY < 256; joyY += STEP) {
+      int joyXCentered = joyX - 128;
+      int joyYCentered = joyY - 128;
+      int joyMagnitude = sqrt(joyXCentered*joyXCentered + joyYCentered*joyYCentered);
+      unsigned long playerMovementDelay = map(constrain(joyMagnitude, JOYSTICK_DEADZONE, 127),
+                                  JOYSTICK_DEADZONE, 127,
+                                  MAX_MOVE_DELAY, MIN_MOVE_DELAY);
+      int columnStep = joyX > 128 + JOYSTICK_DEADZONE ? 1 : (joyX < 128 - JOYSTICK_DEADZONE ? -1 : 0);
+      int rowStep = joyY > 128 + JOYSTICK_DEADZONE ? -1 : (joyY < 128 - JOYSTICK_DEADZONE ? 1 : 0);
+      sink = sink + playerMovementDelay + columnStep + rowStep + (joyMagnitude > JOYSTICK_DEADZONE);
+      readings++;
+    }
+  }
+  uint32_t floatMicros = micros() - floatStart;
+
+  uint32_t shaperStart = micros();
+  for (int joyX = 0; joyX < 256; joyX += STEP) {
+    for (int joyY = 0; joyY < 256; joyY += STEP) {
+      ShapedInput input = inputShaper.shape(joyX, joyY);
+      sink = sink + input.moveDelay + input.columnStep + input.rowStep;
+    }
+  }
+  uint32_t shaperMicros = micros() - shaperStart;
+
+  Serial.print("Joystick processing, floating point: ");
+  Serial.print((float)floatMicros / readings);
+  Serial.print(" us per frame, input shaper: ");
+  Serial.print((float)shaperMicros / readings);
+  Serial.println(" us per frame");
+}
+#endif
+
+#ifdef AUTO_RUN
+/**
+ * @brief Reports where a move out of the player's position leads when it starts a run from a junction.
+ * @note Called before the move, the run itself continues from the position reached, see loop.
+ *
+ * @param direction The direction of the move, 0 for a move that cannot start a run.
+ */
+void startAutoRun(uint8_t direction) {
+  autoRunDirection = 0;
+  uint8_t node = junctionGraph.isReady() ? junctionGraph.findNode(playerPosition) : JunctionGraph::NO_NODE;
+  if (direction == 0 || node == JunctionGraph::NO_NODE) {
+    return;
+  }
+  uint16_t length;
+  uint8_t target = junctionGraph.getNeighbour(node, direction, length);
+  if (target != JunctionGraph::NO_NODE) {
+    MazePosition targetPosition = junctionGraph.getNode(target);
+    LOG_INFO(LOG_AUTO_RUN, length, targetPosition.row, targetPosition.column);
+  }
+}
+
+/**
+ * @brief Prints the size of the junction graph against the open cells of the maze, and the time
+ *        the shortest path from the start to the end takes to find on it.
+ */
+void printJunctionGraphToSerial() {
+  Serial.print("Junction graph: ");
+  Serial.print(junctionGraph.getNodeCount());
+  Serial.print(" nodes, ");
+  Serial.print(junctionGraph.getEdgeCount());
+  Serial.print(" edges from ");
+  Serial.print(junctionGraph.getOpenCellCount());
+  Serial.print(" open cells, built in ");
+  Serial.print(junctionGraph.getBuildMicros());
+  Serial.print(" us, ");
+  Serial.print(junctionGraph.getRAMBytes());
+  Serial.println(" bytes of RAM");
+
+  uint32_t solveStart = micros();
+  long pathLength = junctionGraph.getPathLength(maze, maze.getStartPosition(), maze.getEndPosition());
+  uint32_t solveMicros = micros() - solveStart;
+  Serial.print("Shortest path to the end: ");
+  Serial.print(pathLength);
+  Serial.print(" steps, found in ");
+  Serial.print(solveMicros);
+  Serial.println(" us");
+}
+#endif
+
+#ifdef CHASING_ENEMY
+/**
+ * @brief Puts the enemy in the cell farthest from the start and gives the player a head start.
+ * @param currentTime The current time in milliseconds.
+ */
+void resetEnemy(uint32_t currentTime) {
+  enemyPosition = enemyField.getFarthestPosition(maze, maze.getStartPosition());
+  enemyStartTime = currentTime + ENEMY_START_DELAY;
+}
+
+/**
+ * @brief Keeps the enemy's path to the player up to date, moves the enemy one step along it
+ *        when it is due, and sends the player back to the start when they are caught.
+ *
+ * @param currentTime The current time in milliseconds.
+ */
+void updateEnemy(uint32_t currentTime) {
+  static uint32_t lastEnemyMoveTime = 0;
+
+  // Most player moves change a single step of the field, see DistanceField
+  enemyField.update(maze, playerPosition);
+
+  bool isCaught = enemyPosition.row == playerPosition.row && enemyPosition.column == playerPosition.column;
+  if (!isCaught && (int32_t)(currentTime - enemyStartTime) >= 0 && currentTime - lastEnemyMoveTime >= ENEMY_MOVE_DELAY) {
+    lastEnemyMoveTime = currentTime;
+    enemyPosition = Maze::step(enemyPosition, enemyField.getDirection(maze, enemyPosition));
+    #ifdef INPUT_RECORDING
+      recorder.recordTick(currentTime);
+    #endif
+    isCaught = enemyPosition.row == playerPosition.row && enemyPosition.column == playerPosition.column;
+  }
+  if (!isCaught) {
+    return;
+  }
+
+  LOG_INFO(LOG_CAUGHT);
+  playerPosition = maze.getStartPosition();
+  #ifdef AUTO_RUN
+    autoRunDirection = 0;
+  #endif
+  #ifdef FOG_OF_WAR
+    fogOfWar.reveal(maze, playerPosition, FOG_VIEW_DISTANCE);
+  #endif
+  resetEnemy(currentTime);
+}
+
+/**
+ * @brief Logs the time spent keeping the enemy's path up to date in the current maze.
+ */
+void logEnemyStats() {
+  DistanceFieldStats stats = enemyField.getStats();
+  LOG_INFO(LOG_ENEMY_UPDATES, min(stats.updates, (uint16_t)INT16_MAX),
+           min(stats.updates > 0 ? stats.updateMicros / stats.updates : 0, (uint32_t)INT16_MAX), enemyField.getRAMBytes());
+  LOG_INFO(LOG_ENEMY_REBUILDS, min(stats.rebuilds, (uint16_t)INT16_MAX),
+           min(stats.rebuilds > 0 ? stats.rebuildMicros / stats.rebuilds : 0, (uint32_t)INT16_MAX),
+           min(stats.maxMicros, (uint32_t)INT16_MAX));
+  enemyField.resetStats();
+}
+#endif
+
+#ifdef BRAIDED_MAZES
+/**
+ * @brief Logs the dead ends removed and loops added by braiding the last generated maze.
+ */
+void logBraidStats() {
+  BraidStats stats = maze.getBraidStats();
+  LOG_INFO(LOG_BRAIDED, stats.deadEndsBefore - stats.deadEndsAfter, stats.deadEndsBefore, stats.loops);
+  LOG_INFO(LOG_BRAID_TIME, min(stats.micros, (uint32_t)INT16_MAX));
+}
+#endif
+
+#ifdef SERIAL_CONSOLE
+/**
+ * @brief Runs the command the console has just read.
+ * @note Replies print directly, commands are typed by hand and rare enough to wait for the serial port.
+ */
+void handleConsoleCommand() {
+  long first;
+  long second;
+  switch (console.getCommand()) {
+    case CONSOLE_SEED:
+      #ifdef USE_MAZE_PACK
+        Serial.println("Pack mazes have fixed seeds");
+      #else
+        if (!console.getNumber(0, first)) {
+          Serial.println("Usage: seed <n>");
+        } else {
+          Serial.print("Generating the maze of seed ");
+          Serial.println((uint32_t)first);
+          startSeededMaze(first);
+        }
+      #endif
+      break;
+    case CONSOLE_REGEN:
+      if (!isRegenerating) {
+        startNewMaze();
+      }
+      break;
+    case CONSOLE_SIZE:
+      // The maze, its back buffer and its EEPROM layout are sized at compile time
+      Serial.print("The maze size is fixed at ");
+      Serial.print(maze.getRows());
+      Serial.print("x");
+      Serial.print(maze.getColumns());
+      Serial.println(", change it where maze is declared");
+      break;
+    case CONSOLE_DUMP:
+      if (maze.isGenerating()) {
+        Serial.println("The maze is being generated");
+      } else if (console.isArgument(0, "bin")) {
+        // A text header, then the maze in the packed format of maze packs
+        int packedSize = maze.getPackedSize();
+        uint8_t* packedMaze = new uint8_t[packedSize];
+        maze.pack(packedMaze);
+        Serial.print("Packed maze ");
+        Serial.print(maze.getRows());
+        Serial.print(" ");
+        Serial.print(maze.getColumns());
+        Serial.print(" ");
+        Serial.println(packedSize);
+        Serial.write(packedMaze, packedSize);
+        delete[] packedMaze;
+      } else {
+        maze.printToSerialWithPlayer(playerPosition);
+      }
+      break;
+    case CONSOLE_STATS:
+      Serial.print("Seed ");
+      Serial.print(maze.getSeed());
+      Serial.print(", size ");
+      Serial.print(maze.getRows());
+      Serial.print("x");
+      Serial.print(maze.getColumns());
+      Serial.print(", player at (");
+      Serial.print(playerPosition.row);
+      Serial.print(", ");
+      Serial.print(playerPosition.column);
+      Serial.print("), ");
+      Serial.print(moveCount);
+      Serial.print(" moves in ");
+      Serial.print(elapsedTime / 1000);
+      Serial.println(" s");
+      Serial.print("Slowest console poll ");
+      Serial.print(console.getMaxPollMicros());
+      Serial.print(" us, ");
+      Serial.print(logger.getDropped());
+      Serial.print(" log messages dropped, ");
+      Serial.print(settingsStore.getCommits());
+      Serial.println(" settings commits");
+      break;
+    case CONSOLE_GOTO:
+      if (!console.getNumber(0, first) || !console.getNumber(1, second)) {
+        Serial.println("Usage: goto <row> <column>");
+      } else if (maze.isGenerating() || maze.isCollision(first, second)) {
+        Serial.println("Not an open position");
+      } else {
+        playerPosition.row = first;
+        playerPosition.column = second;
+        #ifdef AUTO_RUN
+          autoRunDirection = 0;
+        #endif
+        #ifdef FOG_OF_WAR
+          fogOfWar.reveal(maze, playerPosition, FOG_VIEW_DISTANCE);
+        #endif
+      }
+      break;
+    case CONSOLE_BENCH:
+      if (!console.getNumber(0, first)) {
+        first = DEFAULT_BENCH_FRAMES;
+      }
+      benchFrames = constrain(first, 1L, 65535L);
+      benchFramesLeft = benchFrames;
+      benchStartMicros = 0;
+      worstBenchFrameMicros = 0;
+      break;
+    case CONSOLE_RECORD:
+      #ifdef INPUT_RECORDING
+        recorder.dump();
+      #else
+        Serial.println("Input recording is disabled, define INPUT_RECORDING");
+      #endif
+      break;
+    case CONSOLE_TILT:
+      #ifdef TILT_CONTROL
+        Serial.println("Calibrating the tilt, hold the nunchuk level");
+        tiltInput.startCalibration();
+      #else
+        Serial.println("Tilt control is disabled, define TILT_CONTROL");
+      #endif
+      break;
+    case CONSOLE_HELP:
+      SerialConsole::printHelp();
+      break;
+    default:
+      Serial.println("Unknown command, type help for the list");
+      break;
+  }
+}
+
+/**
+ * @brief Starts generating the maze of a seed in place of the current one.
+ * @note A maze being generated in the back buffer is dropped, the next one is started once
+ *       this maze is ready, see finishNewMaze.
+ *
+ * @param seed The seed of the maze.
+ */
+void startSeededMaze(uint32_t seed) {
+  beginLevelTransition();
+  maze.beginGeneration(false, seed);
+}
+
+/**
+ * @brief Times the frames of a running bench and reports them once it is done.
+ * @param frameStartMicros The time the frame started in microseconds.
+ */
+void updateFrameBench(uint32_t frameStartMicros) {
+  if (benchFramesLeft == 0) {
+    return;
+  }
+  if (benchStartMicros == 0) {
+    benchStartMicros = frameStartMicros;
+    lastBenchFrameMicros = frameStartMicros;
+    return;
+  }
+  uint32_t frameMicros = frameStartMicros - lastBenchFrameMicros;
+  lastBenchFrameMicros = frameStartMicros;
+  if (frameMicros > worstBenchFrameMicros) {
+    worstBenchFrameMicros = frameMicros;
+  }
+  if (--benchFramesLeft > 0) {
+    return;
+  }
+  Serial.print("Bench: ");
+  Serial.print(benchFrames);
+  Serial.print(" frames averaging ");
+  Serial.print((frameStartMicros - benchStartMicros) / benchFrames);
+  Serial.print(" us, worst ");
+  Serial.print(worstBenchFrameMicros);
+  Serial.println(" us");
+}
+#endif
+
+#ifdef INPUT_RECORDING
+/**
+ * @brief Starts recording the maze that has just started, see InputRecorder.
+ * @param currentTime The current time in milliseconds.
+ */
+void startRecording(uint32_t currentTime) {
+  RecordingStart start;
+  start.time = currentTime;
+  start.seed = maze.getSeed();
+  start.settings = settingsStore.get();
+  start.sinceMove = min(currentTime - lastPlayerMoveTime, (uint32_t)65535);
+  start.sincePoll = min(currentTime - lastNunchuckCheckTime, (uint32_t)65535);
+  start.sample = {128, 128, nunchuck.buttonC(), nunchuck.buttonZ()};
+  readJoystick(start.sample.joyX, start.sample.joyY);
+  start.isNunchukLost = !isNunchuckConnected;
+  start.isChordHeld = isChordHeld;
+  start.position = playerPosition;
+  start.isTransition = isRegenerating;
+  recorder.start(start);
+}
+
+/**
+ * @brief Puts the game in the state a recording starts from, so the recorded samples can be
+ *        replayed. Used by tools/mazereplay, which runs this sketch on a computer.
+ * @note The nunchuk keeps its reading, the replay sets it to the recorded one.
+ *
+ * @param start The start of the recording.
+ */
+void restoreRecording(const RecordingStart& start) {
+  settingsStore.set(start.settings, start.time);
+  applySettings();
+  lastPlayerMoveTime = start.time - start.sinceMove;
+  lastNunchuckCheckTime = start.time - start.sincePoll;
+  wasCPressed = start.sample.buttonC;
+  wasZPressed = start.sample.buttonZ;
+  isChordHeld = start.isChordHeld;
+  isNunchuckConnected = !start.isNunchukLost;
+  #if defined(BRAIDED_MAZES) && !defined(USE_MAZE_PACK)
+    maze.setBraiding(start.settings.braidPercent);
+  #endif
+  beginLevelTransition();
+  #ifdef USE_MAZE_PACK
+    // Pack mazes are not generated, the seed tells which one was played
+    packLevel = 0;
+    while (packLevel < MAZE_PACK_COUNT - 1 && pgm_read_dword(&MAZE_PACK_SEEDS[packLevel]) != start.seed) {
+      packLevel++;
+    }
+    maze.loadFromPack(MAZE_PACK[packLevel], start.seed);
+  #else
+    maze.generateMaze(start.seed);
+  #endif
+  finishNewMaze();
+  if (!start.isTransition) {
+    // The maze generated at power on is saved at once and can be finished right away
+    maze.saveToEEPROM();
+    isSavingMaze = false;
+    isRegenerating = false;
+  }
+}
+#endif
+
+#ifdef TIME_TRIAL
+/**
+ * @brief Starts timing a run of the current maze and tells the time to beat, if the maze was
+ *        completed before.
+ */
+void startTimeTrial() {
+  timeTrial.startRun(maze.getSeed(), maze.getStartPosition());
+  if (timeTrial.hasGhost()) {
+    uint32_t bestTime = timeTrial.getBestTime();
+    LOG_INFO(LOG_TIME_TO_BEAT, bestTime / 1000, bestTime % 1000);
+  }
+}
+#endif
+
+#ifdef TILT_CONTROL
+/**
+ * @brief Measures the delay the tilt filter adds to a move over the joystick, and the time it
+ *        takes per sample, and prints them.
+ * @note The joystick moves at the first poll it is pushed at, a tilt once enough polls have
+ *       brought its filtered value past the engage tilt. Sudden tilts are fed to a copy of the
+ *       tilt input, levelled at the middle of the accelerometer range, until it moves.
+ */
+void printTiltLatencyToSerial() {
+  const uint16_t LEVEL = 512;
+  const uint8_t MAX_POLLS = 32;
+  const uint16_t tilts[] = {TILT_ENGAGE * 5 / 4, (TILT_ENGAGE + TILT_FULL) / 2, TILT_FULL};
+  Serial.print("Tilt filter delays moves over the joystick by");
+  for (uint8_t i = 0; i < sizeof(tilts) / sizeof(tilts[0]); i++) {
+    TiltInput step = tiltInput;
+    step.startCalibration();
+    while (step.isCalibrating()) {
+      step.update(LEVEL, LEVEL);
+    }
+    uint8_t polls = 0;
+    do {
+      step.update(LEVEL + tilts[i], LEVEL);
+      polls++;
+    } while (inputShaper.shape(step.joyX(), step.joyY()).columnStep == 0 && polls < MAX_POLLS);
+    Serial.print(i > 0 ? ", " : " ");
+    Serial.print((polls - 1) * NUNCHUCK_CHECK_FREQUENCY);
+    Serial.print(" ms at a tilt of ");
+    Serial.print(tilts[i]);
+  }
+
+  // Alternating tilts keep an axis engaging and releasing, the slowest path through update
+  TiltInput timed = tiltInput;
+  const uint16_t SAMPLES = 256;
+  uint32_t startMicros = micros();
+  for (uint16_t i = 0; i < SAMPLES; i++) {
+    timed.update(i & 1 ? LEVEL + TILT_FULL : LEVEL, LEVEL);
+  }
+  uint32_t totalMicros = micros() - startMicros;
+  Serial.print(", ");
+  Serial.print(totalMicros * 1000 / SAMPLES);
+  Serial.println(" ns per sample");
+}
+#endif
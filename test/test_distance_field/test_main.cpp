@@ -0,0 +1,173 @@
+// Checks the incrementally maintained distance field against a fresh breadth-first search.
+//
+// The target takes a random walk through each maze and the field follows it move by move.
+// Every few moves a chaser is walked from every open position along the field, and must reach
+// the target in exactly the number of steps of the search. The exit is left out of the walk,
+// and an even sized maze whose exit closes its only loop is searched with the exit as a wall,
+// like the field treats it.
+
+#include <Arduino.h>
+#include <DistanceField.hpp>
+#include <Maze.hpp>
+#include <MazeStats.hpp>
+#include <unity.h>
+#include <vector>
+
+static const int MAZES_PER_SIZE = 8;
+static const int WALK_MOVES = 300;
+static const int CHECK_INTERVAL = 10; // Moves between two checks of every position
+
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom() {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+static bool isSamePosition(MazePosition first, MazePosition second) {
+  return first.row == second.row && first.column == second.column;
+}
+
+/**
+ * @brief Finds the position the search must treat as a wall for the field to agree with it.
+ * @param maze The maze.
+ * @return The exit if the maze is still a tree without it, none otherwise.
+ */
+static MazePosition getBlockedPosition(Maze& maze) {
+  MazePosition end = maze.getEndPosition();
+  std::vector<int> distance = distancesFrom(maze, maze.getStartPosition(), end);
+  long positions = 0;
+  long stepEnds = 0;
+  for (int i = 0; i < maze.getRows(); i++) {
+    for (int j = 0; j < maze.getColumns(); j++) {
+      MazePosition position = {i, j};
+      if (maze.isCollision(i, j) || isSamePosition(position, end)) {
+        continue;
+      }
+      if (distance[i * maze.getColumns() + j] < 0) {
+        return {-1, -1};
+      }
+      positions++;
+      uint8_t openDirections = maze.getOpenDirections(i, j);
+      for (uint8_t direction = MAZE_UP; direction <= MAZE_LEFT; direction <<= 1) {
+        stepEnds += (openDirections & direction) && !isSamePosition(Maze::step(position, direction), end);
+      }
+    }
+  }
+  return stepEnds / 2 == positions - 1 ? end : MazePosition{-1, -1};
+}
+
+/**
+ * @brief Walks a chaser from every open position to the target along the field.
+ * @param maze The maze.
+ * @param field The field following the target.
+ * @param target The position of the target.
+ * @param blocked The position the search treats as a wall.
+ */
+static void checkEveryPosition(Maze& maze, DistanceField& field, MazePosition target, MazePosition blocked) {
+  std::vector<int> distance = distancesFrom(maze, target, blocked);
+  MazePosition end = maze.getEndPosition();
+  for (int i = 0; i < maze.getRows(); i++) {
+    for (int j = 0; j < maze.getColumns(); j++) {
+      MazePosition chaser = {i, j};
+      if (maze.isCollision(i, j) || isSamePosition(chaser, end)) {
+        continue;
+      }
+      int expected = distance[i * maze.getColumns() + j];
+      int steps = 0;
+      while (!isSamePosition(chaser, target) && steps <= expected) {
+        uint8_t direction = field.getDirection(maze, chaser);
+        TEST_ASSERT_TRUE_MESSAGE(maze.canMove(chaser.row, chaser.column, direction), "The field steps into a wall");
+        chaser = Maze::step(chaser, direction);
+        steps++;
+      }
+      TEST_ASSERT_EQUAL_INT_MESSAGE(expected, steps, "The field is not a shortest path");
+    }
+  }
+}
+
+/**
+ * @brief Follows a random walk of the target through mazes of a size with the field.
+ * @param rows Number of rows in the mazes.
+ * @param columns Number of columns in the mazes.
+ * @param braidPercent The braiding of the mazes, mazes with loops rebuild the field.
+ */
+static void checkRandomWalks(int rows, int columns, uint8_t braidPercent) {
+  Maze maze(rows, columns);
+  maze.setBraiding(braidPercent);
+  DistanceField field(rows, columns);
+  for (uint32_t seed = 1; seed <= MAZES_PER_SIZE; seed++) {
+    maze.generateMaze(seed);
+    MazePosition blocked = getBlockedPosition(maze);
+    MazePosition end = maze.getEndPosition();
+    MazePosition target = maze.getStartPosition();
+    field.update(maze, target);
+    checkEveryPosition(maze, field, target, blocked);
+
+    for (int move = 1; move <= WALK_MOVES; move++) {
+      uint8_t openDirections = maze.getOpenDirections(target.row, target.column);
+      uint8_t direction;
+      MazePosition next;
+      do {
+        direction = 1 << (nextRandom() % 4);
+        next = Maze::step(target, direction);
+      } while (!(openDirections & direction) || isSamePosition(next, end));
+      target = next;
+      field.update(maze, target);
+      if (move % CHECK_INTERVAL == 0) {
+        checkEveryPosition(maze, field, target, blocked);
+      }
+    }
+  }
+}
+
+void setUp() {
+  randomState = 1;
+}
+
+void tearDown() {}
+
+void test_odd_sized_mazes_follow_the_target() {
+  checkRandomWalks(9, 9, 0);
+  checkRandomWalks(17, 17, 0);
+  checkRandomWalks(33, 33, 0);
+}
+
+void test_even_sized_mazes_follow_the_target() {
+  checkRandomWalks(16, 16, 0);
+  checkRandomWalks(32, 32, 0);
+}
+
+void test_braided_mazes_follow_the_target() {
+  checkRandomWalks(17, 17, 50);
+  checkRandomWalks(16, 16, 100);
+}
+
+void test_farthest_position_has_the_most_steps() {
+  Maze maze(17, 17);
+  DistanceField field(17, 17);
+  for (uint32_t seed = 1; seed <= MAZES_PER_SIZE; seed++) {
+    maze.generateMaze(seed);
+    MazePosition start = maze.getStartPosition();
+    std::vector<int> distance = distancesFrom(maze, start);
+    int farthest = 0;
+    for (int i = 1; i < maze.getRows(); i += 2) {
+      for (int j = 1; j < maze.getColumns(); j += 2) {
+        farthest = max(farthest, distance[i * maze.getColumns() + j]);
+      }
+    }
+    MazePosition position = field.getFarthestPosition(maze, start);
+    TEST_ASSERT_EQUAL_INT(farthest, distance[position.row * maze.getColumns() + position.column]);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_odd_sized_mazes_follow_the_target);
+  RUN_TEST(test_even_sized_mazes_follow_the_target);
+  RUN_TEST(test_braided_mazes_follow_the_target);
+  RUN_TEST(test_farthest_position_has_the_most_steps);
+  return UNITY_END();
+}
@@ -0,0 +1,240 @@
+// Checks that the records kept in EEPROM survive a power cycle, and that a power cut at any
+// byte of a write leaves either the previous record or the new one, never a corrupt one.
+//
+// A power cut is simulated by dropping the object that was writing, with its RAM, after a
+// number of bytes, and loading the EEPROM into a new object as at the next startup.
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <GameJournal.hpp>
+#include <Maze.hpp>
+#include <SettingsStore.hpp>
+#include <TimeTrial.hpp>
+#include <unity.h>
+
+static const int JOURNAL_ADDRESS = 0;
+static const int JOURNAL_HALF_SIZE = 64;
+static const int SETTINGS_ADDRESS = 200;
+static const int SETTINGS_SLOTS = 6;
+static const int TIME_TRIAL_ADDRESS = 300;
+static const int TIME_TRIAL_SLOTS = 4;
+static const int TIME_TRIAL_SLOT_BYTES = 96;
+static const int JOURNAL_RECORD_BYTES = GameJournal::SNAPSHOT_BYTES + 1; // With the CRC of the next delta slot
+static const uint8_t MAZE_KEY = 0x5A;
+static const Settings DEFAULT_SETTINGS = {15, CURVE_LINEAR, 55, 0};
+
+static bool isSameState(const GameState& first, const GameState& second) {
+  return first.playerPosition.row == second.playerPosition.row &&
+         first.playerPosition.column == second.playerPosition.column && first.moves == second.moves &&
+         first.elapsedSeconds == second.elapsedSeconds;
+}
+
+static bool isSameSettings(const Settings& first, const Settings& second) {
+  return first.brightness == second.brightness && first.responseCurve == second.responseCurve &&
+         first.joystickDeadzone == second.joystickDeadzone && first.braidPercent == second.braidPercent;
+}
+
+/**
+ * @brief Times a run of a maze that leaves the start and walks a few steps down and back up.
+ * @param timeTrial The time trial.
+ * @param maze The maze of the run.
+ * @param seed The seed the run is saved under.
+ * @param elapsedTime The time the run took in milliseconds.
+ * @return True if the run set a new best time, false otherwise.
+ */
+static bool playRun(TimeTrial& timeTrial, Maze& maze, uint32_t seed, uint32_t elapsedTime) {
+  MazePosition position = maze.getStartPosition();
+  timeTrial.startRun(seed, position);
+  for (int i = 1; i <= 20; i++) {
+    uint8_t direction = maze.getOpenDirections(position.row, position.column);
+    position = Maze::step(position, direction & -direction); // Any open direction
+    timeTrial.recordPosition(maze, position, i * 100);
+  }
+  return timeTrial.finishRun(elapsedTime);
+}
+
+void setUp() {
+  for (int i = 0; i < EEPROM.length(); i++) {
+    EEPROM.write(i, 0xFF);
+  }
+}
+
+void tearDown() {}
+
+void test_journal_recovers_the_last_state() {
+  GameJournal journal(JOURNAL_ADDRESS, JOURNAL_HALF_SIZE);
+  GameState state = {{1, 1}, 0, 0, MAZE_KEY};
+  journal.reset(state);
+  // Enough records to compact into the other half more than once
+  for (int i = 1; i <= 40; i++) {
+    state.playerPosition.column = 1 + i % 7;
+    state.moves = i;
+    state.elapsedSeconds = i * 3;
+    journal.record(state, i * 1000, 1000);
+    journal.service(JOURNAL_RECORD_BYTES);
+  }
+
+  GameJournal restarted(JOURNAL_ADDRESS, JOURNAL_HALF_SIZE);
+  GameState recovered;
+  TEST_ASSERT_TRUE(restarted.recover(recovered, MAZE_KEY));
+  TEST_ASSERT_TRUE(isSameState(state, recovered));
+
+  GameJournal otherMaze(JOURNAL_ADDRESS, JOURNAL_HALF_SIZE);
+  TEST_ASSERT_FALSE(otherMaze.recover(recovered, MAZE_KEY + 1));
+}
+
+void test_journal_survives_a_power_cut_at_every_byte() {
+  for (int i = 1; i <= 40; i++) {
+    for (int cutAfter = 0; cutAfter <= JOURNAL_RECORD_BYTES; cutAfter++) {
+      setUp();
+      GameJournal journal(JOURNAL_ADDRESS, JOURNAL_HALF_SIZE);
+      GameState state = {{1, 1}, 0, 0, MAZE_KEY};
+      journal.reset(state);
+      journal.service(JOURNAL_RECORD_BYTES);
+      GameState previous = state;
+      for (int record = 1; record <= i; record++) {
+        previous = state;
+        state.playerPosition.row = 1 + record % 5;
+        state.moves = record;
+        state.elapsedSeconds = record * 2;
+        journal.record(state, record * 1000, 1000);
+        journal.service(record < i ? JOURNAL_RECORD_BYTES : 0);
+      }
+      for (int n = 0; n < cutAfter; n++) {
+        journal.service(1);
+      }
+
+      GameJournal restarted(JOURNAL_ADDRESS, JOURNAL_HALF_SIZE);
+      GameState recovered;
+      TEST_ASSERT_TRUE(restarted.recover(recovered, MAZE_KEY));
+      TEST_ASSERT_TRUE(isSameState(recovered, previous) || isSameState(recovered, state));
+    }
+  }
+}
+
+void test_settings_load_the_last_commit() {
+  SettingsStore store(SETTINGS_ADDRESS, SETTINGS_SLOTS, DEFAULT_SETTINGS);
+  TEST_ASSERT_FALSE(store.load());
+  Settings settings = DEFAULT_SETTINGS;
+  for (uint8_t i = 0; i < 3 * SETTINGS_SLOTS; i++) {
+    settings.brightness = i % 16;
+    settings.joystickDeadzone = 40 + i;
+    store.set(settings, i * 10000);
+    store.persist(i * 10000 + 5000, 3000, SettingsStore::RECORD_BYTES);
+  }
+  TEST_ASSERT_FALSE(store.isDirty());
+
+  SettingsStore restarted(SETTINGS_ADDRESS, SETTINGS_SLOTS, DEFAULT_SETTINGS);
+  TEST_ASSERT_TRUE(restarted.load());
+  TEST_ASSERT_TRUE(isSameSettings(settings, restarted.get()));
+}
+
+void test_settings_survive_a_power_cut_at_every_byte() {
+  Settings first = {3, CURVE_EXPONENTIAL, 20, 10};
+  Settings second = {9, CURVE_LINEAR, 70, 40};
+  for (int cutAfter = 0; cutAfter <= SettingsStore::RECORD_BYTES; cutAfter++) {
+    setUp();
+    SettingsStore store(SETTINGS_ADDRESS, SETTINGS_SLOTS, DEFAULT_SETTINGS);
+    store.set(first, 0);
+    store.persist(5000, 3000, SettingsStore::RECORD_BYTES);
+    store.set(second, 10000);
+    for (int n = 0; n < cutAfter; n++) {
+      store.persist(15000, 3000, 1);
+    }
+
+    SettingsStore restarted(SETTINGS_ADDRESS, SETTINGS_SLOTS, DEFAULT_SETTINGS);
+    TEST_ASSERT_TRUE(restarted.load());
+    Settings expected = cutAfter == SettingsStore::RECORD_BYTES ? second : first;
+    TEST_ASSERT_TRUE(isSameSettings(expected, restarted.get()));
+  }
+}
+
+void test_settings_out_of_range_fall_back_to_defaults() {
+  SettingsStore store(SETTINGS_ADDRESS, SETTINGS_SLOTS, DEFAULT_SETTINGS);
+  Settings invalid = {16, CURVE_CUSTOM, 127, 101};
+  store.set(invalid, 0);
+  TEST_ASSERT_TRUE(isSameSettings(DEFAULT_SETTINGS, store.get()));
+}
+
+void test_time_trial_keeps_the_best_time() {
+  Maze maze(16, 16);
+  maze.generateMaze(1);
+  TimeTrial timeTrial(TIME_TRIAL_ADDRESS, TIME_TRIAL_SLOTS, TIME_TRIAL_SLOT_BYTES);
+  TEST_ASSERT_TRUE(playRun(timeTrial, maze, 1, 5000));
+  TEST_ASSERT_FALSE(playRun(timeTrial, maze, 1, 6000));
+  // The best run is raced at once, before it is written
+  timeTrial.startRun(1, maze.getStartPosition());
+  TEST_ASSERT_TRUE(timeTrial.hasGhost());
+  TEST_ASSERT_EQUAL_UINT32(5000, timeTrial.getBestTime());
+  timeTrial.cancelRun();
+  timeTrial.step(TIME_TRIAL_SLOT_BYTES);
+
+  TimeTrial restarted(TIME_TRIAL_ADDRESS, TIME_TRIAL_SLOTS, TIME_TRIAL_SLOT_BYTES);
+  restarted.startRun(1, maze.getStartPosition());
+  TEST_ASSERT_EQUAL_UINT32(5000, restarted.getBestTime());
+  restarted.startRun(2, maze.getStartPosition());
+  TEST_ASSERT_FALSE(restarted.hasGhost());
+}
+
+void test_time_trial_survives_a_power_cut_at_every_byte() {
+  Maze maze(16, 16);
+  maze.generateMaze(1);
+  TimeTrial timeTrial(TIME_TRIAL_ADDRESS, TIME_TRIAL_SLOTS, TIME_TRIAL_SLOT_BYTES);
+  playRun(timeTrial, maze, 1, 5000);
+  timeTrial.step(TIME_TRIAL_SLOT_BYTES);
+  playRun(timeTrial, maze, 1, 4000);
+  for (int written = 0; written <= TIME_TRIAL_SLOT_BYTES; written++) {
+    TimeTrial restarted(TIME_TRIAL_ADDRESS, TIME_TRIAL_SLOTS, TIME_TRIAL_SLOT_BYTES);
+    restarted.startRun(1, maze.getStartPosition());
+    TEST_ASSERT_TRUE(restarted.hasGhost());
+    TEST_ASSERT_TRUE(restarted.getBestTime() == 5000 || restarted.getBestTime() == 4000);
+    timeTrial.step(1);
+  }
+  TimeTrial restarted(TIME_TRIAL_ADDRESS, TIME_TRIAL_SLOTS, TIME_TRIAL_SLOT_BYTES);
+  restarted.startRun(1, maze.getStartPosition());
+  TEST_ASSERT_EQUAL_UINT32(4000, restarted.getBestTime());
+}
+
+void test_time_trial_makes_room_for_new_mazes() {
+  Maze maze(16, 16);
+  maze.generateMaze(1);
+  TimeTrial timeTrial(TIME_TRIAL_ADDRESS, TIME_TRIAL_SLOTS, TIME_TRIAL_SLOT_BYTES);
+  for (uint32_t seed = 1; seed <= TIME_TRIAL_SLOTS; seed++) {
+    playRun(timeTrial, maze, seed, 9000);
+    timeTrial.step(TIME_TRIAL_SLOT_BYTES);
+  }
+  // With every slot taken, an improved time replaces the maze improved least recently,
+  // and frees the slot it superseded for the next one
+  playRun(timeTrial, maze, 1, 8000);
+  timeTrial.step(TIME_TRIAL_SLOT_BYTES);
+  playRun(timeTrial, maze, 1, 7000);
+  timeTrial.step(TIME_TRIAL_SLOT_BYTES);
+  timeTrial.startRun(2, maze.getStartPosition());
+  TEST_ASSERT_FALSE(timeTrial.hasGhost());
+  for (uint32_t seed = 3; seed <= TIME_TRIAL_SLOTS; seed++) {
+    timeTrial.startRun(seed, maze.getStartPosition());
+    TEST_ASSERT_EQUAL_UINT32(9000, timeTrial.getBestTime());
+  }
+  // A new maze takes the freed slot
+  playRun(timeTrial, maze, 100, 9000);
+  timeTrial.step(TIME_TRIAL_SLOT_BYTES);
+  uint32_t seeds[TIME_TRIAL_SLOTS] = {1, 3, 4, 100};
+  uint32_t bestTimes[TIME_TRIAL_SLOTS] = {7000, 9000, 9000, 9000};
+  for (int i = 0; i < TIME_TRIAL_SLOTS; i++) {
+    timeTrial.startRun(seeds[i], maze.getStartPosition());
+    TEST_ASSERT_EQUAL_UINT32(bestTimes[i], timeTrial.getBestTime());
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_journal_recovers_the_last_state);
+  RUN_TEST(test_journal_survives_a_power_cut_at_every_byte);
+  RUN_TEST(test_settings_load_the_last_commit);
+  RUN_TEST(test_settings_survive_a_power_cut_at_every_byte);
+  RUN_TEST(test_settings_out_of_range_fall_back_to_defaults);
+  RUN_TEST(test_time_trial_keeps_the_best_time);
+  RUN_TEST(test_time_trial_survives_a_power_cut_at_every_byte);
+  RUN_TEST(test_time_trial_makes_room_for_new_mazes);
+  return UNITY_END();
+}
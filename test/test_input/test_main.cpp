@@ -0,0 +1,89 @@
+// Checks how joystick readings turn into moves, and that the logger drops and counts the
+// messages it has no room for instead of blocking.
+
+#include <Arduino.h>
+#include <InputShaper.hpp>
+#include <Logger.hpp>
+#include <unity.h>
+
+static const uint8_t DEADZONE = 55;
+static const uint16_t MIN_MOVE_DELAY = 100;
+static const uint16_t MAX_MOVE_DELAY = 500;
+
+static const char LOG_MESSAGES[] PROGMEM = "First\0Second\0";
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_deadzone_does_not_move() {
+  InputShaper shaper(DEADZONE, MIN_MOVE_DELAY, MAX_MOVE_DELAY);
+  const uint8_t readings[][2] = {{128, 128}, {128 + DEADZONE, 128}, {128, 128 - DEADZONE}, {160, 160}};
+  for (const uint8_t* reading : readings) {
+    ShapedInput input = shaper.shape(reading[0], reading[1]);
+    TEST_ASSERT_EQUAL_INT(0, input.rowStep);
+    TEST_ASSERT_EQUAL_INT(0, input.columnStep);
+  }
+}
+
+void test_directions() {
+  InputShaper shaper(DEADZONE, MIN_MOVE_DELAY, MAX_MOVE_DELAY);
+  ShapedInput input = shaper.shape(255, 128);
+  TEST_ASSERT_EQUAL_INT(0, input.rowStep);
+  TEST_ASSERT_EQUAL_INT(1, input.columnStep);
+  input = shaper.shape(0, 128);
+  TEST_ASSERT_EQUAL_INT(-1, input.columnStep);
+  input = shaper.shape(128, 255);
+  TEST_ASSERT_EQUAL_INT(-1, input.rowStep); // Joystick up is a smaller row
+  TEST_ASSERT_EQUAL_INT(0, input.columnStep);
+  input = shaper.shape(128, 0);
+  TEST_ASSERT_EQUAL_INT(1, input.rowStep);
+
+  input = shaper.shape(220, 220);
+  TEST_ASSERT_EQUAL_INT(-1, input.rowStep);
+  TEST_ASSERT_EQUAL_INT(1, input.columnStep);
+  shaper.setDiagonals(false);
+  input = shaper.shape(220, 210);
+  TEST_ASSERT_EQUAL_INT(0, input.rowStep);
+  TEST_ASSERT_EQUAL_INT(1, input.columnStep);
+}
+
+void test_curves_speed_up_with_tilt() {
+  const ResponseCurve curves[] = {CURVE_LINEAR, CURVE_EXPONENTIAL};
+  for (ResponseCurve curve : curves) {
+    InputShaper shaper(DEADZONE, MIN_MOVE_DELAY, MAX_MOVE_DELAY, curve);
+    uint16_t lastDelay = MAX_MOVE_DELAY;
+    for (int x = 128 + DEADZONE + 1; x <= 255; x++) {
+      ShapedInput input = shaper.shape(x, 128);
+      TEST_ASSERT_LESS_OR_EQUAL(lastDelay, input.moveDelay);
+      lastDelay = input.moveDelay;
+    }
+    TEST_ASSERT_EQUAL_UINT16(MIN_MOVE_DELAY, lastDelay);
+  }
+
+  // The exponential curve is never faster than the linear one, for fine control at small tilts
+  InputShaper linear(DEADZONE, MIN_MOVE_DELAY, MAX_MOVE_DELAY, CURVE_LINEAR);
+  InputShaper exponential(DEADZONE, MIN_MOVE_DELAY, MAX_MOVE_DELAY, CURVE_EXPONENTIAL);
+  for (int x = 128 + DEADZONE + 1; x <= 255; x++) {
+    TEST_ASSERT_LESS_OR_EQUAL(exponential.shape(x, 128).moveDelay, linear.shape(x, 128).moveDelay);
+  }
+}
+
+void test_logger_counts_dropped_messages() {
+  Logger logger(4, LOG_MESSAGES);
+  for (int i = 0; i < 10; i++) {
+    logger.log(i % 2, i);
+  }
+  TEST_ASSERT_EQUAL_UINT32(6, logger.getDropped());
+  logger.log(0);
+  TEST_ASSERT_EQUAL_UINT32(7, logger.getDropped());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_deadzone_does_not_move);
+  RUN_TEST(test_directions);
+  RUN_TEST(test_curves_speed_up_with_tilt);
+  RUN_TEST(test_logger_counts_dropped_messages);
+  return UNITY_END();
+}
@@ -0,0 +1,118 @@
+// Checks that a maze survives the packed format of maze packs, and that a paged maze is the
+// same maze as one in RAM while its generation stays within its EEPROM write budget.
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Maze.hpp>
+#include <MazeStats.hpp>
+#include <TileCache.hpp>
+#include <TileStore.hpp>
+#include <unity.h>
+#include <vector>
+
+static const int MAZES_PER_SIZE = 20;
+static const int GENERATION_STEPS_PER_CALL = 16;
+static const int GENERATION_BYTES_PER_CALL = 4;
+
+static void checkSameMaze(Maze& expected, Maze& actual) {
+  TEST_ASSERT_EQUAL_INT(expected.getRows(), actual.getRows());
+  TEST_ASSERT_EQUAL_INT(expected.getColumns(), actual.getColumns());
+  for (int i = 0; i < expected.getRows(); i++) {
+    for (int j = 0; j < expected.getColumns(); j++) {
+      TEST_ASSERT_EQUAL_INT(expected.isCollision(i, j), actual.isCollision(i, j));
+    }
+  }
+}
+
+/**
+ * @brief Checks that every open position of a maze is reachable from its start.
+ * @param maze The maze.
+ */
+static void checkConnected(Maze& maze) {
+  std::vector<int> distance = distancesFromStart(maze);
+  for (int i = 0; i < maze.getRows(); i++) {
+    for (int j = 0; j < maze.getColumns(); j++) {
+      TEST_ASSERT_TRUE(maze.isCollision(i, j) || distance[i * maze.getColumns() + j] >= 0);
+    }
+  }
+}
+
+void setUp() {
+  for (int i = 0; i < EEPROM.length(); i++) {
+    EEPROM.write(i, 0xFF);
+  }
+}
+
+void tearDown() {}
+
+void test_same_seed_gives_the_same_maze() {
+  Maze first(17, 17);
+  Maze second(17, 17);
+  for (uint32_t seed = 1; seed <= MAZES_PER_SIZE; seed++) {
+    first.generateMaze(seed);
+    second.generateMaze(seed);
+    checkSameMaze(first, second);
+    checkConnected(first);
+  }
+}
+
+void test_pack_round_trip() {
+  const int sizes[][2] = {{9, 9}, {16, 16}, {17, 33}, {32, 32}};
+  for (const int* size : sizes) {
+    Maze maze(size[0], size[1]);
+    Maze loaded(size[0], size[1]);
+    std::vector<uint8_t> packedMaze(maze.getPackedSize());
+    for (uint32_t seed = 1; seed <= MAZES_PER_SIZE; seed++) {
+      maze.generateMaze(seed);
+      maze.pack(packedMaze.data());
+      loaded.loadFromPack(packedMaze.data(), seed);
+      checkSameMaze(maze, loaded);
+      TEST_ASSERT_EQUAL_UINT32(seed, loaded.getSeed());
+      TEST_ASSERT_EQUAL_UINT8(maze.calculateKey(), loaded.calculateKey());
+    }
+  }
+}
+
+void test_paged_maze_matches_the_maze_in_ram() {
+  EEPROMTileStore store(1);
+  TileCache cache(store, 4);
+  Maze paged(32, 32, &cache);
+  Maze inRAM(32, 32);
+  for (uint8_t braidPercent = 0; braidPercent <= 50; braidPercent += 50) {
+    paged.setBraiding(braidPercent);
+    inRAM.setBraiding(braidPercent);
+    for (uint32_t seed = 1; seed <= MAZES_PER_SIZE; seed++) {
+      paged.beginGeneration(false, seed);
+      bool isComplete = false;
+      while (!isComplete) {
+        uint8_t before[1024];
+        for (int i = 0; i < EEPROM.length(); i++) {
+          before[i] = EEPROM.read(i);
+        }
+        isComplete = paged.stepGeneration(GENERATION_STEPS_PER_CALL, GENERATION_BYTES_PER_CALL);
+        int written = 0;
+        for (int i = 0; i < EEPROM.length(); i++) {
+          written += before[i] != EEPROM.read(i);
+        }
+        TEST_ASSERT_LESS_OR_EQUAL(GENERATION_BYTES_PER_CALL, written);
+      }
+      inRAM.generateMaze(seed);
+      checkSameMaze(inRAM, paged);
+
+      // Saved, the paged maze loads again from the store alone
+      paged.beginSaveToEEPROM();
+      while (!paged.stepSaveToEEPROM(GENERATION_BYTES_PER_CALL)) {
+      }
+      TEST_ASSERT_TRUE(paged.loadFromEEPROM());
+      checkSameMaze(inRAM, paged);
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_same_seed_gives_the_same_maze);
+  RUN_TEST(test_pack_round_trip);
+  RUN_TEST(test_paged_maze_matches_the_maze_in_ram);
+  return UNITY_END();
+}
@@ -0,0 +1,200 @@
+// Measures and validates the distance field the chasing enemy follows, across maze sizes.
+//
+// For every maze the player takes a random walk. After each move the field is updated and
+// the time is compared with a full breadth-first search from the player, which is what
+// keeping the enemy on a shortest path would cost without the field. Every few moves an
+// enemy is dropped on a random open position and follows the field to the player; it must
+// arrive in exactly the number of steps of the breadth-first search. The field treats the
+// exit of an even sized maze as a wall when it closes the only loop, so the search does the
+// same. With -b the mazes are braided, so the field has loops and is rebuilt whenever the
+// player changes cell.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -Itools/host -Ilib/Maze/src -Ilib/MazeBitboard/src -Ilib/Crc8/src -Ilib/DistanceField/src -o chasebench
+//       tools/chasebench/chasebench.cpp lib/DistanceField/src/DistanceField.cpp
+//       lib/Maze/src/Maze.cpp lib/Maze/src/TileCache.cpp
+//       lib/MazeBitboard/src/MazeBitboard.cpp lib/Crc8/src/Crc8.cpp
+//   ./chasebench 100 9x9 16x16 32x32 64x64 [-s first seed] [-b braid percent]
+
+#include <Arduino.h>
+#include <DistanceField.hpp>
+#include <Maze.hpp>
+#include <MazeStats.hpp>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+struct MazeSize {
+  int rows;
+  int columns;
+};
+
+static const int MOVES_PER_CELL = 4;   // Length of the random walk per open position
+static const int CHECK_INTERVAL = 16;  // Moves between two enemy checks
+
+/**
+ * @brief Gets the current time in nanoseconds.
+ */
+static long long nanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief Parses a maze size such as 16x16.
+ * @param text The text to parse.
+ * @param size Receives the parsed size.
+ * @return True if the size is valid, false otherwise.
+ */
+static bool parseSize(const char* text, MazeSize& size) {
+  return sscanf(text, "%dx%d", &size.rows, &size.columns) == 2 && size.rows >= 3 && size.columns >= 3;
+}
+
+int main(int argc, char** argv) {
+  long mazesPerSize = 0;
+  uint32_t firstSeed = 1;
+  int braidPercent = 0;
+  std::vector<MazeSize> sizes;
+  for (int i = 1; i < argc; i++) {
+    MazeSize size;
+    if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      firstSeed = strtoul(argv[++i], nullptr, 0);
+    } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      braidPercent = std::min(std::max(atoi(argv[++i]), 0), 100);
+    } else if (mazesPerSize == 0) {
+      mazesPerSize = atol(argv[i]);
+    } else if (parseSize(argv[i], size)) {
+      sizes.push_back(size);
+    } else {
+      mazesPerSize = -1;
+      break;
+    }
+  }
+  if (mazesPerSize <= 0) {
+    fprintf(stderr, "Usage: %s <mazes per size> [rowsxcolumns...] [-s first seed] [-b braid percent]\n", argv[0]);
+    return 1;
+  }
+  if (sizes.empty()) {
+    sizes = {{9, 9}, {16, 16}, {17, 17}, {32, 32}, {33, 33}, {64, 64}};
+  }
+
+  long totalFailures = 0;
+  for (const MazeSize& size : sizes) {
+    Maze maze(size.rows, size.columns);
+    maze.setBraiding(braidPercent);
+    DistanceField field(size.rows, size.columns);
+    uint32_t randomState = firstSeed;
+    long moves = 0;
+    long checks = 0;
+    long failures = 0;
+    long long fieldNanoseconds = 0;
+    long long maxFieldNanoseconds = 0;
+    long long searchNanoseconds = 0;
+    long long firstBuildNanoseconds = 0;
+    long updates = 0;
+    long rebuilds = 0;
+
+    for (long n = 0; n < mazesPerSize; n++) {
+      maze.generateMaze(firstSeed + n);
+      MazePosition end = maze.getEndPosition();
+      std::vector<MazePosition> openPositions;
+      for (int i = 0; i < size.rows; i++) {
+        for (int j = 0; j < size.columns; j++) {
+          if (!maze.isCollision(i, j) && !(i == end.row && j == end.column)) {
+            openPositions.push_back({i, j});
+          }
+        }
+      }
+
+      MazePosition player = maze.getStartPosition();
+      // Without the exit the maze must still be connected and a tree, one step less than positions
+      MazePosition blocked = end;
+      std::vector<int> distance = distancesFrom(maze, player, blocked);
+      long stepEnds = 0;
+      for (const MazePosition& position : openPositions) {
+        if (distance[position.row * size.columns + position.column] < 0) {
+          blocked = {-1, -1};
+        }
+        uint8_t openDirections = maze.getOpenDirections(position.row, position.column);
+        for (uint8_t direction = MAZE_UP; direction <= MAZE_LEFT; direction <<= 1) {
+          MazePosition next = Maze::step(position, direction);
+          stepEnds += (openDirections & direction) && !(next.row == end.row && next.column == end.column);
+        }
+      }
+      if (stepEnds / 2 != (long)openPositions.size() - 1) {
+        blocked = {-1, -1};
+      }
+
+      long long startNanoseconds = nanoseconds();
+      field.update(maze, player);
+      firstBuildNanoseconds += nanoseconds() - startNanoseconds;
+      field.resetStats();
+
+      long walkLength = (long)openPositions.size() * MOVES_PER_CELL;
+      for (long move = 0; move < walkLength; move++) {
+        // Random walk, the exit is left out so the walk covers the whole maze
+        uint8_t openDirections = maze.getOpenDirections(player.row, player.column);
+        uint8_t direction;
+        MazePosition next;
+        do {
+          randomState ^= randomState << 13;
+          randomState ^= randomState >> 17;
+          randomState ^= randomState << 5;
+          direction = 1 << (randomState % 4);
+          next = Maze::step(player, direction);
+        } while (!(openDirections & direction) || (next.row == end.row && next.column == end.column));
+        player = next;
+        moves++;
+
+        startNanoseconds = nanoseconds();
+        field.update(maze, player);
+        long long elapsed = nanoseconds() - startNanoseconds;
+        fieldNanoseconds += elapsed;
+        maxFieldNanoseconds = std::max(maxFieldNanoseconds, elapsed);
+
+        startNanoseconds = nanoseconds();
+        distance = distancesFrom(maze, player, blocked);
+        searchNanoseconds += nanoseconds() - startNanoseconds;
+
+        if (move % CHECK_INTERVAL != 0) {
+          continue;
+        }
+        checks++;
+        MazePosition enemy = openPositions[randomState % openPositions.size()];
+        int expected = distance[enemy.row * size.columns + enemy.column];
+        int steps = 0;
+        while ((enemy.row != player.row || enemy.column != player.column) && steps <= expected) {
+          uint8_t step = field.getDirection(maze, enemy);
+          if (!maze.canMove(enemy.row, enemy.column, step)) {
+            break;
+          }
+          enemy = Maze::step(enemy, step);
+          steps++;
+        }
+        if (enemy.row != player.row || enemy.column != player.column || steps != expected) {
+          if (failures < 10) {
+            printf("  FAIL seed %lu move %ld: %d steps, expected %d\n", (unsigned long)(firstSeed + n), move, steps,
+                   expected);
+          }
+          failures++;
+        }
+      }
+
+      DistanceFieldStats stats = field.getStats();
+      updates += stats.updates;
+      rebuilds += stats.rebuilds;
+    }
+
+    long cells = (long)(size.rows / 2) * (size.columns / 2);
+    printf("%dx%d: %ld mazes, %ld moves, %ld enemy checks, %ld failed, %d bytes of RAM\n", size.rows, size.columns,
+           mazesPerSize, moves, checks, failures, field.getRAMBytes());
+    printf("  first build      %8.0f ns per maze (%ld cells)\n", (double)firstBuildNanoseconds / mazesPerSize, cells);
+    printf("  field update     %8.1f ns per move, max %lld ns, %.2f cells written per move, %ld rebuilds\n",
+           (double)fieldNanoseconds / moves, maxFieldNanoseconds, (double)(updates + rebuilds * cells) / moves,
+           rebuilds);
+    printf("  full search      %8.1f ns per move (%.0fx slower)\n", (double)searchNanoseconds / moves,
+           (double)searchNanoseconds / std::max(1LL, fieldNanoseconds));
+    totalFailures += failures;
+  }
+  return totalFailures > 0 ? 1 : 0;
+}
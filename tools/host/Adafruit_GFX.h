@@ -0,0 +1,5 @@
+// Empty graphics library for running the game on a host computer, see Adafruit_LEDBackpack.h.
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#endif
@@ -0,0 +1,28 @@
+// Minimal 8x8 LED matrix for running the game on a host computer.
+// Only what the game uses is provided, the pixels are kept but never shown.
+#ifndef HOST_ADAFRUIT_LED_BACKPACK_H
+#define HOST_ADAFRUIT_LED_BACKPACK_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define LED_OFF 0
+#define LED_ON 1
+
+class Adafruit_8x8matrix {
+public:
+  bool begin(uint8_t) { return true; }
+  void setBrightness(uint8_t) {}
+  void clear() { memset(displaybuffer, 0, sizeof(displaybuffer)); }
+  void drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x < 0 || x >= 8 || y < 0 || y >= 8) {
+      return;
+    }
+    displaybuffer[y] = color ? displaybuffer[y] | (1 << x) : displaybuffer[y] & ~(1 << x);
+  }
+  void writeDisplay() {}
+
+  uint16_t displaybuffer[8] = {};
+};
+
+#endif
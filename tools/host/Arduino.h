@@ -0,0 +1,92 @@
+// Minimal Arduino API for building the maze libraries, and the game itself for tools/mazereplay,
+// on a host computer. Only what they use is provided, Serial output goes to stdout.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define F(string) (string)
+#define constrain(value, low, high) ((value) < (low) ? (low) : ((value) > (high) ? (high) : (value)))
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+inline std::chrono::steady_clock::time_point hostStartTime() {
+  static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  return startTime;
+}
+
+// Tools that replay a recording set the time themselves with setHostMillis, until then it is the real time
+inline bool hostIsClockVirtual = false;
+inline unsigned long hostVirtualMillis = 0;
+
+inline void setHostMillis(unsigned long time) {
+  hostIsClockVirtual = true;
+  hostVirtualMillis = time;
+}
+
+inline unsigned long millis() {
+  if (hostIsClockVirtual) {
+    return hostVirtualMillis;
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - hostStartTime()).count();
+}
+
+inline unsigned long micros() {
+  if (hostIsClockVirtual) {
+    return hostVirtualMillis * 1000;
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hostStartTime()).count();
+}
+
+inline void delay(unsigned long) {}
+
+inline int analogRead(uint8_t) {
+  return rand() & 0x3FF;
+}
+
+inline long map(long value, long fromLow, long fromHigh, long toLow, long toHigh) {
+  return (value - fromLow) * (toHigh - toLow) / (fromHigh - fromLow) + toLow;
+}
+
+class HostSerial {
+public:
+  void begin(unsigned long) {}
+  int available() { return 0; }
+  int read() { return -1; }
+  int availableForWrite() { return 64; }
+  size_t write(uint8_t value) { return fputc(value, stdout) == EOF ? 0 : 1; }
+  size_t write(const uint8_t* buffer, size_t length) { return fwrite(buffer, 1, length, stdout); }
+  size_t print(const char* value) { return printf("%s", value); }
+  size_t print(char value) { return printf("%c", value); }
+  size_t print(long value, int base = DEC) { return base == HEX ? printf("%lX", value) : printf("%ld", value); }
+  size_t print(unsigned long value, int base = DEC) { return base == HEX ? printf("%lX", value) : printf("%lu", value); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+  template <typename T> size_t println(T value) { return print(value) + println(); }
+  template <typename T> size_t println(T value, int base) { return print(value, base) + println(); }
+  size_t println() { return printf("\n"); }
+  operator bool() { return true; }
+};
+
+inline HostSerial Serial;
+
+#endif
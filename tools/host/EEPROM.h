@@ -0,0 +1,24 @@
+// Simulated 1 KB EEPROM for building the maze libraries on a host computer.
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+class HostEEPROM {
+public:
+  HostEEPROM() { memset(memory, 0xFF, sizeof(memory)); } // Erased EEPROM reads as 0xFF
+
+  uint8_t read(int address) { return memory[address]; }
+  void write(int address, uint8_t value) { memory[address] = value; }
+  void update(int address, uint8_t value) { memory[address] = value; }
+  uint16_t length() { return sizeof(memory); }
+
+private:
+  uint8_t memory[1024];
+};
+
+// Each thread gets its own EEPROM so parallel tools do not interfere
+inline thread_local HostEEPROM EEPROM;
+
+#endif
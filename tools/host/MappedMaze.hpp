@@ -0,0 +1,358 @@
+// Huge mazes stored in a file that is memory-mapped, shared by the host tools.
+#ifndef HOST_MAPPED_MAZE_HPP
+#define HOST_MAPPED_MAZE_HPP
+
+#include <Maze.hpp>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @brief The header at the start of a mapped maze file, in the byte order of the host.
+ */
+struct MappedMazeHeader {
+  char magic[4];       // "WMZ1"
+  uint32_t tileSize;   // Side of a tile in grid positions, 0 if the rows are not tiled
+  uint64_t rows;
+  uint64_t columns;
+  uint64_t dataOffset; // Start of the bits, page aligned
+  uint64_t rowBytes;   // Bytes per row of bits, within a tile if the rows are tiled
+  uint64_t tileBytes;  // Bytes per tile, 0 if the rows are not tiled
+  uint32_t seed;
+  uint32_t reserved;
+};
+
+/**
+ * @brief A position in a maze too large for the int coordinates of MazePosition.
+ */
+struct MappedPosition {
+  int64_t row;
+  int64_t column;
+};
+
+/**
+ * @class MappedMaze
+ * @brief A maze read straight from a memory-mapped file, without loading it.
+ *
+ * The file stores the positions with exactly one odd coordinate, 1 for a wall, like the packed
+ * format of maze packs, but every row of bits starts on a byte so a position is found in
+ * constant time: bit column / 2 of its row. Cells and corners are not stored, and the start
+ * and end are where Maze puts them.
+ *
+ * The rows are either stored one after the other, or split into square tiles of tileSize
+ * positions, each tile stored as tileSize rows of tileSize / 16 bytes. Tiles of 256 positions
+ * take 4 KB, a page, so a viewport or a search around a position touches a few pages whatever
+ * the width of the maze, where rows wider than a page each take a page of their own.
+ *
+ * Opening a file only reads its header and maps it, and the mapping is advised for random
+ * access, so queries read in only the pages they touch.
+ */
+class MappedMaze {
+public:
+  static const uint64_t PAGE_BYTES = 4096;
+  static const uint64_t DATA_OFFSET = PAGE_BYTES;
+
+  ~MappedMaze() {
+    close();
+  }
+
+  /**
+   * @brief Creates a maze file with every stored position open, and maps it for writing.
+   * @param path The file to create.
+   * @param rows Number of rows in the maze.
+   * @param columns Number of columns in the maze.
+   * @param tileSize Side of a tile, a multiple of 16, or 0 to store whole rows.
+   * @param seed The seed the maze was generated from.
+   * @return Nullptr on success, otherwise the problem found.
+   */
+  const char* create(const char* path, int64_t rows, int64_t columns, uint32_t tileSize, uint32_t seed) {
+    close();
+    if (rows < 3 || columns < 3 || tileSize % 16 != 0) {
+      return "invalid size";
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "WMZ1", 4);
+    header.tileSize = tileSize;
+    header.rows = rows;
+    header.columns = columns;
+    header.dataOffset = DATA_OFFSET;
+    header.rowBytes = tileSize > 0 ? tileSize / 16 : ((columns + 1) / 2 + 7) / 8;
+    header.tileBytes = (uint64_t)tileSize * tileSize / 16;
+    header.seed = seed;
+
+    fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return "cannot create the file";
+    }
+    // The file starts out sparse, every position open until it is written
+    if (ftruncate(fd, getExpectedBytes()) != 0 || !map(PROT_READ | PROT_WRITE)) {
+      close();
+      return "cannot size or map the file";
+    }
+    memcpy(data, &header, sizeof(header));
+    return nullptr;
+  }
+
+  /**
+   * @brief Opens a maze file and maps it for reading, in constant time.
+   * @param path The file to open.
+   * @return Nullptr on success, otherwise the problem found.
+   */
+  const char* open(const char* path) {
+    close();
+    fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      return "cannot open the file";
+    }
+    const char* problem = nullptr;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || memcmp(header.magic, "WMZ1", 4) != 0) {
+      problem = "not a mapped maze";
+    } else if (header.rows < 3 || header.columns < 3 || header.dataOffset % DATA_OFFSET != 0 ||
+               header.tileSize % 16 != 0 ||
+               header.rowBytes != (header.tileSize > 0 ? header.tileSize / 16 : ((header.columns + 1) / 2 + 7) / 8) ||
+               header.tileBytes != (uint64_t)header.tileSize * header.tileSize / 16) {
+      problem = "invalid header";
+    } else if (!map(PROT_READ)) {
+      problem = "truncated or cannot be mapped";
+    }
+    if (problem != nullptr) {
+      close();
+    }
+    return problem;
+  }
+
+  /**
+   * @brief Unmaps and closes the file, writing back any changes.
+   */
+  void close() {
+    if (data != nullptr) {
+      munmap(data, mappedBytes);
+      data = nullptr;
+    }
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+
+  int64_t getRows() {
+    return header.rows;
+  }
+
+  int64_t getColumns() {
+    return header.columns;
+  }
+
+  uint32_t getSeed() {
+    return header.seed;
+  }
+
+  uint32_t getTileSize() {
+    return header.tileSize;
+  }
+
+  uint64_t getFileBytes() {
+    return mappedBytes;
+  }
+
+  /**
+   * @brief Gets the entrance, like Maze::getStartPosition.
+   * @return The start position.
+   */
+  MappedPosition getStartPosition() {
+    return {0, 1};
+  }
+
+  /**
+   * @brief Gets the exit, like Maze::getEndPosition.
+   * @return The end position.
+   */
+  MappedPosition getEndPosition() {
+    MappedPosition endPosition = {getRows() - 1, getColumns() - 2};
+    if (getRows() % 2 == 1 && endPosition.column % 2 == 0) {
+      endPosition.column--;
+    }
+    return endPosition;
+  }
+
+  /**
+   * @brief Gets the value of a position, reading one byte of the mapping at most.
+   * @param row The row of the position, within the maze.
+   * @param column The column of the position, within the maze.
+   * @return WALL, EMPTY, START or END.
+   */
+  uint8_t getCell(int64_t row, int64_t column) {
+    if (row == 0 && column == 1) {
+      return START;
+    }
+    MappedPosition endPosition = getEndPosition();
+    if (row == endPosition.row && column == endPosition.column) {
+      return END;
+    }
+    if ((row & 1) == (column & 1)) {
+      return row & 1 ? EMPTY : WALL; // Cells are always open, corners are always walls
+    }
+    return (data[getByteOffset(row, column)] >> (column / 2 % 8)) & 1 ? WALL : EMPTY;
+  }
+
+  /**
+   * @brief Sets whether a position with exactly one odd coordinate is a wall.
+   * @note Only for a maze opened with create.
+   *
+   * @param row The row of the position.
+   * @param column The column of the position.
+   * @param isWall True for a wall, false for a passage.
+   */
+  void setWall(int64_t row, int64_t column, bool isWall) {
+    uint8_t& bits = data[getByteOffset(row, column)];
+    uint8_t mask = 1 << (column / 2 % 8);
+    bits = isWall ? bits | mask : bits & ~mask;
+  }
+
+  /**
+   * @brief Copies a window of the maze, like Maze::getSubMaze, out of bounds positions read 0.
+   * @param startRow The first row of the window.
+   * @param startColumn The first column of the window.
+   * @param numRows The number of rows of the window.
+   * @param numColumns The number of columns of the window.
+   * @param subMaze Receives the window, one row per pointer.
+   */
+  void getSubMaze(int64_t startRow, int64_t startColumn, int numRows, int numColumns, uint8_t** subMaze) {
+    for (int i = 0; i < numRows; i++) {
+      for (int j = 0; j < numColumns; j++) {
+        int64_t row = startRow + i;
+        int64_t column = startColumn + j;
+        subMaze[i][j] = isInBounds(row, column) ? getCell(row, column) : 0;
+      }
+    }
+  }
+
+  /**
+   * @brief Checks if a position is a wall or out of bounds, like Maze::isCollision.
+   * @param row The row of the position.
+   * @param column The column of the position.
+   * @return True if the position is a wall or out of bounds, false otherwise.
+   */
+  bool isCollision(int64_t row, int64_t column) {
+    return !isInBounds(row, column) || getCell(row, column) == WALL;
+  }
+
+  /**
+   * @brief Gets the directions in which the neighbouring positions are open.
+   * @param row The row of the position.
+   * @param column The column of the position.
+   * @return A mask of MAZE_UP, MAZE_RIGHT, MAZE_DOWN and MAZE_LEFT, 0 for walls.
+   */
+  uint8_t getOpenDirections(int64_t row, int64_t column) {
+    if (isCollision(row, column)) {
+      return 0;
+    }
+    return (isCollision(row - 1, column) ? 0 : MAZE_UP) | (isCollision(row, column + 1) ? 0 : MAZE_RIGHT) |
+           (isCollision(row + 1, column) ? 0 : MAZE_DOWN) | (isCollision(row, column - 1) ? 0 : MAZE_LEFT);
+  }
+
+  /**
+   * @brief Finds a path from the start to the end by following the wall on the right.
+   * @note Only the path is kept in memory, not the positions visited, so any maze that fits
+   *       the file can be solved. In a perfect maze the path found is the only one.
+   *
+   * @param moves Receives the moves of the path, MAZE_UP, MAZE_RIGHT, MAZE_DOWN or MAZE_LEFT.
+   * @return True if the end was reached, false otherwise.
+   */
+  bool solve(std::vector<uint8_t>& moves) {
+    // Clockwise order, turning right is the next direction
+    const uint8_t directions[4] = {MAZE_UP, MAZE_RIGHT, MAZE_DOWN, MAZE_LEFT};
+    const int rowSteps[4] = {-1, 0, 1, 0};
+    const int columnSteps[4] = {0, 1, 0, -1};
+    MappedPosition position = getStartPosition();
+    MappedPosition endPosition = getEndPosition();
+    int facing = 2;
+    moves.clear();
+
+    // Every passage is walked at most once in each direction
+    uint64_t maxSteps = 2 * header.rows * header.columns;
+    for (uint64_t step = 0; step < maxSteps; step++) {
+      if (position.row == endPosition.row && position.column == endPosition.column) {
+        return true;
+      }
+      uint8_t open = getOpenDirections(position.row, position.column);
+      if (open == 0) {
+        return false;
+      }
+      // Right, straight, left, then back
+      int turn = 1;
+      while (!(open & directions[(facing + turn) % 4])) {
+        turn = (turn + 3) % 4;
+      }
+      facing = (facing + turn) % 4;
+      position.row += rowSteps[facing];
+      position.column += columnSteps[facing];
+
+      // Walking back along the path undoes its last move
+      if (!moves.empty() && moves.back() == directions[(facing + 2) % 4]) {
+        moves.pop_back();
+      } else {
+        moves.push_back(directions[facing]);
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Gets where in the file the bit of a position is.
+   * @param row The row of a position with exactly one odd coordinate.
+   * @param column The column of the position.
+   * @return The offset of the byte holding the bit, from the start of the file.
+   */
+  uint64_t getByteOffset(int64_t row, int64_t column) {
+    if (header.tileSize == 0) {
+      return header.dataOffset + row * header.rowBytes + column / 2 / 8;
+    }
+    uint64_t tile = row / header.tileSize * tilesPerRow + column / header.tileSize;
+    return header.dataOffset + tile * header.tileBytes + row % header.tileSize * header.rowBytes +
+           column % header.tileSize / 2 / 8;
+  }
+
+private:
+  MappedMazeHeader header = {};
+  int fd = -1;
+  uint8_t* data = nullptr;
+  size_t mappedBytes = 0;
+  uint64_t tilesPerRow = 0;
+
+  uint64_t getExpectedBytes() {
+    if (header.tileSize == 0) {
+      return header.dataOffset + header.rows * header.rowBytes;
+    }
+    uint64_t tileRows = (header.rows + header.tileSize - 1) / header.tileSize;
+    uint64_t tileColumns = (header.columns + header.tileSize - 1) / header.tileSize;
+    return header.dataOffset + tileRows * tileColumns * header.tileBytes;
+  }
+
+  bool map(int protection) {
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (uint64_t)status.st_size < getExpectedBytes()) {
+      return false;
+    }
+    mappedBytes = getExpectedBytes();
+    void* mapping = mmap(nullptr, mappedBytes, protection, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+      return false;
+    }
+    data = (uint8_t*)mapping;
+    // Read ahead would fault in pages the queries never touch
+    madvise(data, mappedBytes, MADV_RANDOM);
+    tilesPerRow = header.tileSize > 0 ? (header.columns + header.tileSize - 1) / header.tileSize : 0;
+    return true;
+  }
+
+  bool isInBounds(int64_t row, int64_t column) {
+    return row >= 0 && row < (int64_t)header.rows && column >= 0 && column < (int64_t)header.columns;
+  }
+
+};
+
+#endif
@@ -0,0 +1,77 @@
+// Maze measurements shared by the host tools.
+#ifndef HOST_MAZE_STATS_HPP
+#define HOST_MAZE_STATS_HPP
+
+#include <Maze.hpp>
+#include <MazeBitboard.hpp>
+#include <vector>
+
+/**
+ * @brief Computes the number of steps from a position of a maze to every cell.
+ * @param maze The maze to explore.
+ * @param source The position to start from.
+ * @param blocked A position to treat as a wall, none by default.
+ * @return The distance of each cell, indexed by row * columns + column, -1 if unreachable.
+ */
+inline std::vector<int> distancesFrom(Maze& maze, MazePosition source, MazePosition blocked = {-1, -1}) {
+  int rows = maze.getRows();
+  int columns = maze.getColumns();
+  std::vector<int> distance(rows * columns, -1);
+  std::vector<int> queue;
+  queue.push_back(source.row * columns + source.column);
+  distance[queue[0]] = 0;
+
+  const int directionRows[4] = {-1, 0, 1, 0};
+  const int directionColumns[4] = {0, 1, 0, -1};
+  for (size_t next = 0; next < queue.size(); next++) {
+    int row = queue[next] / columns;
+    int column = queue[next] % columns;
+    for (int d = 0; d < 4; d++) {
+      int neighbourRow = row + directionRows[d];
+      int neighbourColumn = column + directionColumns[d];
+      if (maze.isCollision(neighbourRow, neighbourColumn) ||
+          (neighbourRow == blocked.row && neighbourColumn == blocked.column)) {
+        continue;
+      }
+      int neighbour = neighbourRow * columns + neighbourColumn;
+      if (distance[neighbour] < 0) {
+        distance[neighbour] = distance[queue[next]] + 1;
+        queue.push_back(neighbour);
+      }
+    }
+  }
+  return distance;
+}
+
+/**
+ * @brief Computes the number of steps from the start of a maze to every cell.
+ * @param maze The maze to explore.
+ * @return The distance of each cell, indexed by row * columns + column, -1 if unreachable.
+ */
+inline std::vector<int> distancesFromStart(Maze& maze) {
+  return distancesFrom(maze, maze.getStartPosition());
+}
+
+/**
+ * @brief Counts the steps of the shortest path from the start to the end of a maze.
+ * @param maze The maze to solve.
+ * @return The number of steps, -1 if the end cannot be reached.
+ */
+inline int solutionLength(Maze& maze) {
+  MazePosition end = maze.getEndPosition();
+  return distancesFromStart(maze)[end.row * maze.getColumns() + end.column];
+}
+
+/**
+ * @brief Counts the open cells of a maze with exactly one open neighbour, a row of cells at a
+ *        time with the bitboard kernels.
+ * @param maze The maze to analyse.
+ * @return The number of dead ends.
+ */
+inline int countDeadEnds(Maze& maze) {
+  MazeBitboard bitboard(maze.getRows(), maze.getColumns());
+  bitboard.load(maze);
+  return bitboard.countDeadEnds();
+}
+
+#endif
@@ -0,0 +1,95 @@
+// Minimal Nunchuk for running the game on a host computer.
+// Each update returns the reading queued with setNextReading, so tools such as mazereplay can
+// feed the game recorded or generated input. The joystick rests at the centre until then, and the
+// accelerometer reads a nunchuk held level, until setNextAccel.
+#ifndef HOST_NINTENDO_EXTENSION_CTRL_H
+#define HOST_NINTENDO_EXTENSION_CTRL_H
+
+#include <stdint.h>
+
+class Nunchuk {
+public:
+  void begin() {}
+  bool connect() { return isNextConnected; }
+
+  bool update() {
+    if (!isNextConnected) {
+      return false;
+    }
+    x = nextX;
+    y = nextY;
+    c = nextC;
+    z = nextZ;
+    ax = nextAX;
+    ay = nextAY;
+    az = nextAZ;
+    return true;
+  }
+
+  uint8_t joyX() { return x; }
+  uint8_t joyY() { return y; }
+  bool buttonC() { return c; }
+  bool buttonZ() { return z; }
+  uint16_t accelX() { return ax; }
+  uint16_t accelY() { return ay; }
+  uint16_t accelZ() { return az; }
+
+  /**
+   * @brief Queues the reading returned by the following updates.
+   * @param joyX The joystick X axis, 0 to 255.
+   * @param joyY The joystick Y axis, 0 to 255.
+   * @param buttonC True if C is pressed.
+   * @param buttonZ True if Z is pressed.
+   * @param isConnected False to make the updates fail, as when the nunchuk is unplugged.
+   */
+  void setNextReading(uint8_t joyX, uint8_t joyY, bool buttonC, bool buttonZ, bool isConnected = true) {
+    nextX = joyX;
+    nextY = joyY;
+    nextC = buttonC;
+    nextZ = buttonZ;
+    isNextConnected = isConnected;
+  }
+
+  /**
+   * @brief Sets the current reading, as if it had just been returned by an update.
+   * @param joyX The joystick X axis, 0 to 255.
+   * @param joyY The joystick Y axis, 0 to 255.
+   * @param buttonC True if C is pressed.
+   * @param buttonZ True if Z is pressed.
+   */
+  void setReading(uint8_t joyX, uint8_t joyY, bool buttonC, bool buttonZ) {
+    setNextReading(joyX, joyY, buttonC, buttonZ);
+    update();
+  }
+
+  /**
+   * @brief Queues the accelerometer reading returned by the following updates.
+   * @param accelX The X axis, 0 to 1023.
+   * @param accelY The Y axis, 0 to 1023.
+   * @param accelZ The Z axis, 0 to 1023.
+   */
+  void setNextAccel(uint16_t accelX, uint16_t accelY, uint16_t accelZ) {
+    nextAX = accelX;
+    nextAY = accelY;
+    nextAZ = accelZ;
+  }
+
+private:
+  uint8_t x = 128;
+  uint8_t y = 128;
+  bool c = false;
+  bool z = false;
+  uint8_t nextX = 128;
+  uint8_t nextY = 128;
+  bool nextC = false;
+  bool nextZ = false;
+  bool isNextConnected = true;
+  uint16_t ax = 512; // Level, 1 g is about 200 on each axis
+  uint16_t ay = 512;
+  uint16_t az = 712;
+  uint16_t nextAX = 512;
+  uint16_t nextAY = 512;
+  uint16_t nextAZ = 712;
+};
+
+#endif
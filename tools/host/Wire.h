@@ -0,0 +1,5 @@
+// Empty Wire library for running the game on a host computer, see Adafruit_LEDBackpack.h.
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#endif
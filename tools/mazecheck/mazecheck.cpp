@@ -0,0 +1,373 @@
+// Validates the maze generator over many seeds and sizes on all cores.
+//
+// Every maze is checked for:
+//   - bounds: start and end on the border, valid cell values, closed outer walls
+//   - spanning tree: every cell carved, the open cells connected without loops (union-find)
+//   - reachability: the end can be reached from the start
+// and the distributions of solution lengths and dead ends are printed for each size,
+// together with the throughput in mazes/s. With -b the mazes are braided and must instead
+// have exactly as many loops as the braiding pass reports, and the loops and the time spent
+// braiding are printed too. The exit code is 1 if any maze failed, and
+// every failure is reported with its seed, which Maze::generateMaze(seed) reproduces.
+//
+// In mazes with an even number of rows and columns the exit is opened in the last row of
+// cells, between two of them. If the generator did not already carve a passage there, the exit closes a
+// loop. These mazes are counted as exit loops rather than failures.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -pthread -Itools/host -Ilib/Maze/src -Ilib/MazeBitboard/src -Ilib/Crc8/src -o mazecheck
+//       tools/mazecheck/mazecheck.cpp lib/Maze/src/Maze.cpp lib/Maze/src/TileCache.cpp
+//       lib/MazeBitboard/src/MazeBitboard.cpp lib/Crc8/src/Crc8.cpp
+//   ./mazecheck 100000 9x9 16x16 33x33 64x64 [-s first seed] [-j threads] [-b braid percent]
+
+#include <Arduino.h>
+#include <Maze.hpp>
+#include <MazeStats.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct MazeSize {
+  int rows;
+  int columns;
+};
+
+struct Failure {
+  uint32_t seed;
+  std::string reason;
+};
+
+/**
+ * @brief Counts how often each value occurred.
+ */
+struct Distribution {
+  std::vector<long> counts;
+
+  void add(int value) {
+    if (value >= (int)counts.size()) {
+      counts.resize(value + 1);
+    }
+    counts[value]++;
+  }
+
+  void merge(const Distribution& other) {
+    if (other.counts.size() > counts.size()) {
+      counts.resize(other.counts.size());
+    }
+    for (size_t i = 0; i < other.counts.size(); i++) {
+      counts[i] += other.counts[i];
+    }
+  }
+
+  long total() const {
+    long sum = 0;
+    for (long count : counts) {
+      sum += count;
+    }
+    return sum;
+  }
+
+  int percentile(double fraction) const {
+    long target = (long)(fraction * (total() - 1));
+    long seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+      seen += counts[i];
+      if (seen > target) {
+        return i;
+      }
+    }
+    return 0;
+  }
+
+  double mean() const {
+    double sum = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+      sum += (double)i * counts[i];
+    }
+    return sum / std::max(1L, total());
+  }
+
+  void print(const char* name) const {
+    printf("  %-16s min %4d  p10 %4d  p50 %4d  p90 %4d  p99 %4d  max %4d  mean %7.1f\n", name, percentile(0),
+           percentile(0.1), percentile(0.5), percentile(0.9), percentile(0.99), percentile(1), mean());
+  }
+};
+
+/**
+ * @brief Disjoint sets of cells with path halving.
+ */
+struct UnionFind {
+  std::vector<int> parent;
+
+  void reset(int size) {
+    parent.resize(size);
+    for (int i = 0; i < size; i++) {
+      parent[i] = i;
+    }
+  }
+
+  int find(int cell) {
+    while (parent[cell] != cell) {
+      parent[cell] = parent[parent[cell]];
+      cell = parent[cell];
+    }
+    return cell;
+  }
+
+  // Returns false if both cells were already connected
+  bool join(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+      return false;
+    }
+    parent[a] = b;
+    return true;
+  }
+};
+
+/**
+ * @brief Validates a generated maze.
+ * @param maze The maze to validate.
+ * @param cells Buffer receiving the cells of the maze, one row per pointer.
+ * @param sets Union-find buffer.
+ * @param distance Receives the distance of each cell from the start.
+ * @param expectedLoops The number of loops opened by braiding.
+ * @param hasExitLoop Set to true if the exit closes a loop, false otherwise.
+ * @return Nullptr if the maze is valid, otherwise the first problem found.
+ */
+static const char* validateMaze(Maze& maze, std::vector<uint8_t*>& cells, UnionFind& sets, std::vector<int>& distance,
+                                int expectedLoops, bool& hasExitLoop) {
+  int rows = maze.getRows();
+  int columns = maze.getColumns();
+  MazePosition start = maze.getStartPosition();
+  MazePosition end = maze.getEndPosition();
+  maze.getSubMaze(0, 0, rows, columns, cells.data());
+
+  // Bounds
+  auto isInside = [&](MazePosition p) { return p.row >= 0 && p.row < rows && p.column >= 0 && p.column < columns; };
+  auto isOnBorder = [&](MazePosition p) {
+    return p.row == 0 || p.row == rows - 1 || p.column == 0 || p.column == columns - 1;
+  };
+  if (!isInside(start) || !isInside(end) || !isOnBorder(start) || !isOnBorder(end)) {
+    return "start or end out of bounds";
+  }
+  if (cells[start.row][start.column] != START || cells[end.row][end.column] != END) {
+    return "start or end not marked";
+  }
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < columns; j++) {
+      uint8_t cell = cells[i][j];
+      bool isEndpoint = (i == start.row && j == start.column) || (i == end.row && j == end.column);
+      if (!isEndpoint && cell != EMPTY && cell != WALL) {
+        return "invalid cell value";
+      }
+      // The last row and column are only an outer wall for odd sizes
+      bool isOuterWall = i == 0 || j == 0 || (i == rows - 1 && rows % 2 == 1) || (j == columns - 1 && columns % 2 == 1);
+      if (isOuterWall && !isEndpoint && cell != WALL) {
+        return "hole in the outer wall";
+      }
+      if (i % 2 == 0 && j % 2 == 0 && cell != WALL) {
+        return "open wall corner";
+      }
+      if (i % 2 == 1 && j % 2 == 1 && cell == WALL) {
+        return "cell not carved";
+      }
+    }
+  }
+
+  // Spanning tree: every passage joins two separate parts, and a single part remains
+  auto isOpen = [&](int i, int j) { return i < rows && j < columns && cells[i][j] != WALL; };
+  auto isEnd = [&](int i, int j) { return i == end.row && j == end.column; };
+  hasExitLoop = false;
+  sets.reset(rows * columns);
+  int parts = 0;
+  int loops = 0;
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < columns; j++) {
+      if (!isOpen(i, j)) {
+        continue;
+      }
+      parts++;
+      const int neighbourRows[2] = {i, i + 1};
+      const int neighbourColumns[2] = {j + 1, j};
+      for (int n = 0; n < 2; n++) {
+        int neighbourRow = neighbourRows[n];
+        int neighbourColumn = neighbourColumns[n];
+        if (!isOpen(neighbourRow, neighbourColumn)) {
+          continue;
+        }
+        if (sets.join(i * columns + j, neighbourRow * columns + neighbourColumn)) {
+          parts--;
+        } else if (expectedLoops == 0 && (isEnd(i, j) || isEnd(neighbourRow, neighbourColumn))) {
+          hasExitLoop = true;
+        } else {
+          loops++;
+        }
+      }
+    }
+  }
+  // With braiding the loop closed by the exit is not necessarily found at the exit
+  bool isExitBetweenCells = isOpen(end.row, end.column - 1) && isOpen(end.row, end.column + 1);
+  if (expectedLoops > 0 && loops == expectedLoops + 1 && isExitBetweenCells) {
+    hasExitLoop = true;
+    loops--;
+  }
+  if (loops != expectedLoops) {
+    return "loop";
+  }
+  if (parts != 1) {
+    return "disconnected";
+  }
+
+  // Reachability
+  distance = distancesFromStart(maze);
+  if (distance[end.row * columns + end.column] < 0) {
+    return "end unreachable";
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Parses a maze size such as 16x16.
+ * @param text The text to parse.
+ * @param size Receives the parsed size.
+ * @return True if the size is valid, false otherwise.
+ */
+static bool parseSize(const char* text, MazeSize& size) {
+  return sscanf(text, "%dx%d", &size.rows, &size.columns) == 2 && size.rows >= 3 && size.columns >= 3;
+}
+
+int main(int argc, char** argv) {
+  long seedsPerSize = 0;
+  uint32_t firstSeed = 1;
+  unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+  int braidPercent = 0;
+  std::vector<MazeSize> sizes;
+  for (int i = 1; i < argc; i++) {
+    MazeSize size;
+    if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      firstSeed = strtoul(argv[++i], nullptr, 0);
+    } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threadCount = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      braidPercent = std::min(std::max(atoi(argv[++i]), 0), 100);
+    } else if (seedsPerSize == 0) {
+      seedsPerSize = atol(argv[i]);
+    } else if (parseSize(argv[i], size)) {
+      sizes.push_back(size);
+    } else {
+      seedsPerSize = -1;
+      break;
+    }
+  }
+  if (seedsPerSize <= 0) {
+    fprintf(stderr, "Usage: %s <seeds per size> [rowsxcolumns...] [-s first seed] [-j threads] [-b braid percent]\n",
+            argv[0]);
+    return 1;
+  }
+  if (sizes.empty()) {
+    sizes = {{8, 8}, {9, 9}, {16, 16}, {17, 17}, {15, 41}, {32, 32}, {33, 33}, {64, 64}};
+  }
+
+  long totalMazes = 0;
+  long totalFailures = 0;
+  unsigned long totalStartMicros = micros();
+  for (const MazeSize& size : sizes) {
+    Distribution solutionLengths;
+    Distribution deadEnds;
+    Distribution loops;
+    std::vector<Failure> failures;
+    long failureCount = 0;
+    long exitLoops = 0;
+    long braidMicros = 0;
+    std::mutex resultsMutex;
+
+    // Threads take batches of seeds so the shared counter is rarely contended
+    const long BATCH = 256;
+    std::atomic<long> nextSeed(0);
+    unsigned long startMicros = micros();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; t++) {
+      threads.emplace_back([&]() {
+        Maze maze(size.rows, size.columns);
+        maze.setBraiding(braidPercent);
+        std::vector<uint8_t> cellBuffer(size.rows * size.columns);
+        std::vector<uint8_t*> cells(size.rows);
+        for (int i = 0; i < size.rows; i++) {
+          cells[i] = &cellBuffer[i * size.columns];
+        }
+        UnionFind sets;
+        std::vector<int> distance;
+        Distribution localSolutionLengths;
+        Distribution localDeadEnds;
+        Distribution localLoops;
+        std::vector<Failure> localFailures;
+        long localFailureCount = 0;
+        long localExitLoops = 0;
+        long localBraidMicros = 0;
+
+        for (long batch = nextSeed.fetch_add(BATCH); batch < seedsPerSize; batch = nextSeed.fetch_add(BATCH)) {
+          for (long i = batch; i < std::min(batch + BATCH, seedsPerSize); i++) {
+            uint32_t seed = firstSeed + i;
+            maze.generateMaze(seed);
+            bool hasExitLoop;
+            BraidStats braidStats = maze.getBraidStats();
+            localBraidMicros += braidStats.micros;
+            const char* reason = validateMaze(maze, cells, sets, distance, braidStats.loops, hasExitLoop);
+            if (reason != nullptr) {
+              localFailureCount++;
+              if (localFailures.size() < 10) {
+                localFailures.push_back({seed, reason});
+              }
+              continue;
+            }
+            localExitLoops += hasExitLoop;
+            MazePosition end = maze.getEndPosition();
+            localSolutionLengths.add(distance[end.row * size.columns + end.column]);
+            localDeadEnds.add(countDeadEnds(maze));
+            localLoops.add(braidStats.loops);
+          }
+        }
+
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        solutionLengths.merge(localSolutionLengths);
+        deadEnds.merge(localDeadEnds);
+        loops.merge(localLoops);
+        braidMicros += localBraidMicros;
+        failureCount += localFailureCount;
+        exitLoops += localExitLoops;
+        failures.insert(failures.end(), localFailures.begin(), localFailures.end());
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    double seconds = std::max(1e-6, (micros() - startMicros) / 1e6);
+
+    printf("%dx%d: %ld mazes, %ld failed, %ld exit loops, %.2f s on %u threads (%.0f mazes/s)\n", size.rows,
+           size.columns, seedsPerSize, failureCount, exitLoops, seconds, threadCount, seedsPerSize / seconds);
+    if (solutionLengths.total() > 0) {
+      solutionLengths.print("solution length");
+      deadEnds.print("dead ends");
+    }
+    if (braidPercent > 0 && loops.total() > 0) {
+      loops.print("braided loops");
+      printf("  braiding %d%% took %.2f us per maze\n", braidPercent, (double)braidMicros / seedsPerSize);
+    }
+    std::sort(failures.begin(), failures.end(), [](const Failure& a, const Failure& b) { return a.seed < b.seed; });
+    for (size_t i = 0; i < failures.size() && i < 10; i++) {
+      printf("  FAIL seed %lu: %s\n", (unsigned long)failures[i].seed, failures[i].reason.c_str());
+    }
+    totalMazes += seedsPerSize;
+    totalFailures += failureCount;
+  }
+
+  double totalSeconds = std::max(1e-6, (micros() - totalStartMicros) / 1e6);
+  printf("Total: %ld mazes, %ld failed, %.2f s (%.0f mazes/s)\n", totalMazes, totalFailures, totalSeconds,
+         totalMazes / totalSeconds);
+  return totalFailures > 0 ? 1 : 0;
+}
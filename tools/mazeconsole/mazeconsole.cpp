@@ -0,0 +1,154 @@
+// Runs the serial console commands of the game against the maze library, for scripted perf runs.
+//
+// Commands are read line by line from a script file, or from stdin, and parsed by the same
+// SerialConsole as on the device, so a script can be typed into the serial monitor too.
+// Each command is echoed before its output:
+//   seed <n>             generate the maze of a seed
+//   regen                generate a new random maze
+//   size <rows> <cols>   change the maze size, generating a maze of the new size
+//   dump [bin]           print the maze, or write it in the packed format of maze packs
+//   stats                print the seed, size, solution length and dead ends
+//   goto <row> <col>     move the player, which dump shows
+//   bench [n]            time the generation of n mazes of the current size (default 100)
+// The exit code is 1 if any command failed.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -Itools/host -Ilib/Maze/src -Ilib/MazeBitboard/src -Ilib/Crc8/src -Ilib/SerialConsole/src -o mazeconsole
+//       tools/mazeconsole/mazeconsole.cpp lib/SerialConsole/src/SerialConsole.cpp
+//       lib/Maze/src/Maze.cpp lib/Maze/src/TileCache.cpp
+//       lib/MazeBitboard/src/MazeBitboard.cpp lib/Crc8/src/Crc8.cpp
+//   printf 'size 32 32\nbench 1000\n' | ./mazeconsole
+//   ./mazeconsole script.txt
+
+#include <Arduino.h>
+#include <Maze.hpp>
+#include <MazeStats.hpp>
+#include <SerialConsole.hpp>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+static const int DEFAULT_BENCH_MAZES = 100;
+static const int MAX_MAZE_SIZE = 255; // Positions are stored in a byte in several libraries
+
+/**
+ * @brief Runs the command the console has just read.
+ * @param console The console holding the command.
+ * @param maze The maze the commands act on, replaced by size.
+ * @param player The position of the player.
+ * @return True if the command succeeded, false otherwise.
+ */
+static bool runCommand(SerialConsole& console, std::unique_ptr<Maze>& maze, MazePosition& player) {
+  long first;
+  long second;
+  switch (console.getCommand()) {
+    case CONSOLE_SEED:
+      if (!console.getNumber(0, first)) {
+        printf("Usage: seed <n>\n");
+        return false;
+      }
+      maze->generateMaze((uint32_t)first);
+      player = maze->getStartPosition();
+      return true;
+    case CONSOLE_REGEN:
+      maze->generateMaze();
+      player = maze->getStartPosition();
+      return true;
+    case CONSOLE_SIZE:
+      if (!console.getNumber(0, first) || !console.getNumber(1, second) || first < 3 || second < 3 ||
+          first > MAX_MAZE_SIZE || second > MAX_MAZE_SIZE) {
+        printf("Usage: size <rows> <columns>, 3 to %d each\n", MAX_MAZE_SIZE);
+        return false;
+      }
+      maze.reset(new Maze(first, second));
+      maze->generateMaze();
+      player = maze->getStartPosition();
+      return true;
+    case CONSOLE_DUMP:
+      if (console.isArgument(0, "bin")) {
+        std::vector<uint8_t> packedMaze(maze->getPackedSize());
+        maze->pack(packedMaze.data());
+        printf("Packed maze %d %d %zu\n", maze->getRows(), maze->getColumns(), packedMaze.size());
+        fwrite(packedMaze.data(), 1, packedMaze.size(), stdout);
+        printf("\n");
+      } else {
+        maze->printToSerialWithPlayer(player);
+      }
+      return true;
+    case CONSOLE_STATS:
+      printf("Seed %lu, size %dx%d, player at (%d, %d), solution %d steps, %d dead ends\n",
+             (unsigned long)maze->getSeed(), maze->getRows(), maze->getColumns(), player.row, player.column,
+             solutionLength(*maze), countDeadEnds(*maze));
+      return true;
+    case CONSOLE_GOTO:
+      if (!console.getNumber(0, first) || !console.getNumber(1, second) || maze->isCollision(first, second)) {
+        printf("Usage: goto <row> <column> of an open position\n");
+        return false;
+      }
+      player.row = first;
+      player.column = second;
+      return true;
+    case CONSOLE_BENCH: {
+      if (!console.getNumber(0, first) || first <= 0) {
+        first = DEFAULT_BENCH_MAZES;
+      }
+      // Generating into the live maze, the seed and player are kept by regenerating it afterwards
+      uint32_t seed = maze->getSeed();
+      auto start = std::chrono::steady_clock::now();
+      for (long i = 0; i < first; i++) {
+        maze->generateMaze(seed + 1 + i);
+      }
+      double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      maze->generateMaze(seed);
+      printf("Bench: %ld mazes of %dx%d, %.1f us per maze (%.0f mazes/s)\n", first, maze->getRows(),
+             maze->getColumns(), micros / first, first * 1e6 / micros);
+      return true;
+    }
+    case CONSOLE_RECORD:
+      printf("Nothing is recorded here, replay device recordings with tools/mazereplay\n");
+      return true;
+    case CONSOLE_TILT:
+      printf("There is no nunchuk here to calibrate\n");
+      return true;
+    case CONSOLE_HELP:
+      SerialConsole::printHelp();
+      return true;
+    default:
+      printf("Unknown command, type help for the list\n");
+      return false;
+  }
+}
+
+int main(int argc, char** argv) {
+  FILE* script = stdin;
+  if (argc > 1) {
+    script = fopen(argv[1], "r");
+    if (script == nullptr) {
+      fprintf(stderr, "Usage: %s [script]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  std::unique_ptr<Maze> maze(new Maze(16, 16));
+  maze->generateMaze(1);
+  MazePosition player = maze->getStartPosition();
+  SerialConsole console;
+  std::vector<char> line;
+  bool isFailed = false;
+  int character;
+  do {
+    character = fgetc(script);
+    if (character != EOF && character != '\n') {
+      line.push_back(character);
+    }
+    // A last line without a newline still runs
+    if (console.feed(character == EOF ? '\n' : character)) {
+      printf("> %.*s\n", (int)line.size(), line.data());
+      isFailed |= !runCommand(console, maze, player);
+    }
+    if (character == '\n') {
+      line.clear();
+    }
+  } while (character != EOF);
+  return isFailed ? 1 : 0;
+}
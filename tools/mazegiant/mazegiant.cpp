@@ -0,0 +1,468 @@
+// Generates very large perfect mazes, 10000x10000 and beyond, on all cores.
+//
+// Maze::generateMaze keeps its whole stack in RAM, indexes cells with int and runs on one
+// thread, which caps it far below these sizes. Here the cells are split into square regions
+// that are carved in parallel, each with the same recursive backtracker as the device, and
+// stitched into one maze by recursive division over the regions: every division opens a single
+// passage somewhere along its dividing line, which joins two spanning trees into one, so the
+// result is a perfect maze whatever the number of regions.
+//
+// Every region is carved from its own seed, derived from the maze seed and its index, so the
+// same seed gives the same maze on any number of threads. The maze is written in the packed
+// format of maze packs, see Maze::getPackedSize, with the start and end where the device puts
+// them. Like on the device, the exit of a maze with an even number of rows and columns may
+// close a loop.
+//
+// With -b the carving is timed on 1, 2, 4... threads up to the core count and the speedup
+// printed, along with a hash of the cells to confirm every run carved the same maze. With -c
+// the maze is checked to be a spanning tree of its cells before it is written. With -m the maze
+// is written in the memory-mapped format of MappedMaze instead, in square tiles of the given
+// number of positions, 256 for a page per tile, or in whole rows with 0. tools/mazemap reads it.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -pthread -Itools/host -Ilib/Maze/src -o mazegiant tools/mazegiant/mazegiant.cpp
+//   ./mazegiant 10001 10001 maze.bin [-s seed] [-j threads] [-r region cells] [-m tile size] [-b] [-c]
+
+#include <Arduino.h>
+#include <MappedMaze.hpp>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Each cell owns the walls to its right and below it, so regions never write the same byte
+const uint8_t OPEN_RIGHT = 1;
+const uint8_t OPEN_DOWN = 2;
+const uint8_t VISITED = 4;
+
+struct GiantMaze {
+  int64_t rows;
+  int64_t columns;
+  int64_t cellRows;
+  int64_t cellColumns;
+  int64_t regionCells;
+  int64_t regionRows;
+  int64_t regionColumns;
+  std::vector<uint8_t> cells; // Indexed by cell row * cellColumns + cell column
+
+  uint8_t& cell(int64_t cellRow, int64_t cellColumn) {
+    return cells[cellRow * cellColumns + cellColumn];
+  }
+};
+
+/**
+ * @brief The xorshift32 generator of the device.
+ */
+struct Random {
+  uint32_t state;
+
+  explicit Random(uint32_t seed) : state(seed != 0 ? seed : 0x9E3779B9) {}
+
+  uint32_t next(uint32_t bound) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state % bound;
+  }
+};
+
+/**
+ * @brief Derives the seed of a region from the seed of the maze.
+ * @param seed The seed of the maze.
+ * @param index The index of the region, 0 for the stitching.
+ * @return A well mixed seed.
+ */
+uint32_t regionSeed(uint32_t seed, uint64_t index) {
+  // splitmix64 finalizer
+  uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return (uint32_t)(z ^ (z >> 31));
+}
+
+/**
+ * @brief Carves a region into a perfect maze with the recursive backtracker of the device.
+ * @param maze The maze the region belongs to.
+ * @param region The index of the region, row-major over the regions.
+ * @param seed The seed of the maze.
+ * @param stack Buffer for the backtracking stack, reused between regions.
+ */
+void carveRegion(GiantMaze& maze, int64_t region, uint32_t seed, std::vector<uint32_t>& stack) {
+  int64_t firstRow = region / maze.regionColumns * maze.regionCells;
+  int64_t firstColumn = region % maze.regionColumns * maze.regionCells;
+  int64_t height = std::min(maze.regionCells, maze.cellRows - firstRow);
+  int64_t width = std::min(maze.regionCells, maze.cellColumns - firstColumn);
+  Random random(regionSeed(seed, region + 1));
+
+  // Cells on the stack are indexed within the region, which always fits in 32 bits
+  stack.clear();
+  uint32_t start = random.next(height) * width + random.next(width);
+  maze.cell(firstRow + start / width, firstColumn + start % width) |= VISITED;
+  stack.push_back(start);
+  while (!stack.empty()) {
+    int64_t row = stack.back() / width;
+    int64_t column = stack.back() % width;
+    uint8_t& current = maze.cell(firstRow + row, firstColumn + column);
+
+    // Unvisited neighbors in the order up, right, down, left
+    int64_t neighborRows[4];
+    int64_t neighborColumns[4];
+    int neighborCount = 0;
+    const int64_t directionRows[4] = {-1, 0, 1, 0};
+    const int64_t directionColumns[4] = {0, 1, 0, -1};
+    for (int d = 0; d < 4; d++) {
+      int64_t neighborRow = row + directionRows[d];
+      int64_t neighborColumn = column + directionColumns[d];
+      if (neighborRow >= 0 && neighborRow < height && neighborColumn >= 0 && neighborColumn < width &&
+          !(maze.cell(firstRow + neighborRow, firstColumn + neighborColumn) & VISITED)) {
+        neighborRows[neighborCount] = neighborRow;
+        neighborColumns[neighborCount] = neighborColumn;
+        neighborCount++;
+      }
+    }
+    if (neighborCount == 0) {
+      stack.pop_back();
+      continue;
+    }
+
+    int chosen = random.next(neighborCount);
+    int64_t nextRow = neighborRows[chosen];
+    int64_t nextColumn = neighborColumns[chosen];
+    uint8_t& next = maze.cell(firstRow + nextRow, firstColumn + nextColumn);
+    if (nextRow > row) {
+      current |= OPEN_DOWN;
+    } else if (nextRow < row) {
+      next |= OPEN_DOWN;
+    } else if (nextColumn > column) {
+      current |= OPEN_RIGHT;
+    } else {
+      next |= OPEN_RIGHT;
+    }
+    next |= VISITED;
+    stack.push_back(nextRow * width + nextColumn);
+  }
+}
+
+/**
+ * @brief Joins the regions of a rectangle into one tree by recursive division.
+ * @note Each division opens one passage across its dividing line at a random cell, the two
+ *       halves are then divided in turn until every part is a single region.
+ *
+ * @param maze The maze whose regions are joined.
+ * @param random The generator choosing the divisions.
+ * @param firstRegionRow, firstRegionColumn The first region of the rectangle.
+ * @param endRegionRow, endRegionColumn The region past the last one of the rectangle.
+ */
+void stitchRegions(GiantMaze& maze, Random& random, int64_t firstRegionRow, int64_t firstRegionColumn,
+                   int64_t endRegionRow, int64_t endRegionColumn) {
+  int64_t regionRows = endRegionRow - firstRegionRow;
+  int64_t regionColumns = endRegionColumn - firstRegionColumn;
+  if (regionRows * regionColumns <= 1) {
+    return;
+  }
+
+  int64_t firstRow = firstRegionRow * maze.regionCells;
+  int64_t firstColumn = firstRegionColumn * maze.regionCells;
+  int64_t endRow = std::min(endRegionRow * maze.regionCells, maze.cellRows);
+  int64_t endColumn = std::min(endRegionColumn * maze.regionCells, maze.cellColumns);
+
+  // Divide across the longer side so the parts stay close to square
+  if (regionRows > 1 && (regionColumns == 1 || endRow - firstRow >= endColumn - firstColumn)) {
+    int64_t divider = firstRegionRow + 1 + random.next(regionRows - 1);
+    int64_t column = firstColumn + random.next(endColumn - firstColumn);
+    maze.cell(divider * maze.regionCells - 1, column) |= OPEN_DOWN;
+    stitchRegions(maze, random, firstRegionRow, firstRegionColumn, divider, endRegionColumn);
+    stitchRegions(maze, random, divider, firstRegionColumn, endRegionRow, endRegionColumn);
+  } else {
+    int64_t divider = firstRegionColumn + 1 + random.next(regionColumns - 1);
+    int64_t row = firstRow + random.next(endRow - firstRow);
+    maze.cell(row, divider * maze.regionCells - 1) |= OPEN_RIGHT;
+    stitchRegions(maze, random, firstRegionRow, firstRegionColumn, endRegionRow, divider);
+    stitchRegions(maze, random, firstRegionRow, divider, endRegionRow, endRegionColumn);
+  }
+}
+
+/**
+ * @brief Generates a maze from a seed.
+ * @param maze The maze, with its sizes set.
+ * @param seed The seed of the maze.
+ * @param threadCount The number of threads carving regions.
+ * @return The time spent carving and stitching in seconds.
+ */
+double generate(GiantMaze& maze, uint32_t seed, unsigned threadCount) {
+  maze.cells.assign(maze.cellRows * maze.cellColumns, 0);
+  unsigned long startMicros = micros();
+
+  // Every thread takes the next region until all are carved
+  int64_t regionCount = maze.regionRows * maze.regionColumns;
+  std::atomic<int64_t> nextRegion(0);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < threadCount; t++) {
+    threads.emplace_back([&]() {
+      std::vector<uint32_t> stack;
+      for (int64_t region = nextRegion++; region < regionCount; region = nextRegion++) {
+        carveRegion(maze, region, seed, stack);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  Random random(regionSeed(seed, 0));
+  stitchRegions(maze, random, 0, 0, maze.regionRows, maze.regionColumns);
+  return (micros() - startMicros) / 1e6;
+}
+
+/**
+ * @brief Hashes the cells of a maze (FNV-1a).
+ * @param maze The maze to hash.
+ * @return The hash of the cells.
+ */
+uint64_t hashCells(const GiantMaze& maze) {
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  for (uint8_t cell : maze.cells) {
+    hash = (hash ^ cell) * 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+/**
+ * @brief Checks that the passages of a maze form a spanning tree of its cells.
+ * @param maze The maze to check.
+ * @return Nullptr if the maze is perfect, otherwise the problem found.
+ */
+const char* checkSpanningTree(GiantMaze& maze) {
+  // Union-find with path halving, cells are joined by each passage opened from them
+  std::vector<uint32_t> parent(maze.cells.size());
+  for (size_t i = 0; i < parent.size(); i++) {
+    parent[i] = i;
+  }
+  auto find = [&](uint32_t cell) {
+    while (parent[cell] != cell) {
+      parent[cell] = parent[parent[cell]];
+      cell = parent[cell];
+    }
+    return cell;
+  };
+  int64_t passages = 0;
+  for (int64_t row = 0; row < maze.cellRows; row++) {
+    for (int64_t column = 0; column < maze.cellColumns; column++) {
+      uint8_t cell = maze.cell(row, column);
+      uint32_t index = row * maze.cellColumns + column;
+      for (int d = 0; d < 2; d++) {
+        if (!(cell & (d == 0 ? OPEN_RIGHT : OPEN_DOWN))) {
+          continue;
+        }
+        int64_t neighborRow = row + d;
+        int64_t neighborColumn = column + 1 - d;
+        if (neighborRow >= maze.cellRows || neighborColumn >= maze.cellColumns) {
+          return "passage out of bounds";
+        }
+        uint32_t a = find(index);
+        uint32_t b = find(neighborRow * maze.cellColumns + neighborColumn);
+        if (a == b) {
+          return "loop";
+        }
+        parent[a] = b;
+        passages++;
+      }
+    }
+  }
+  if (passages != (int64_t)maze.cells.size() - 1) {
+    return "not connected";
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Checks if a position with exactly one odd coordinate is a wall.
+ * @param maze The maze.
+ * @param i The row of the position.
+ * @param j The column of the position.
+ * @return True if the position is a wall, false otherwise.
+ */
+bool isWall(GiantMaze& maze, int64_t i, int64_t j) {
+  // The same positions as Maze::getStartPosition and Maze::getEndPosition
+  int64_t endRow = maze.rows - 1;
+  int64_t endColumn = maze.columns - 2;
+  if (maze.rows % 2 == 1 && endColumn % 2 == 0) {
+    endColumn--;
+  }
+  if ((i == 0 && j == 1) || (i == endRow && j == endColumn)) {
+    return false;
+  }
+  if (i % 2 == 1) {
+    // A wall between two cells of a row, or the left or right border
+    return j == 0 || j / 2 >= maze.cellColumns || !(maze.cell(i / 2, j / 2 - 1) & OPEN_RIGHT);
+  }
+  // A wall between two cells of a column, or the top or bottom border
+  return i == 0 || i / 2 >= maze.cellRows || !(maze.cell(i / 2 - 1, j / 2) & OPEN_DOWN);
+}
+
+/**
+ * @brief Writes a maze in the packed format of maze packs.
+ * @note Rows are packed and written one at a time, so the file is never held in memory.
+ *
+ * @param maze The maze to write.
+ * @param output The file to write to.
+ * @return The number of bytes written.
+ */
+int64_t writePacked(GiantMaze& maze, FILE* output) {
+  std::vector<uint8_t> buffer;
+  buffer.reserve(1 << 20);
+  uint8_t byte = 0;
+  int bit = 0;
+  int64_t written = 0;
+  for (int64_t i = 0; i < maze.rows; i++) {
+    for (int64_t j = (i + 1) % 2; j < maze.columns; j += 2) {
+      byte |= isWall(maze, i, j) << bit;
+      if (++bit == 8) {
+        buffer.push_back(byte);
+        byte = 0;
+        bit = 0;
+      }
+    }
+    if (buffer.size() >= (1 << 20) - (size_t)maze.columns / 8 - 1) {
+      written += fwrite(buffer.data(), 1, buffer.size(), output);
+      buffer.clear();
+    }
+  }
+  if (bit > 0) {
+    buffer.push_back(byte);
+  }
+  written += fwrite(buffer.data(), 1, buffer.size(), output);
+  return written;
+}
+
+/**
+ * @brief Writes a maze in the memory-mapped format of MappedMaze.
+ * @param maze The maze to write.
+ * @param outputPath The file to write to.
+ * @param seed The seed of the maze.
+ * @param tileSize Side of a tile in grid positions, 0 to store whole rows.
+ * @return Nullptr on success, otherwise the problem found.
+ */
+const char* writeMapped(GiantMaze& maze, const char* outputPath, uint32_t seed, uint32_t tileSize) {
+  MappedMaze mapped;
+  const char* problem = mapped.create(outputPath, maze.rows, maze.columns, tileSize, seed);
+  if (problem != nullptr) {
+    return problem;
+  }
+  // The file starts with every position open, so only the walls are written
+  for (int64_t i = 0; i < maze.rows; i++) {
+    for (int64_t j = (i + 1) % 2; j < maze.columns; j += 2) {
+      if (isWall(maze, i, j)) {
+        mapped.setWall(i, j, true);
+      }
+    }
+  }
+  return nullptr;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 4) {
+    fprintf(stderr, "Usage: %s <rows> <columns> <output.bin> [-s seed] [-j threads] [-r region cells] [-m tile size] [-b] [-c]\n", argv[0]);
+    return 1;
+  }
+  GiantMaze maze;
+  maze.rows = atoll(argv[1]);
+  maze.columns = atoll(argv[2]);
+  const char* outputPath = argv[3];
+  uint32_t seed = 1;
+  unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+  maze.regionCells = 256;
+  bool isBenchmark = false;
+  bool isChecked = false;
+  int64_t tileSize = -1;
+  for (int i = 4; i < argc; i++) {
+    std::string option = argv[i];
+    if (option == "-s" && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 0);
+    } else if (option == "-j" && i + 1 < argc) {
+      threadCount = std::max(1, atoi(argv[++i]));
+    } else if (option == "-r" && i + 1 < argc) {
+      maze.regionCells = atoll(argv[++i]);
+    } else if (option == "-m" && i + 1 < argc) {
+      tileSize = atoll(argv[++i]);
+    } else if (option == "-b") {
+      isBenchmark = true;
+    } else if (option == "-c") {
+      isChecked = true;
+    } else {
+      fprintf(stderr, "Unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+  maze.cellRows = maze.rows / 2;
+  maze.cellColumns = maze.columns / 2;
+  // Indices within a region and in the union-find of -c are 32-bit
+  if (maze.rows < 3 || maze.columns < 3 || maze.regionCells < 1 || maze.regionCells > 0xFFFF ||
+      maze.cellRows * maze.cellColumns > 0xFFFFFFFFLL || (tileSize >= 0 && tileSize % 16 != 0)) {
+    fprintf(stderr, "Invalid arguments\n");
+    return 1;
+  }
+  maze.regionRows = (maze.cellRows + maze.regionCells - 1) / maze.regionCells;
+  maze.regionColumns = (maze.cellColumns + maze.regionCells - 1) / maze.regionCells;
+  int64_t cellCount = maze.cellRows * maze.cellColumns;
+  fprintf(stderr, "%lldx%lld maze, %lld cells in %lldx%lld regions of %lld cells square, seed %lu\n",
+          (long long)maze.rows, (long long)maze.columns, (long long)cellCount, (long long)maze.regionRows,
+          (long long)maze.regionColumns, (long long)maze.regionCells, (unsigned long)seed);
+
+  if (isBenchmark) {
+    std::vector<unsigned> counts;
+    for (unsigned count = 1; count < threadCount; count *= 2) {
+      counts.push_back(count);
+    }
+    counts.push_back(threadCount);
+    double oneThreadSeconds = 0;
+    uint64_t firstHash = 0;
+    for (unsigned count : counts) {
+      double seconds = generate(maze, seed, count);
+      uint64_t hash = hashCells(maze);
+      if (count == 1) {
+        oneThreadSeconds = seconds;
+        firstHash = hash;
+      }
+      fprintf(stderr, "  %3u threads  %7.2f s  %6.1f Mcells/s  speedup %5.2f  hash %016llx%s\n", count, seconds,
+              cellCount / seconds / 1e6, oneThreadSeconds / seconds, (unsigned long long)hash,
+              hash == firstHash ? "" : "  MISMATCH");
+      if (hash != firstHash) {
+        return 1;
+      }
+    }
+  } else {
+    double seconds = generate(maze, seed, threadCount);
+    fprintf(stderr, "Generated on %u threads in %.2f s (%.1f Mcells/s)\n", threadCount, seconds, cellCount / seconds / 1e6);
+  }
+
+  if (isChecked) {
+    const char* problem = checkSpanningTree(maze);
+    if (problem != nullptr) {
+      fprintf(stderr, "Check failed: %s\n", problem);
+      return 1;
+    }
+    fprintf(stderr, "Checked: every cell is connected without loops\n");
+  }
+
+  unsigned long startMicros = micros();
+  if (tileSize >= 0) {
+    const char* problem = writeMapped(maze, outputPath, seed, tileSize);
+    if (problem != nullptr) {
+      fprintf(stderr, "Cannot write %s: %s\n", outputPath, problem);
+      return 1;
+    }
+    fprintf(stderr, "Wrote %s in the mapped format in %.2f s\n", outputPath, (micros() - startMicros) / 1e6);
+    return 0;
+  }
+  FILE* output = fopen(outputPath, "wb");
+  if (output == nullptr) {
+    fprintf(stderr, "Cannot open %s\n", outputPath);
+    return 1;
+  }
+  int64_t written = writePacked(maze, output);
+  fclose(output);
+  fprintf(stderr, "Wrote %lld bytes to %s in %.2f s\n", (long long)written, outputPath, (micros() - startMicros) / 1e6);
+  return 0;
+}
@@ -0,0 +1,146 @@
+// Opens a huge maze written by mazegiant -m and answers queries straight from the mapped file.
+//
+// The file is mapped, not read, so opening takes the same time whatever its size. Each query
+// reports the page faults it caused, for viewports the pages of the file they touched:
+//   - a viewport, printed with the characters of Maze::printToSerial, of 8x8 positions by
+//     default, like the LED matrix
+//   - with -n, that many viewports at random positions, timed, with the pages of the file
+//     each one reads. Fault counts would hide them once the file is cached, since the kernel
+//     maps the cached neighbours of a faulting page along with it
+//   - with -p, the path from the start to the end, found by following the right wall
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -Itools/host -Ilib/Maze/src -o mazemap tools/mazemap/mazemap.cpp
+//   ./mazemap maze.map [-v row column rows columns] [-n viewports] [-p]
+
+#include <Arduino.h>
+#include <MappedMaze.hpp>
+#include <algorithm>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+/**
+ * @brief Counts the page faults of the process so far.
+ * @return Minor and major page faults.
+ */
+long pageFaults() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt + usage.ru_majflt;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <maze.map> [-v row column rows columns] [-n viewports] [-p]\n", argv[0]);
+    return 1;
+  }
+  int64_t viewRow = 0;
+  int64_t viewColumn = 0;
+  int viewRows = 8;
+  int viewColumns = 8;
+  long viewportCount = 0;
+  bool isSolved = false;
+  for (int i = 2; i < argc; i++) {
+    std::string option = argv[i];
+    if (option == "-v" && i + 4 < argc) {
+      viewRow = atoll(argv[++i]);
+      viewColumn = atoll(argv[++i]);
+      viewRows = atoi(argv[++i]);
+      viewColumns = atoi(argv[++i]);
+    } else if (option == "-n" && i + 1 < argc) {
+      viewportCount = atol(argv[++i]);
+    } else if (option == "-p") {
+      isSolved = true;
+    } else {
+      fprintf(stderr, "Unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (viewRows < 1 || viewColumns < 1) {
+    fprintf(stderr, "Invalid arguments\n");
+    return 1;
+  }
+
+  MappedMaze maze;
+  long faults = pageFaults();
+  unsigned long startMicros = micros();
+  const char* problem = maze.open(argv[1]);
+  if (problem != nullptr) {
+    fprintf(stderr, "Cannot open %s: %s\n", argv[1], problem);
+    return 1;
+  }
+  printf("Opened %lldx%lld maze, seed %lu, %s, %.1f MB in %lu us, %ld page faults\n", (long long)maze.getRows(),
+         (long long)maze.getColumns(), (unsigned long)maze.getSeed(),
+         maze.getTileSize() > 0 ? (std::to_string(maze.getTileSize()) + " position tiles").c_str() : "untiled rows",
+         maze.getFileBytes() / 1e6, micros() - startMicros, pageFaults() - faults);
+
+  // The viewport, one row per pointer like the sub-maze of the sketch
+  std::vector<uint8_t> window(viewRows * viewColumns);
+  std::vector<uint8_t*> subMaze(viewRows);
+  for (int i = 0; i < viewRows; i++) {
+    subMaze[i] = &window[i * viewColumns];
+  }
+  faults = pageFaults();
+  maze.getSubMaze(viewRow, viewColumn, viewRows, viewColumns, subMaze.data());
+  printf("Viewport %dx%d at %lld,%lld, %ld page faults\n", viewRows, viewColumns, (long long)viewRow,
+         (long long)viewColumn, pageFaults() - faults);
+  for (int i = 0; i < viewRows; i++) {
+    for (int j = 0; j < viewColumns; j++) {
+      uint8_t cell = subMaze[i][j];
+      putchar(cell == WALL ? '#' : cell == START ? 'S' : cell == END ? 'E' : ' ');
+    }
+    putchar('\n');
+  }
+
+  if (viewportCount > 0) {
+    uint32_t randomState = 0x9E3779B9;
+    auto nextRandom = [&](int64_t bound) {
+      randomState ^= randomState << 13;
+      randomState ^= randomState >> 17;
+      randomState ^= randomState << 5;
+      return (int64_t)(((uint64_t)randomState << 32 | randomState) % (uint64_t)bound);
+    };
+    std::vector<MappedPosition> corners(viewportCount);
+    for (MappedPosition& corner : corners) {
+      corner.row = nextRandom(maze.getRows());
+      corner.column = nextRandom(maze.getColumns());
+    }
+    startMicros = micros();
+    for (const MappedPosition& corner : corners) {
+      maze.getSubMaze(corner.row, corner.column, viewRows, viewColumns, subMaze.data());
+    }
+    unsigned long elapsed = micros() - startMicros;
+
+    // The distinct pages holding the stored positions of each viewport
+    long pages = 0;
+    std::vector<uint64_t> viewportPages;
+    for (const MappedPosition& corner : corners) {
+      viewportPages.clear();
+      for (int64_t row = corner.row; row < std::min(corner.row + viewRows, maze.getRows()); row++) {
+        for (int64_t column = corner.column; column < std::min(corner.column + viewColumns, maze.getColumns()); column++) {
+          if ((row & 1) != (column & 1)) {
+            viewportPages.push_back(maze.getByteOffset(row, column) / MappedMaze::PAGE_BYTES);
+          }
+        }
+      }
+      std::sort(viewportPages.begin(), viewportPages.end());
+      pages += std::unique(viewportPages.begin(), viewportPages.end()) - viewportPages.begin();
+    }
+    printf("%ld random viewports in %.2f s, %.2f us and %.2f pages read per viewport\n", viewportCount, elapsed / 1e6,
+           (double)elapsed / viewportCount, (double)pages / viewportCount);
+  }
+
+  if (isSolved) {
+    std::vector<uint8_t> moves;
+    faults = pageFaults();
+    startMicros = micros();
+    bool isReached = maze.solve(moves);
+    printf("%s in %zu moves, found in %.2f s with %ld page faults\n", isReached ? "Solved" : "No path to the end",
+           moves.size(), (micros() - startMicros) / 1e6, pageFaults() - faults);
+    if (!isReached) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Generates, scores and packs mazes into a header that stores them in flash (PROGMEM).
+//
+// Candidates are generated from consecutive seeds on all cores, scored by the length
+// of their solution and their number of dead ends, and `count` of them are picked at
+// evenly spaced difficulties, so the pack plays from the easiest to the hardest maze.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -pthread -Itools/host -Ilib/Maze/src -Ilib/MazeBitboard/src -Ilib/Crc8/src -o mazepack
+//       tools/mazepack/mazepack.cpp lib/Maze/src/Maze.cpp lib/Maze/src/TileCache.cpp
+//       lib/MazeBitboard/src/MazeBitboard.cpp lib/Crc8/src/Crc8.cpp
+//   ./mazepack 16 16 100000 32 include/MazePack.h
+
+#include <Arduino.h>
+#include <Maze.hpp>
+#include <MazeStats.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+struct ScoredMaze {
+  uint32_t seed;
+  int solutionLength;
+  int deadEnds;
+  std::vector<uint8_t> packed;
+};
+
+int main(int argc, char** argv) {
+  if (argc < 6) {
+    fprintf(stderr, "Usage: %s <rows> <columns> <candidates> <count> <output.h> [first seed]\n", argv[0]);
+    return 1;
+  }
+  int rows = atoi(argv[1]);
+  int columns = atoi(argv[2]);
+  long candidates = atol(argv[3]);
+  int count = atoi(argv[4]);
+  const char* outputPath = argv[5];
+  uint32_t firstSeed = argc > 6 ? strtoul(argv[6], nullptr, 0) : 1;
+  if (rows < 3 || columns < 3 || count < 1 || candidates < count) {
+    fprintf(stderr, "Invalid arguments\n");
+    return 1;
+  }
+
+  // Every thread takes the next candidate until all are scored
+  std::vector<ScoredMaze> scored(candidates);
+  std::atomic<long> nextCandidate(0);
+  unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+  unsigned long startMicros = micros();
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < threadCount; t++) {
+    threads.emplace_back([&]() {
+      Maze maze(rows, columns);
+      for (long i = nextCandidate++; i < candidates; i = nextCandidate++) {
+        ScoredMaze& entry = scored[i];
+        entry.seed = firstSeed + i;
+        maze.generateMaze(entry.seed);
+        entry.solutionLength = solutionLength(maze);
+        entry.deadEnds = countDeadEnds(maze);
+        entry.packed.resize(maze.getPackedSize());
+        maze.pack(entry.packed.data());
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  double seconds = (micros() - startMicros) / 1e6;
+  fprintf(stderr, "Scored %ld mazes on %u threads in %.2f s (%.0f mazes/s)\n", candidates, threadCount, seconds, candidates / seconds);
+
+  // Longer solutions with more dead ends to explore are harder
+  std::sort(scored.begin(), scored.end(), [](const ScoredMaze& a, const ScoredMaze& b) {
+    if (a.solutionLength != b.solutionLength) {
+      return a.solutionLength < b.solutionLength;
+    }
+    return a.deadEnds < b.deadEnds;
+  });
+  std::vector<const ScoredMaze*> picked;
+  for (int i = 0; i < count; i++) {
+    picked.push_back(&scored[count > 1 ? (long)i * (candidates - 1) / (count - 1) : candidates / 2]);
+  }
+
+  FILE* output = fopen(outputPath, "w");
+  if (output == nullptr) {
+    fprintf(stderr, "Cannot open %s\n", outputPath);
+    return 1;
+  }
+  size_t packedSize = picked[0]->packed.size();
+  fprintf(output, "// Generated by tools/mazepack, do not edit.\n");
+  fprintf(output, "// %d mazes of %dx%d picked from %ld candidates, ordered from easiest to hardest.\n", count, rows, columns, candidates);
+  fprintf(output, "#include <Arduino.h>\n#ifndef MAZE_PACK_H\n#define MAZE_PACK_H\n\n");
+  fprintf(output, "const int MAZE_PACK_ROWS = %d;\n", rows);
+  fprintf(output, "const int MAZE_PACK_COLUMNS = %d;\n", columns);
+  fprintf(output, "const int MAZE_PACK_COUNT = %d;\n", count);
+  fprintf(output, "const int MAZE_PACK_MAZE_BYTES = %zu;\n\n", packedSize);
+  fprintf(output, "// Seed and solution length of each maze\n");
+  fprintf(output, "const uint32_t MAZE_PACK_SEEDS[MAZE_PACK_COUNT] PROGMEM = {");
+  for (int i = 0; i < count; i++) {
+    fprintf(output, "%s%lu", i % 8 == 0 ? "\n  " : " ", (unsigned long)picked[i]->seed);
+    fprintf(output, i < count - 1 ? "," : "\n");
+  }
+  fprintf(output, "};\n");
+  fprintf(output, "const uint16_t MAZE_PACK_SOLUTION_LENGTHS[MAZE_PACK_COUNT] PROGMEM = {");
+  for (int i = 0; i < count; i++) {
+    fprintf(output, "%s%d", i % 16 == 0 ? "\n  " : " ", picked[i]->solutionLength);
+    fprintf(output, i < count - 1 ? "," : "\n");
+  }
+  fprintf(output, "};\n\n");
+  fprintf(output, "// Packed mazes, see Maze::getPackedSize for the format\n");
+  fprintf(output, "const uint8_t MAZE_PACK[MAZE_PACK_COUNT][MAZE_PACK_MAZE_BYTES] PROGMEM = {\n");
+  for (int i = 0; i < count; i++) {
+    fprintf(output, "  {");
+    for (size_t j = 0; j < packedSize; j++) {
+      fprintf(output, "0x%02X%s", picked[i]->packed[j], j < packedSize - 1 ? ", " : "");
+    }
+    fprintf(output, "}%s\n", i < count - 1 ? "," : "");
+  }
+  fprintf(output, "};\n\n#endif\n");
+  fclose(output);
+
+  fprintf(stderr, "Wrote %d mazes (%zu bytes of flash) to %s, solution lengths %d to %d\n",
+          count, count * (packedSize + 6), outputPath, picked.front()->solutionLength, picked.back()->solutionLength);
+  return 0;
+}
@@ -0,0 +1,329 @@
+// Replays the input recordings of the game on a host computer, as fast as possible, and checks
+// that the replay does what the device did.
+//
+// The game itself, src/main.cpp, is built for the host with the stand-ins of tools/host for the
+// LED matrix and the nunchuk. Each recorded maze restarts the game from the seed, settings and
+// timing state it started with, then every recorded frame is run at its recorded time on a
+// virtual clock, with the recorded nunchuk sample. The replay is recorded like the device was,
+// and the first record that differs, such as a poll at another time or a move the device did
+// not make, is reported as a divergence. The frames replayed per second and the speedup over
+// the recorded play time are printed.
+//
+// The recording is read from a serial log holding the output of the rec command, or of a
+// completed maze, the last one in the log is used. Build with the gameplay options the device
+// was built with, -DCHASING_ENEMY if it had the enemy for example, except TILT_CONTROL: the tilt
+// was recorded as the joystick readings it turned into.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -DINPUT_RECORDING -Itools/host -Iinclude
+//       $(for d in lib/*/src; do printf -- '-I%s ' $d; done) -o mazereplay
+//       tools/mazereplay/mazereplay.cpp src/main.cpp lib/*/src/*.cpp
+//   ./mazereplay serial.log [-n repeats] [-v]
+// With -n the recording is replayed several times for steadier timings, -v shows the output
+// of the game. The exit code is 1 if no recording was found or the replay diverged.
+
+#include <Arduino.h>
+#include <InputRecorder.hpp>
+#include <NintendoExtensionCtrl.h>
+#include <chrono>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// The sketch, built along with this tool
+void setup();
+void loop();
+void restoreRecording(const RecordingStart& start);
+extern Maze maze;
+extern bool isRegenerating;
+extern Nunchuk nunchuck;
+extern InputRecorder recorder;
+
+static const long MAX_FRAMES_PER_RECORD = 100000; // Frames run at one time before a switch to a new maze is given up
+
+struct Segment {
+  RecordingStart start;
+  std::vector<InputRecord> records; // The records after the start
+};
+
+struct ReplayStats {
+  long frames = 0;
+  long records = 0;
+  uint64_t recordedMillis = 0;
+};
+
+/**
+ * @brief Reads the last recording printed by InputRecorder::dump from a serial log.
+ * @param file The log.
+ * @param data Set to the bytes of the recording.
+ * @return True if a complete recording was found, false otherwise.
+ */
+static bool readRecording(FILE* file, std::vector<uint8_t>& data) {
+  std::vector<uint8_t> current;
+  bool isInRecording = false;
+  bool isFound = false;
+  std::string line;
+  int character;
+  do {
+    character = fgetc(file);
+    if (character != EOF && character != '\n') {
+      if (character != '\r') {
+        line += (char)character;
+      }
+      continue;
+    }
+    // Other output, such as FrameStream frames, may come before the recording on its first line
+    if (line.find("Input recording,") != std::string::npos) {
+      current.clear();
+      isInRecording = true;
+    } else if (line.find("End of input recording") != std::string::npos) {
+      if (isInRecording) {
+        data = current;
+        isFound = true;
+      }
+      isInRecording = false;
+    } else if (isInRecording) {
+      for (size_t i = 0; i + 1 < line.size(); i += 2) {
+        current.push_back(strtol(line.substr(i, 2).c_str(), nullptr, 16));
+      }
+    }
+    line.clear();
+  } while (character != EOF);
+  return isFound;
+}
+
+/**
+ * @brief Splits a recording into its mazes.
+ * @param data The bytes of the recording.
+ * @param segments Set to the mazes.
+ * @return True if the whole recording was decoded, false if it is corrupt.
+ */
+static bool readSegments(const std::vector<uint8_t>& data, std::vector<Segment>& segments) {
+  InputRecordReader reader(data.data(), data.size());
+  InputRecord record;
+  while (reader.next(record)) {
+    if (record.type == INPUT_RECORD_START) {
+      segments.push_back(Segment());
+      segments.back().start = record.start;
+    } else if (!segments.empty()) {
+      segments.back().records.push_back(record);
+    }
+  }
+  return !reader.isCorrupt();
+}
+
+/**
+ * @brief Describes a record for a divergence report.
+ * @param record The record.
+ * @return The description.
+ */
+static std::string describe(const InputRecord& record) {
+  char text[96];
+  switch (record.type) {
+    case INPUT_RECORD_SAMPLE:
+      snprintf(text, sizeof(text), "poll of (%d, %d)%s%s", record.sample.joyX, record.sample.joyY,
+               record.sample.buttonC ? " C" : "", record.sample.buttonZ ? " Z" : "");
+      break;
+    case INPUT_RECORD_LOST:
+      snprintf(text, sizeof(text), "failed poll");
+      break;
+    case INPUT_RECORD_POSITION:
+      snprintf(text, sizeof(text), "player at (%d, %d)", record.position.row, record.position.column);
+      break;
+    case INPUT_RECORD_TICK:
+      snprintf(text, sizeof(text), "enemy move");
+      break;
+    case INPUT_RECORD_SETTLED:
+      snprintf(text, sizeof(text), "new maze ready");
+      break;
+    default:
+      snprintf(text, sizeof(text), "new maze");
+      break;
+  }
+  return std::string(text) + " at " + std::to_string(record.time) + " ms";
+}
+
+/**
+ * @brief Tells whether two records are the same.
+ * @param first The first record.
+ * @param second The second record.
+ * @return True if they are the same, false otherwise.
+ */
+static bool isSameRecord(const InputRecord& first, const InputRecord& second) {
+  if (first.type != second.type || first.time != second.time) {
+    return false;
+  }
+  if (first.type == INPUT_RECORD_SAMPLE) {
+    return first.sample.joyX == second.sample.joyX && first.sample.joyY == second.sample.joyY &&
+           first.sample.buttonC == second.sample.buttonC && first.sample.buttonZ == second.sample.buttonZ;
+  }
+  if (first.type == INPUT_RECORD_POSITION) {
+    return first.position.row == second.position.row && first.position.column == second.position.column;
+  }
+  return true;
+}
+
+/**
+ * @brief Moves what the game recorded of the replay so far to a stream.
+ * @param stream The stream of the maze being replayed.
+ */
+static void drainReplay(std::vector<uint8_t>& stream) {
+  static std::vector<uint8_t> buffer(recorder.getRAMBytes());
+  int length = recorder.drain(buffer.data());
+  stream.insert(stream.end(), buffer.begin(), buffer.begin() + length);
+}
+
+/**
+ * @brief Runs a recorded frame, with as many frames at the same time as a maze switch needs.
+ * @param records The records of the frame, all with the same time.
+ * @return The number of frames run.
+ */
+static long runFrame(const std::vector<InputRecord>& records) {
+  setHostMillis(records[0].time);
+  bool isSettled = false;
+  for (const InputRecord& record : records) {
+    if (record.type == INPUT_RECORD_SAMPLE) {
+      nunchuck.setNextReading(record.sample.joyX, record.sample.joyY, record.sample.buttonC, record.sample.buttonZ);
+    } else if (record.type == INPUT_RECORD_LOST) {
+      nunchuck.setNextReading(128, 128, false, false, false);
+    } else if (record.type == INPUT_RECORD_SETTLED) {
+      isSettled = true;
+    }
+  }
+
+  // The device ran the frames that generate and save a new maze before this time, the
+  // replay runs them now since they change nothing that depends on time
+  long frames = 0;
+  do {
+    loop();
+    frames++;
+  } while ((maze.isGenerating() || (isSettled && isRegenerating)) && frames < MAX_FRAMES_PER_RECORD);
+  return frames;
+}
+
+/**
+ * @brief Replays a maze and compares the replay with the recording.
+ * @param segment The recorded maze.
+ * @param stats Updated with the frames and records replayed.
+ * @param report Where a divergence is reported.
+ * @return True if the replay matches the recording, false otherwise.
+ */
+static bool replaySegment(const Segment& segment, ReplayStats& stats, FILE* report) {
+  const RecordingStart& start = segment.start;
+  setHostMillis(start.time);
+  nunchuck.setReading(start.sample.joyX, start.sample.joyY, start.sample.buttonC, start.sample.buttonZ);
+  std::vector<uint8_t> stream;
+  drainReplay(stream);
+  stream.clear();
+  restoreRecording(start);
+
+  // Frames are told apart by their time
+  const std::vector<InputRecord>& records = segment.records;
+  for (size_t first = 0; first < records.size();) {
+    size_t last = first;
+    while (last + 1 < records.size() && records[last + 1].time == records[first].time) {
+      last++;
+    }
+    stats.frames += runFrame(std::vector<InputRecord>(records.begin() + first, records.begin() + last + 1));
+    first = last + 1;
+  }
+  drainReplay(stream);
+  stats.records += records.size();
+  if (!records.empty()) {
+    stats.recordedMillis += records.back().time - start.time;
+  }
+
+  // What follows the next start belongs to the maze the game switched to, which the next recording replaces
+  std::vector<InputRecord> replayed;
+  InputRecordReader reader(stream.data(), stream.size());
+  InputRecord record;
+  int starts = 0;
+  while (reader.next(record) && (record.type != INPUT_RECORD_START || ++starts == 1)) {
+    if (record.type != INPUT_RECORD_START) {
+      replayed.push_back(record);
+    }
+  }
+
+  // A truncated recording may end within a frame, the rest of it is only in the replay
+  size_t compared = start.isTruncated ? min(records.size(), replayed.size()) : max(records.size(), replayed.size());
+  for (size_t i = 0; i < compared; i++) {
+    if (i >= records.size() || i >= replayed.size() || !isSameRecord(records[i], replayed[i])) {
+      fprintf(report, "Diverged in the maze of seed %lu: recorded %s, replayed %s\n", (unsigned long)start.seed,
+              i < records.size() ? describe(records[i]).c_str() : "nothing more",
+              i < replayed.size() ? describe(replayed[i]).c_str() : "nothing more");
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  long repeats = 1;
+  bool isVerbose = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      repeats = max(atol(argv[++i]), 1L);
+    } else if (strcmp(argv[i], "-v") == 0) {
+      isVerbose = true;
+    } else if (path == nullptr && argv[i][0] != '-') {
+      path = argv[i];
+    } else {
+      fprintf(stderr, "Usage: %s <serial log> [-n repeats] [-v]\n", argv[0]);
+      return 1;
+    }
+  }
+  FILE* file = path != nullptr ? fopen(path, "r") : stdin;
+  if (file == nullptr) {
+    perror(path);
+    return 1;
+  }
+  std::vector<uint8_t> data;
+  if (!readRecording(file, data)) {
+    fprintf(stderr, "No input recording found\n");
+    return 1;
+  }
+  std::vector<Segment> segments;
+  if (!readSegments(data, segments)) {
+    fprintf(stderr, "The input recording is corrupt, replaying the part before the error\n");
+  }
+  if (segments.empty()) {
+    fprintf(stderr, "The input recording holds no maze\n");
+    return 1;
+  }
+
+  // The game prints to stdout, which is kept for the report unless its output is wanted
+  FILE* report = stdout;
+  if (!isVerbose) {
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    if (freopen("/dev/null", "w", stdout) == nullptr) {
+      return 1;
+    }
+  }
+
+  setHostMillis(0);
+  setup();
+  ReplayStats stats;
+  bool isDiverged = false;
+  auto startTime = std::chrono::steady_clock::now();
+  for (long n = 0; n < repeats && !isDiverged; n++) {
+    for (size_t i = 0; i < segments.size() && !isDiverged; i++) {
+      isDiverged = !replaySegment(segments[i], stats, report);
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+  for (const Segment& segment : segments) {
+    if (segment.start.isTruncated) {
+      fprintf(report, "The maze of seed %lu outgrew the ring on the device, its end was not recorded\n",
+              (unsigned long)segment.start.seed);
+    }
+  }
+  fprintf(report, "Replayed %zu mazes%s, %ld records, %ld frames in %.2f ms: %.0f frames/s, %.1f s of play at %.0fx real time\n",
+          segments.size(), repeats > 1 ? (" " + std::to_string(repeats) + " times").c_str() : "", stats.records,
+          stats.frames, seconds * 1000, stats.frames / seconds, stats.recordedMillis / 1000.0,
+          stats.recordedMillis / 1000.0 / seconds);
+  fprintf(report, isDiverged ? "The replay diverged from the recording\n" : "The replay matches the recording\n");
+  fflush(report);
+  return isDiverged ? 1 : 0;
+}
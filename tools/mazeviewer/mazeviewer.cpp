@@ -0,0 +1,251 @@
+// Shows a game streamed with FrameStream, decoding its binary frames from a serial port or a file.
+//
+// The maze is drawn once it has been received with a valid checksum, and redrawn with the
+// player after every move. Bytes outside frames, such as log messages, are printed below the
+// maze. Frames with a bad CRC are skipped and counted, the decoder then looks for the next
+// sync byte. With -p every update is printed below the previous one instead of redrawing the
+// terminal, which suits logs and pipes.
+//
+// Any byte stream works as input: a serial port, which is switched to raw mode at the given
+// baud rate, a capture file, a named pipe or a pty. With no path stdin is read.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -Itools/host -Ilib/Maze/src -Ilib/FrameStream/src -Ilib/Crc8/src -o mazeviewer
+//       tools/mazeviewer/mazeviewer.cpp lib/FrameStream/src/FrameStream.cpp lib/Crc8/src/Crc8.cpp
+//       lib/Maze/src/Maze.cpp lib/Maze/src/TileCache.cpp
+//   ./mazeviewer /dev/ttyUSB0 [-b 115200] [-p]
+//   ./mazeviewer capture.bin -p
+
+#include <Arduino.h>
+#include <Crc8.hpp>
+#include <FrameStream.hpp>
+#include <fcntl.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+
+struct ViewerState {
+  int rows = 0;
+  int columns = 0;
+  uint32_t seed = 0;
+  MazePosition start = {0, 0};
+  MazePosition end = {0, 0};
+  MazePosition player = {-1, -1};
+  std::vector<uint8_t> walls;
+  std::vector<bool> isRowReceived;
+  uint8_t rowsCrc = 0;
+  bool isMazeValid = false;
+  std::string text; // Bytes outside frames since the last redraw
+  long frames = 0;
+  long badFrames = 0;
+  long bytes = 0;
+  long playerFrames = 0;
+  long playerBytes = 0;
+  long goals = 0;
+};
+
+/**
+ * @brief Switches a serial port to raw mode at a baud rate.
+ * @param fd The open serial port.
+ * @param baud The baud rate, one of the standard rates.
+ * @return True if the port was configured, false otherwise.
+ */
+static bool configureSerialPort(int fd, long baud) {
+  static const long rates[] = {9600, 19200, 38400, 57600, 115200, 230400};
+  static const speed_t speeds[] = {B9600, B19200, B38400, B57600, B115200, B230400};
+  termios settings;
+  if (tcgetattr(fd, &settings) != 0) {
+    return false;
+  }
+  cfmakeraw(&settings);
+  for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+    if (rates[i] == baud) {
+      cfsetispeed(&settings, speeds[i]);
+      cfsetospeed(&settings, speeds[i]);
+      return tcsetattr(fd, TCSANOW, &settings) == 0;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Draws the maze with the player, then the text received since the last update.
+ * @param state The decoded state.
+ * @param isPlain True to print below the previous update, false to redraw the terminal.
+ */
+static void draw(ViewerState& state, bool isPlain) {
+  if (!isPlain) {
+    printf("\x1b[H\x1b[2J");
+  }
+  if (state.isMazeValid) {
+    for (int i = 0; i < state.rows; i++) {
+      for (int j = 0; j < state.columns; j++) {
+        char symbol = state.walls[i * state.columns + j] ? '#' : ' ';
+        if (i == state.start.row && j == state.start.column) {
+          symbol = 'S';
+        } else if (i == state.end.row && j == state.end.column) {
+          symbol = 'E';
+        }
+        if (i == state.player.row && j == state.player.column) {
+          symbol = 'P';
+        }
+        putchar(symbol);
+      }
+      putchar('\n');
+    }
+  }
+  printf("Seed %lu, player at (%d, %d), %ld frames, %ld bad, %ld bytes, %.1f bytes per move, %ld goals\n",
+         (unsigned long)state.seed, state.player.row, state.player.column, state.frames, state.badFrames, state.bytes,
+         state.playerFrames > 0 ? (double)state.playerBytes / state.playerFrames : 0.0, state.goals);
+  if (!state.text.empty()) {
+    printf("%s", state.text.c_str());
+    if (state.text.back() != '\n') {
+      putchar('\n');
+    }
+    state.text.clear();
+  }
+  fflush(stdout);
+}
+
+/**
+ * @brief Applies a frame with a valid CRC to the state.
+ * @param state The decoded state.
+ * @param type The type of the frame.
+ * @param payload The payload of the frame.
+ * @param length The length of the payload.
+ * @return True if the frame changes what is drawn, false otherwise.
+ */
+static bool applyFrame(ViewerState& state, uint8_t type, const uint8_t* payload, uint8_t length) {
+  switch (type) {
+    case FRAME_MAZE_START:
+      if (length < 10) {
+        return false;
+      }
+      state.rows = payload[0];
+      state.columns = payload[1];
+      state.seed = payload[2] | (payload[3] << 8) | (payload[4] << 16) | ((uint32_t)payload[5] << 24);
+      state.start = {payload[6], payload[7]};
+      state.end = {payload[8], payload[9]};
+      state.player = state.start;
+      state.walls.assign(state.rows * state.columns, 1);
+      state.isRowReceived.assign(state.rows, false);
+      state.rowsCrc = 0;
+      state.isMazeValid = false;
+      return false;
+    case FRAME_MAZE_ROW: {
+      int row = payload[0];
+      if (length != 1 + (state.columns + 7) / 8 || row >= state.rows) {
+        return false;
+      }
+      for (int j = 0; j < state.columns; j++) {
+        state.walls[row * state.columns + j] = (payload[1 + j / 8] >> (j % 8)) & 1;
+      }
+      state.isRowReceived[row] = true;
+      state.rowsCrc = crc8(state.rowsCrc, payload, length);
+      return false;
+    }
+    case FRAME_MAZE_END: {
+      bool isComplete = length == 1 && state.rows > 0;
+      for (int i = 0; i < state.rows; i++) {
+        isComplete = isComplete && state.isRowReceived[i];
+      }
+      state.isMazeValid = isComplete && payload[0] == state.rowsCrc;
+      if (!state.isMazeValid) {
+        state.text += "Maze lost or corrupt, waiting for the next one\n";
+      }
+      return true;
+    }
+    case FRAME_PLAYER:
+      if (length != 2) {
+        return false;
+      }
+      state.player = {payload[0], payload[1]};
+      state.playerFrames++;
+      state.playerBytes += FrameStream::HEADER_BYTES + length + 1;
+      return true;
+    case FRAME_GOAL:
+      if (length != 4) {
+        return false;
+      }
+      state.goals++;
+      state.text += "Goal reached in " + std::to_string(payload[0] | (payload[1] << 8)) + " moves and " +
+                    std::to_string(payload[2] | (payload[3] << 8)) + " seconds\n";
+      return true;
+    default:
+      return false;
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  long baud = 115200;
+  bool isPlain = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      baud = atol(argv[++i]);
+    } else if (strcmp(argv[i], "-p") == 0) {
+      isPlain = true;
+    } else if (path == nullptr && argv[i][0] != '-') {
+      path = argv[i];
+    } else {
+      fprintf(stderr, "Usage: %s [serial port or file] [-b baud] [-p]\n", argv[0]);
+      return 1;
+    }
+  }
+  int fd = path != nullptr ? open(path, O_RDONLY | O_NOCTTY) : STDIN_FILENO;
+  if (fd < 0) {
+    perror(path);
+    return 1;
+  }
+  if (isatty(fd) && path != nullptr && !configureSerialPort(fd, baud)) {
+    fprintf(stderr, "Could not configure %s at %ld baud\n", path, baud);
+    return 1;
+  }
+
+  // Frames are found by their sync byte and confirmed by their CRC, anything else is text
+  ViewerState state;
+  std::vector<uint8_t> pending;
+  uint8_t buffer[256];
+  ssize_t count;
+  while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+    pending.insert(pending.end(), buffer, buffer + count);
+    state.bytes += count;
+    size_t next = 0;
+    bool isChanged = false;
+    while (next < pending.size()) {
+      if (pending[next] != FrameStream::FRAME_SYNC) {
+        state.text += (char)pending[next++];
+        continue;
+      }
+      if (pending.size() - next < FrameStream::HEADER_BYTES) {
+        break;
+      }
+      uint8_t type = pending[next + 1];
+      uint8_t length = pending[next + 2];
+      size_t frameLength = FrameStream::HEADER_BYTES + length + 1;
+      if (length > FrameStream::MAX_PAYLOAD_BYTES) {
+        state.text += (char)pending[next++];
+        continue;
+      }
+      if (pending.size() - next < frameLength) {
+        break;
+      }
+      const uint8_t* frame = &pending[next];
+      if (crc8(0, frame + 1, length + 2) != frame[frameLength - 1]) {
+        state.badFrames++;
+        state.text += (char)pending[next++];
+        continue;
+      }
+      state.frames++;
+      isChanged |= applyFrame(state, type, frame + FrameStream::HEADER_BYTES, length);
+      next += frameLength;
+    }
+    pending.erase(pending.begin(), pending.begin() + next);
+    if (isChanged) {
+      draw(state, isPlain);
+    }
+  }
+  draw(state, isPlain);
+  return 0;
+}